@@ -1,4 +1,16 @@
+#include "lesomnus/channel/byte_channel.hpp"
 #include "lesomnus/channel/chan.hpp"
 #include "lesomnus/channel/channel.hpp"
+#include "lesomnus/channel/dynamic_select.hpp"
 #include "lesomnus/channel/error.hpp"
+#include "lesomnus/channel/execution.hpp"
+#include "lesomnus/channel/executor.hpp"
+#include "lesomnus/channel/merge.hpp"
+#include "lesomnus/channel/partitioned_channel.hpp"
+#include "lesomnus/channel/pipeline.hpp"
 #include "lesomnus/channel/select.hpp"
+#include "lesomnus/channel/sharded_channel.hpp"
+#include "lesomnus/channel/thread_pool.hpp"
+#include "lesomnus/channel/ticker.hpp"
+#include "lesomnus/channel/timer.hpp"
+#include "lesomnus/channel/wait_set.hpp"
@@ -0,0 +1,543 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <system_error>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/detail/parker.hpp"
+#include "lesomnus/channel/detail/waiter.hpp"
+#include "lesomnus/channel/error.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+namespace detail {
+
+/**
+ * @brief Storage of a \ref basic_byte_channel allocated on the heap.
+ */
+class heap_ring {
+   public:
+	static constexpr bool is_mirrored = false;
+
+	explicit heap_ring(std::size_t size)
+	    : data_(std::make_unique<std::byte[]>(size))
+	    , size_(size) { }
+
+	[[nodiscard]] std::byte* data() const noexcept {
+		return data_.get();
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return size_;
+	}
+
+   private:
+	std::unique_ptr<std::byte[]> data_;
+	std::size_t                  size_;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Stream of bytes buffered in a fixed size ring, like an in-process pipe.
+ *
+ * The bytes are copied in and out of the ring, so nothing is allocated per message.
+ * Transfers are partial: `*_some` moves as many bytes as possible once at least one can be moved,
+ * while \ref read and \ref write keep going until the whole span is transferred.
+ * As \ref bounded_channel does, the waiting threads are parked, or suspended if they are fibers,
+ * and closing it releases them and discards the buffered bytes.
+ *
+ * For zero-copy framing, \ref read_region and \ref write_region expose the contiguous part of the ring
+ * that is released by \ref consume and \ref commit. While a region is held, no other thread may read or write
+ * on the same side.
+ *
+ * @tparam Storage Ring memory with `data()` and `size()`. If its `is_mirrored` is true,
+ * the ring is mapped twice back-to-back, so the regions never wrap around.
+ */
+template<typename Storage>
+class basic_byte_channel {
+   public:
+	/**
+	 * @param capacity Size of the ring in bytes. The storage may round it up.
+	 * @throws std::invalid_argument If \p capacity is 0.
+	 */
+	explicit basic_byte_channel(std::size_t capacity)
+	    : storage_(capacity)
+	    , buffer_(storage_.data())
+	    , capacity_(storage_.size()) {
+		if(capacity == 0) {
+			throw std::invalid_argument("byte_channel needs a positive capacity");
+		}
+	}
+
+	basic_byte_channel(basic_byte_channel const& other) = delete;
+	basic_byte_channel(basic_byte_channel&& other)      = delete;
+
+	basic_byte_channel& operator=(basic_byte_channel const& other) = delete;
+	basic_byte_channel& operator=(basic_byte_channel&& other)      = delete;
+
+	[[nodiscard]] std::size_t capacity() const noexcept {
+		return capacity_;
+	}
+
+	/**
+	 * @brief Returns the number of the buffered bytes.
+	 */
+	[[nodiscard]] std::size_t size() const {
+		std::scoped_lock l(mutex_);
+		return size_;
+	}
+
+	/**
+	 * @brief Returns the number of the readers waiting for a byte.
+	 */
+	[[nodiscard]] std::size_t num_waiting_readers() const {
+		std::scoped_lock l(mutex_);
+		return readers_.size();
+	}
+
+	/**
+	 * @brief Returns the number of the writers waiting for the room.
+	 */
+	[[nodiscard]] std::size_t num_waiting_writers() const {
+		std::scoped_lock l(mutex_);
+		return writers_.size();
+	}
+
+	void close() {
+		batch_           batch;
+		std::scoped_lock l(mutex_);
+
+		is_closed_ = true;
+		head_      = 0;
+		size_      = 0;
+
+		wake_all_(readers_, batch);
+		wake_all_(writers_, batch);
+	}
+
+	/**
+	 * @brief Copies as many bytes as fit without waiting.
+	 *
+	 * @param[out] ec \a ok if any byte is written or \p data is empty, \a exhausted if the ring is full, or \a closed.
+	 * @return The number of the written bytes.
+	 */
+	std::size_t try_write(std::span<std::byte const> data, std::error_code& ec) {
+		batch_           batch;
+		std::scoped_lock l(mutex_);
+		if(is_closed_) [[unlikely]] {
+			ec = channel_errc::closed;
+			return 0;
+		}
+
+		auto const n = write_(data);
+		ec           = (n > 0 || data.empty()) ? channel_errc::ok : channel_errc::exhausted;
+
+		on_written_(n, batch);
+		return n;
+	}
+
+	/**
+	 * @brief Copies as many bytes as available without waiting.
+	 *
+	 * @param[out] ec \a ok if any byte is read or \p data is empty, \a exhausted if the ring is empty, or \a closed.
+	 * @return The number of the read bytes.
+	 */
+	std::size_t try_read(std::span<std::byte> data, std::error_code& ec) {
+		batch_           batch;
+		std::scoped_lock l(mutex_);
+		if(is_closed_) [[unlikely]] {
+			ec = channel_errc::closed;
+			return 0;
+		}
+
+		auto const n = read_(data);
+		ec           = (n > 0 || data.empty()) ? channel_errc::ok : channel_errc::exhausted;
+
+		on_read_(n, batch);
+		return n;
+	}
+
+	/**
+	 * @brief Waits until the ring has room, then copies as many bytes as fit.
+	 *
+	 * @param[out] ec \a ok, \a closed, or \a canceled if \p token is stop requested.
+	 * @return The number of the written bytes; it is not 0 if \p ec is \a ok and \p data is not empty.
+	 */
+	std::size_t write_some(std::stop_token token, std::span<std::byte const> data, std::error_code& ec) {
+		return write_some_until(std::move(token), std::chrono::steady_clock::time_point::max(), data, ec);
+	}
+
+	/**
+	 * @brief Waits until the ring has room or \p deadline is exceeded, then copies as many bytes as fit.
+	 *
+	 * @param[out] ec \a ok, \a closed, \a timeout, or \a canceled if \p token is stop requested.
+	 * @return The number of the written bytes; it is not 0 if \p ec is \a ok and \p data is not empty.
+	 */
+	std::size_t write_some_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, std::span<std::byte const> data, std::error_code& ec) {
+		batch_           batch;
+		std::unique_lock l(mutex_);
+		if(!wait_(l, writers_, token, deadline, [&] { return size_ < capacity_ || data.empty(); }, ec)) {
+			return 0;
+		}
+
+		auto const n = write_(data);
+		on_written_(n, batch);
+		return n;
+	}
+
+	template<typename Rep, typename Period>
+	std::size_t write_some_for(std::chrono::duration<Rep, Period> const& timeout, std::span<std::byte const> data, std::error_code& ec) {
+		return write_some_until(std::stop_token{}, detail::to_deadline(timeout), data, ec);
+	}
+
+	std::size_t write_some(std::span<std::byte const> data) {
+		std::error_code ec;
+		return write_some(std::stop_token{}, data, ec);
+	}
+
+	/**
+	 * @brief Waits until the ring has a byte, then copies as many bytes as available.
+	 *
+	 * @param[out] ec \a ok, \a closed, or \a canceled if \p token is stop requested.
+	 * @return The number of the read bytes; it is not 0 if \p ec is \a ok and \p data is not empty.
+	 */
+	std::size_t read_some(std::stop_token token, std::span<std::byte> data, std::error_code& ec) {
+		return read_some_until(std::move(token), std::chrono::steady_clock::time_point::max(), data, ec);
+	}
+
+	/**
+	 * @brief Waits until the ring has a byte or \p deadline is exceeded, then copies as many bytes as available.
+	 *
+	 * @param[out] ec \a ok, \a closed, \a timeout, or \a canceled if \p token is stop requested.
+	 * @return The number of the read bytes; it is not 0 if \p ec is \a ok and \p data is not empty.
+	 */
+	std::size_t read_some_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, std::span<std::byte> data, std::error_code& ec) {
+		batch_           batch;
+		std::unique_lock l(mutex_);
+		if(!wait_(l, readers_, token, deadline, [&] { return size_ > 0 || data.empty(); }, ec)) {
+			return 0;
+		}
+
+		auto const n = read_(data);
+		on_read_(n, batch);
+		return n;
+	}
+
+	template<typename Rep, typename Period>
+	std::size_t read_some_for(std::chrono::duration<Rep, Period> const& timeout, std::span<std::byte> data, std::error_code& ec) {
+		return read_some_until(std::stop_token{}, detail::to_deadline(timeout), data, ec);
+	}
+
+	std::size_t read_some(std::span<std::byte> data) {
+		std::error_code ec;
+		return read_some(std::stop_token{}, data, ec);
+	}
+
+	/**
+	 * @brief Writes all the bytes, waiting for the room as many times as needed.
+	 *
+	 * The bytes of concurrent writers may interleave if \p data is larger than the capacity.
+	 *
+	 * @return The number of the written bytes; it is less than the size of \p data only if \p ec is not \a ok.
+	 */
+	std::size_t write(std::stop_token token, std::span<std::byte const> data, std::error_code& ec) {
+		std::size_t n = 0;
+
+		ec = channel_errc::ok;
+		while(n < data.size()) {
+			n += write_some(token, data.subspan(n), ec);
+			if(ec != channel_errc::ok) {
+				break;
+			}
+		}
+
+		return n;
+	}
+
+	/**
+	 * @return False if the channel is closed before all the bytes are written.
+	 */
+	bool write(std::span<std::byte const> data) {
+		std::error_code ec;
+		write(std::stop_token{}, data, ec);
+		return ec == channel_errc::ok;
+	}
+
+	/**
+	 * @brief Reads until \p data is filled, waiting for the bytes as many times as needed.
+	 *
+	 * @return The number of the read bytes; it is less than the size of \p data only if \p ec is not \a ok.
+	 */
+	std::size_t read(std::stop_token token, std::span<std::byte> data, std::error_code& ec) {
+		std::size_t n = 0;
+
+		ec = channel_errc::ok;
+		while(n < data.size()) {
+			n += read_some(token, data.subspan(n), ec);
+			if(ec != channel_errc::ok) {
+				break;
+			}
+		}
+
+		return n;
+	}
+
+	/**
+	 * @return False if the channel is closed before \p data is filled.
+	 */
+	bool read(std::span<std::byte> data) {
+		std::error_code ec;
+		read(std::stop_token{}, data, ec);
+		return ec == channel_errc::ok;
+	}
+
+	/**
+	 * @brief Waits until the ring has a byte and returns the contiguous bytes from the front.
+	 *
+	 * The region may be shorter than the buffered bytes if they wrap around the end of the ring,
+	 * unless the storage is mirrored. It stays valid until it is released by \ref consume.
+	 *
+	 * @param[out] ec \a ok, \a closed, or \a canceled if \p token is stop requested.
+	 */
+	std::span<std::byte const> read_region(std::stop_token token, std::error_code& ec) {
+		std::unique_lock l(mutex_);
+		if(!wait_(l, readers_, token, std::chrono::steady_clock::time_point::max(), [&] { return size_ > 0; }, ec)) {
+			return {};
+		}
+
+		return {buffer_ + head_, contiguous_(head_, size_)};
+	}
+
+	/**
+	 * @brief Releases the first \p n bytes of the region returned by \ref read_region.
+	 */
+	void consume(std::size_t n) {
+		batch_           batch;
+		std::scoped_lock l(mutex_);
+		if(is_closed_) [[unlikely]] {
+			return;
+		}
+
+		assert(n <= size_);
+		head_ = (head_ + n) % capacity_;
+		size_ -= n;
+
+		on_read_(n, batch);
+	}
+
+	/**
+	 * @brief Waits until the ring has room and returns the contiguous free bytes after the back.
+	 *
+	 * The region may be shorter than the room if it wraps around the end of the ring,
+	 * unless the storage is mirrored.
+	 * The bytes written into it are sent by \ref commit.
+	 *
+	 * @param[out] ec \a ok, \a closed, or \a canceled if \p token is stop requested.
+	 */
+	std::span<std::byte> write_region(std::stop_token token, std::error_code& ec) {
+		std::unique_lock l(mutex_);
+		if(!wait_(l, writers_, token, std::chrono::steady_clock::time_point::max(), [&] { return size_ < capacity_; }, ec)) {
+			return {};
+		}
+
+		auto const tail = (head_ + size_) % capacity_;
+		return {buffer_ + tail, contiguous_(tail, capacity_ - size_)};
+	}
+
+	/**
+	 * @brief Sends the first \p n bytes of the region returned by \ref write_region.
+	 */
+	void commit(std::size_t n) {
+		batch_           batch;
+		std::scoped_lock l(mutex_);
+		if(is_closed_) [[unlikely]] {
+			return;
+		}
+
+		assert(size_ + n <= capacity_);
+		size_ += n;
+
+		on_written_(n, batch);
+	}
+
+   private:
+	/**
+	 * @brief Parked reader or writer; it is woken up with no bytes and looks at the ring again.
+	 */
+	using waiter_ = detail::waiter<std::byte>;
+	using queue_  = detail::waiter_queue<std::byte>;
+	using batch_  = detail::settle_batch<std::byte>;
+
+	/**
+	 * @return The number of the bytes from \p pos up to \p n that are contiguous in memory.
+	 */
+	[[nodiscard]] std::size_t contiguous_(std::size_t pos, std::size_t n) const noexcept {
+		if constexpr(Storage::is_mirrored) {
+			return n;
+		} else {
+			return std::min(n, capacity_ - pos);
+		}
+	}
+
+	/**
+	 * @brief Parks on \p waiters until \p is_ready holds.
+	 *
+	 * @return False if it is closed, canceled, or timed out, as reported by \p ec.
+	 */
+	template<typename F>
+	bool wait_(
+	    std::unique_lock<std::mutex>&         l,
+	    queue_&                               waiters,
+	    std::stop_token const&                token,
+	    std::chrono::steady_clock::time_point deadline,
+	    F&&                                   is_ready,
+	    std::error_code&                      ec) {
+		while(true) {
+			if(is_closed_) {
+				ec = channel_errc::closed;
+				return false;
+			}
+			if(is_ready()) {
+				ec = channel_errc::ok;
+				return true;
+			}
+			if(token.stop_requested()) {
+				ec = channel_errc::canceled;
+				return false;
+			}
+
+			detail::parker parker;
+			waiter_        task(nullptr, &parker);
+			waiters.push_back(task);
+
+			l.unlock();
+			{
+				std::stop_callback on_cancel(token, [&parker] {
+					if(parker.cancel()) {
+						parker.unpark();
+					}
+				});
+
+				parker.park_until(deadline);
+			}
+			l.lock();
+
+			if(parker.is_claimed_by(&task)) [[likely]] {
+				continue;
+			}
+
+			// Nobody can claim the task anymore, but it may still be queued.
+			waiters.erase(task);
+			if(parker.is_timed_out()) {
+				ec = channel_errc::timeout;
+				return false;
+			}
+
+			ec = channel_errc::canceled;
+			return false;
+		}
+	}
+
+	/**
+	 * @brief Claims the first parked waiter so it is woken up once the lock is released.
+	 */
+	static void wake_one_(queue_& waiters, batch_& batch) {
+		if(auto* const task = waiters.claim_front()) {
+			batch.push_back(*task, true);
+		}
+	}
+
+	static void wake_all_(queue_& waiters, batch_& batch) {
+		while(auto* const task = waiters.claim_front()) {
+			batch.push_back(*task, true);
+		}
+	}
+
+	/**
+	 * @brief Wakes up a writer for the room made by reading \p n bytes.
+	 *
+	 * Only one waiter is woken up at a time; the reader passes the wakeup on to the next reader
+	 * while bytes remain, as the woken writer does to the next writer while room remains.
+	 */
+	void on_read_(std::size_t n, batch_& batch) {
+		if(n > 0) {
+			wake_one_(writers_, batch);
+		}
+		if(size_ > 0) {
+			wake_one_(readers_, batch);
+		}
+	}
+
+	/**
+	 * @brief Wakes up a reader for the \p n bytes written, and passes the wakeup on to the next writer while room remains.
+	 */
+	void on_written_(std::size_t n, batch_& batch) {
+		if(n > 0) {
+			wake_one_(readers_, batch);
+		}
+		if(size_ < capacity_) {
+			wake_one_(writers_, batch);
+		}
+	}
+
+	std::size_t write_(std::span<std::byte const> data) {
+		auto const n = std::min(data.size(), capacity_ - size_);
+		if(n == 0) {
+			return 0;
+		}
+
+		auto const tail = (head_ + size_) % capacity_;
+		auto const m    = contiguous_(tail, n);
+
+		std::memcpy(buffer_ + tail, data.data(), m);
+		std::memcpy(buffer_, data.data() + m, n - m);
+
+		size_ += n;
+		return n;
+	}
+
+	std::size_t read_(std::span<std::byte> data) {
+		auto const n = std::min(data.size(), size_);
+		if(n == 0) {
+			return 0;
+		}
+
+		auto const m = contiguous_(head_, n);
+
+		std::memcpy(data.data(), buffer_ + head_, m);
+		std::memcpy(data.data() + m, buffer_, n - m);
+
+		head_ = (head_ + n) % capacity_;
+		size_ -= n;
+		return n;
+	}
+
+	mutable std::mutex mutex_;
+
+	queue_ readers_;
+	queue_ writers_;
+
+	Storage     storage_;
+	std::byte*  buffer_;
+	std::size_t capacity_;
+	std::size_t head_ = 0;
+	std::size_t size_ = 0;
+
+	bool is_closed_ = false;
+};
+
+using byte_channel = basic_byte_channel<detail::heap_ring>;
+
+}  // namespace channel
+}  // namespace lesomnus
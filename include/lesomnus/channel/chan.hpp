@@ -1,18 +1,90 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <concepts>
 #include <cstddef>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ratio>
+#include <ranges>
+#include <span>
 #include <stop_token>
+#include <type_traits>
 #include <utility>
 
+#include "lesomnus/channel/detail/awaiter.hpp"
+#include "lesomnus/channel/detail/waiter.hpp"
+#include "lesomnus/channel/detail/watcher.hpp"
 #include "lesomnus/channel/error.hpp"
+#include "lesomnus/channel/executor.hpp"
 
 namespace lesomnus {
 namespace channel {
 
 namespace detail {
 
+/**
+ * @brief Returns \p t advanced by \p d, or the end of the steady clock if it does not fit.
+ *
+ * A timeout of `duration::max()` is often passed to mean forever, so it must not wrap around into the past.
+ */
+template<typename Rep, typename Period>
+std::chrono::steady_clock::time_point saturating_add(std::chrono::steady_clock::time_point t, std::chrono::duration<Rep, Period> const& d) {
+	using steady_duration = std::chrono::steady_clock::duration;
+
+	constexpr auto End = std::chrono::steady_clock::time_point::max();
+	if(d <= d.zero()) {
+		return t;
+	}
+
+	auto const room = End - t;
+	if constexpr(std::chrono::treat_as_floating_point_v<Rep>) {
+		if(d >= std::chrono::duration<long double>(room)) {
+			return End;
+		}
+	} else if constexpr(std::ratio_greater_v<Period, steady_duration::period>) {
+		// The room is rounded down to the coarser unit, so the ceiling below does not overflow.
+		using factor = std::ratio_divide<Period, steady_duration::period>;
+		if(std::cmp_greater_equal(d.count(), room.count() / factor::num * factor::den)) {
+			return End;
+		}
+	}
+
+	auto const step = std::chrono::ceil<steady_duration>(d);
+	return step >= room ? End : t + step;
+}
+
+template<typename Clock, typename Duration>
+std::chrono::steady_clock::time_point to_steady(std::chrono::time_point<Clock, Duration> const& deadline) {
+	using common = std::common_type_t<Duration, typename Clock::duration, std::chrono::steady_clock::duration>;
+
+	// The deadline past the range of the common unit is taken as forever instead of overflowing.
+	if constexpr(!std::chrono::treat_as_floating_point_v<typename common::rep>) {
+		using factor = std::ratio_divide<typename Duration::period, typename common::period>;
+		if(std::cmp_greater_equal(deadline.time_since_epoch().count(), common::max().count() / factor::num)) {
+			return std::chrono::steady_clock::time_point::max();
+		}
+	}
+
+	if constexpr(std::is_same_v<Clock, std::chrono::steady_clock>) {
+		return saturating_add(std::chrono::steady_clock::time_point{}, deadline.time_since_epoch());
+	} else {
+		auto const now = Clock::now();
+		if(deadline <= now) {
+			return std::chrono::steady_clock::now();
+		}
+		return saturating_add(std::chrono::steady_clock::now(), deadline - now);
+	}
+}
+
+template<typename Rep, typename Period>
+std::chrono::steady_clock::time_point to_deadline(std::chrono::duration<Rep, Period> const& timeout) {
+	return saturating_add(std::chrono::steady_clock::now(), timeout);
+}
+
 class chan_base {
    public:
 	/**
@@ -32,8 +104,65 @@ class chan_base {
 	 * 
 	 */
 	virtual void close() = 0;
+
+	/**
+	 * @brief Registers the watcher notified whenever a receive may not block.
+	 * 
+	 * If it is already registered, it only checks the readiness.
+	 * 
+	 * @param w Watcher that must be unregistered before it is destroyed.
+	 * @return True if a receive does not block now.
+	 */
+	virtual bool watch_recv(watcher& w) = 0;
+
+	/**
+	 * @brief Unregisters the watcher registered by \ref watch_recv.
+	 */
+	virtual void unwatch_recv(watcher& w) = 0;
+
+	/**
+	 * @brief Registers the watcher notified whenever a send may not block.
+	 * 
+	 * If it is already registered, it only checks the readiness.
+	 * 
+	 * @param w Watcher that must be unregistered before it is destroyed.
+	 * @return True if a send does not block now.
+	 */
+	virtual bool watch_send(watcher& w) = 0;
+
+	/**
+	 * @brief Unregisters the watcher registered by \ref watch_send.
+	 */
+	virtual void unwatch_send(watcher& w) = 0;
+
+	/**
+	 * @brief Locks the channel.
+	 * 
+	 * The `*_locked` operations must be called while the channel is locked.
+	 * Channels locked together must be locked in order of the address of this class.
+	 */
+	virtual void lock() = 0;
+
+	virtual void unlock() = 0;
 };
 
+/**
+ * @brief Number of the values \ref receiver::range takes at once if they are available.
+ */
+inline constexpr std::size_t RecvBatchSize = 16;
+
+template<typename T>
+class recv_batch;
+
+template<typename T>
+class recv_iterator;
+
+template<typename T>
+class recv_value_iterator;
+
+template<typename T>
+class recv_range;
+
 }  // namespace detail
 
 template<typename T>
@@ -64,6 +193,33 @@ class receiver: public virtual detail::chan_base {
 		return ec == channel_errc::ok;
 	}
 
+	/**
+	 * @brief Extracts as many elements as available up to the size of \p values.
+	 * 
+	 * The channel is locked once for the whole batch and the woken senders are settled after it is unlocked.
+	 * 
+	 * @param[out] values Where the received values will be assigned in order.
+	 * @param[out] ec Why it stopped: \a ok if \p values is filled, \a exhausted or \a closed otherwise.
+	 * @return The number of the received values.
+	 */
+	virtual std::size_t try_recv_many(std::span<T> values, std::error_code& ec) {
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(*this);
+
+		ec = channel_errc::ok;
+
+		std::size_t n = 0;
+		while(n < values.size()) {
+			try_recv_locked(values[n], ec, batch);
+			if(ec != channel_errc::ok) {
+				break;
+			}
+			++n;
+		}
+
+		return n;
+	}
+
 	/**
 	 * @brief Extracts the first element from the buffer.
 	 * 
@@ -103,6 +259,128 @@ class receiver: public virtual detail::chan_base {
 		return recv(std::stop_token{}, value);
 	}
 
+	/**
+	 * @brief Extracts the first element from the buffer.
+	 * 
+	 * Unlike \ref recv, it gives up when \p deadline is exceeded.
+	 * Fails if \p token is stop requested, the channel closed, or the deadline exceeded.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[in]  deadline Time point to give up.
+	 * @param[out] value Where the received values will be assigned.
+	 * @param[out] ec Error report.
+	 */
+	virtual void recv_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T& value, std::error_code& ec) = 0;
+
+	/**
+	 * @brief Extracts the first element from the buffer.
+	 * 
+	 * Unlike \ref recv, it gives up when \p deadline is exceeded.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[in]  deadline Time point to give up.
+	 * @param[out] value Where the received values will be assigned.
+	 * @param[out] ec Error report.
+	 */
+	template<typename Clock, typename Duration>
+	void recv_until(std::stop_token token, std::chrono::time_point<Clock, Duration> const& deadline, T& value, std::error_code& ec) {
+		recv_until(std::move(token), detail::to_steady(deadline), value, ec);
+	}
+
+	/**
+	 * @brief Extracts the first element from the buffer.
+	 * 
+	 * Unlike \ref recv, it gives up when \p deadline is exceeded.
+	 * 
+	 * @param[in]  deadline Time point to give up.
+	 * @param[out] value Where the received values will be assigned.
+	 * @param[out] ec Error report.
+	 */
+	template<typename Clock, typename Duration>
+	void recv_until(std::chrono::time_point<Clock, Duration> const& deadline, T& value, std::error_code& ec) {
+		recv_until(std::stop_token{}, detail::to_steady(deadline), value, ec);
+	}
+
+	/**
+	 * @brief Extracts the first element from the buffer.
+	 * 
+	 * Unlike \ref recv, it gives up when \p deadline is exceeded.
+	 * 
+	 * @param[in]  deadline Time point to give up.
+	 * @param[out] value Where the received values will be assigned.
+	 * @return False if no value is received.
+	 */
+	template<typename Clock, typename Duration>
+	bool recv_until(std::chrono::time_point<Clock, Duration> const& deadline, T& value) {
+		std::error_code ec;
+		recv_until(deadline, value, ec);
+		return ec == channel_errc::ok;
+	}
+
+	/**
+	 * @brief Extracts the first element from the buffer.
+	 * 
+	 * Unlike \ref recv, it gives up when \p timeout is elapsed.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[in]  timeout Duration to give up.
+	 * @param[out] value Where the received values will be assigned.
+	 * @param[out] ec Error report.
+	 */
+	template<typename Rep, typename Period>
+	void recv_for(std::stop_token token, std::chrono::duration<Rep, Period> const& timeout, T& value, std::error_code& ec) {
+		recv_until(std::move(token), detail::to_deadline(timeout), value, ec);
+	}
+
+	/**
+	 * @brief Extracts the first element from the buffer.
+	 * 
+	 * Unlike \ref recv, it gives up when \p timeout is elapsed.
+	 * 
+	 * @param[in]  timeout Duration to give up.
+	 * @param[out] value Where the received values will be assigned.
+	 * @param[out] ec Error report.
+	 */
+	template<typename Rep, typename Period>
+	void recv_for(std::chrono::duration<Rep, Period> const& timeout, T& value, std::error_code& ec) {
+		recv_until(std::stop_token{}, detail::to_deadline(timeout), value, ec);
+	}
+
+	/**
+	 * @brief Extracts the first element from the buffer.
+	 * 
+	 * Unlike \ref recv, it gives up when \p timeout is elapsed.
+	 * 
+	 * @param[in]  timeout Duration to give up.
+	 * @param[out] value Where the received values will be assigned.
+	 * @return False if no value is received.
+	 */
+	template<typename Rep, typename Period>
+	bool recv_for(std::chrono::duration<Rep, Period> const& timeout, T& value) {
+		std::error_code ec;
+		recv_for(timeout, value, ec);
+		return ec == channel_errc::ok;
+	}
+
+	/**
+	 * @brief Registers callback function that will be called when the value is received.
+	 * 
+	 * If the element is available or there are hanging senders, the callback function is called immediately
+	 * on the caller's thread. Otherwise, the callback function is posted to \p ex by the sender.
+	 * 
+	 * When accessing the buffer, \p need_abort is called to see if the scheduled
+	 * operation is steel valid. If \p need_abort returns false, the callback is removed.
+	 * 
+	 * Unlike \p on_settled, \p need_abort is called and an aborted operation is destroyed along with its callbacks
+	 * while the channel is locked, once per hanging operation on a match,
+	 * so they must be cheap and must not use the channel. On close, they run after the channel is unlocked.
+	 * 
+	 * @param need_abort Validator.
+	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
+	 */
+	virtual void recv_sched(std::function<bool()> need_abort, std::function<void(bool, T&&)> on_settled, executor& ex) = 0;
+
 	/**
 	 * @brief Registers callback function that will be called when the value is received.
 	 * 
@@ -115,41 +393,338 @@ class receiver: public virtual detail::chan_base {
 	 * @param need_abort Validator.
 	 * @param on_settled Callback function.
 	 */
-	virtual void recv_sched(std::function<bool()> need_abort, std::function<void(bool, T&&)> on_settled) = 0;
+	void recv_sched(std::function<bool()> need_abort, std::function<void(bool, T&&)> on_settled) {
+		recv_sched(std::move(need_abort), std::move(on_settled), inline_executor::instance());
+	}
 
 	/**
 	 * @brief Registers callback function that will be called when the value is received.
 	 * 
 	 * If the element is available or there are hanging senders, the callback function is called immediately,
-	 * otherwise the callback function is called on the sender's thread.
+	 * otherwise the callback function is run on \p ex, which is the sender's thread by default.
 	 * 
 	 * When accessing the buffer, \p token is checked to see if the scheduled
 	 * operation is steel valid. If \p token is stop requested, the callback is removed.
 	 * 
 	 * @param token Validator.
 	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
 	 */
-	void recv_sched(std::stop_token token, std::function<void(bool, T&&)> on_settled) {
+	void recv_sched(std::stop_token token, std::function<void(bool, T&&)> on_settled, executor& ex = inline_executor::instance()) {
 		if(token.stop_requested()) {
 			return;
 		}
 
-		recv_sched([token] { return token.stop_requested(); }, std::move(on_settled));
+		recv_sched([token] { return token.stop_requested(); }, std::move(on_settled), ex);
 	}
 
 	/**
 	 * @brief Registers callback function that will be called when the value is sent.
 	 * 
 	 * If the element is available, the callback function is called immediately,
-	 * otherwise the callback function is called on the sender's thread.
+	 * otherwise the callback function is run on \p ex, which is the sender's thread by default.
 	 * 
 	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
+	 */
+	void recv_sched(std::function<void(bool, T&&)> on_settled, executor& ex = inline_executor::instance()) {
+		recv_sched([] { return false; }, std::move(on_settled), ex);
+	}
+
+	/**
+	 * @brief Returns the awaitable that receives the value into \p value.
+	 * 
+	 * `co_await` on it results in true if the value is received.
+	 * The coroutine is suspended without blocking the thread and resumed on \p ex once it is settled.
+	 * Nothing is allocated since the awaitable is hanged on the channel as is.
+	 * 
+	 * @param[out] value Where the received value will be assigned. It must outlive the awaiting.
+	 * @param ex Executor where the coroutine is resumed.
 	 */
-	void recv_sched(std::function<void(bool, T&&)> on_settled) {
-		recv_sched([] { return false; }, std::move(on_settled));
+	detail::recv_awaiter<T> async_recv(T& value, executor& ex = executor::current()) {
+		return detail::recv_awaiter<T>(*this, std::stop_token{}, value, ex);
 	}
+
+	/**
+	 * @brief Returns the awaitable that receives the value into \p value.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[out] value Where the received value will be assigned. It must outlive the awaiting.
+	 * @param ex Executor where the coroutine is resumed.
+	 */
+	detail::recv_awaiter<T> async_recv(std::stop_token token, T& value, executor& ex = executor::current()) {
+		return detail::recv_awaiter<T>(*this, std::move(token), value, ex);
+	}
+
+	/**
+	 * @brief Returns the awaitable that receives the value into \p value.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[out] value Where the received value will be assigned. It must outlive the awaiting.
+	 * @param[out] ec Error report. It must outlive the awaiting.
+	 * @param ex Executor where the coroutine is resumed.
+	 */
+	detail::recv_awaiter<T> async_recv(std::stop_token token, T& value, std::error_code& ec, executor& ex = executor::current()) {
+		return detail::recv_awaiter<T>(*this, std::move(token), value, ec, ex);
+	}
+
+	/**
+	 * @brief Hangs the task on the channel until a sender settles it.
+	 * 
+	 * If the element is available or the channel is closed, \p task is claimed and settled immediately.
+	 * Otherwise, it is settled on the sender's thread or stays until \ref recv_dequeue is called.
+	 * The received value is moved into `task.elem()`.
+	 * 
+	 * @param task Task owned by the caller.
+	 * @return False if \p task is claimed but the sender is gone in the meantime.
+	 *         The task is neither settled nor hanged then.
+	 */
+	virtual bool recv_enqueue(detail::waiter<T>& task) = 0;
+
+	/**
+	 * @brief Removes the task from the channel if it is still hanging.
+	 * 
+	 * Once it returns, the channel no longer accesses \p task.
+	 * 
+	 * @param task Task passed to \ref recv_enqueue.
+	 */
+	virtual void recv_dequeue(detail::waiter<T>& task) = 0;
+
+	/**
+	 * @brief Same as \ref try_recv but the channel must be locked.
+	 * 
+	 * It never blocks nor wakes up the peer; the peer is added to \p batch
+	 * so that it is settled after the channel is unlocked.
+	 */
+	virtual void try_recv_locked(T& value, std::error_code& ec, detail::settle_batch<T>& batch) = 0;
+
+	/**
+	 * @brief Hangs the task on the locked channel.
+	 * 
+	 * Unlike \ref recv_enqueue, it does not check the readiness;
+	 * the caller must have seen the channel not ready with the lock held.
+	 * 
+	 * @param task Task owned by the caller.
+	 */
+	virtual void recv_enqueue_locked(detail::waiter<T>& task) = 0;
+
+	/**
+	 * @brief Removes the task from the locked channel if it is still hanging.
+	 * 
+	 * @param task Task passed to \ref recv_enqueue_locked.
+	 */
+	virtual void recv_dequeue_locked(detail::waiter<T>& task) = 0;
+
+	/**
+	 * @brief Iterates over the received values until the channel is closed.
+	 *
+	 * The values are taken one at a time when the previous one is consumed,
+	 * so a loop that stops early leaves the rest in the channel.
+	 * The value is kept in the iterator, so nothing is allocated.
+	 * Use \ref range to take them in batches.
+	 */
+	detail::recv_value_iterator<T> begin() {
+		return detail::recv_value_iterator<T>(*this);
+	}
+
+	std::default_sentinel_t end() const noexcept {
+		return std::default_sentinel;
+	}
+
+	/**
+	 * @brief Returns a view over the received values until the channel is closed or \p token is stop requested.
+	 *
+	 * The values taken but not incremented past are kept in the view,
+	 * so the next iteration over it starts from the value the previous one stopped at.
+	 * They are lost if the view is destroyed; use a batch size of 1 if it is not iterated to the end.
+	 *
+	 * @param token Interrupt register.
+	 * @param batch_size Maximum number of the values taken at once.
+	 */
+	detail::recv_range<T> range(std::stop_token token = {}, std::size_t batch_size = detail::RecvBatchSize) {
+		return detail::recv_range<T>(*this, std::move(token), batch_size);
+	}
+};
+
+namespace detail {
+
+/**
+ * @brief Values taken from a channel at once, shared by the iterators over them.
+ */
+template<typename T>
+class recv_batch {
+   public:
+	recv_batch(receiver<T>& chan, std::stop_token token, std::size_t capacity)
+	    : chan_(&chan)
+	    , token_(std::move(token))
+	    , buffer_(std::make_unique<T[]>(std::max<std::size_t>(1, capacity)))
+	    , capacity_(std::max<std::size_t>(1, capacity)) { }
+
+	T& front() noexcept {
+		return buffer_[pos_];
+	}
+
+	void pop() noexcept {
+		++pos_;
+	}
+
+	/**
+	 * @brief Takes the available values if every value is visited, or waits for one if there is none.
+	 *
+	 * @return `false` if the channel is closed or \ref token_ is stop requested.
+	 */
+	bool fill() {
+		if(pos_ < size_) {
+			return true;
+		}
+
+		pos_ = 0;
+
+		std::error_code ec;
+		size_ = chan_->try_recv_many(std::span<T>(buffer_.get(), capacity_), ec);
+		if(size_ > 0 || ec == channel_errc::closed) {
+			return size_ > 0;
+		}
+
+		chan_->recv(token_, buffer_[0], ec);
+		size_ = ec == channel_errc::ok ? 1 : 0;
+		return size_ > 0;
+	}
+
+   private:
+	receiver<T>*    chan_;
+	std::stop_token token_;
+
+	std::unique_ptr<T[]> buffer_;
+	std::size_t          capacity_;
+	std::size_t          pos_  = 0;
+	std::size_t          size_ = 0;
 };
 
+/**
+ * @brief Input iterator over a \ref recv_batch.
+ *
+ * The batch is filled when the iterator is compared with the end after the batch is consumed,
+ * so incrementing past the last wanted value does not take another one.
+ * Its copies share the batch.
+ */
+template<typename T>
+class recv_iterator {
+   public:
+	using iterator_concept = std::input_iterator_tag;
+	using value_type       = T;
+	using difference_type  = std::ptrdiff_t;
+
+	recv_iterator() = default;
+
+	explicit recv_iterator(std::shared_ptr<recv_batch<T>> batch)
+	    : batch_(std::move(batch)) { }
+
+	T& operator*() const noexcept {
+		return batch_->front();
+	}
+
+	recv_iterator& operator++() noexcept {
+		batch_->pop();
+		return *this;
+	}
+
+	void operator++(int) noexcept {
+		++*this;
+	}
+
+	friend bool operator==(recv_iterator const& it, std::default_sentinel_t) {
+		return it.batch_ == nullptr || !it.batch_->fill();
+	}
+
+   private:
+	std::shared_ptr<recv_batch<T>> batch_;
+};
+
+/**
+ * @brief Input iterator that takes one value at a time into itself.
+ *
+ * The value is received when the iterator is compared with the end after the previous one is consumed,
+ * as \ref recv_iterator does with a batch of 1.
+ * It is move-only since its copies would receive the values independently.
+ */
+template<typename T>
+class recv_value_iterator {
+   public:
+	using iterator_concept = std::input_iterator_tag;
+	using value_type       = T;
+	using difference_type  = std::ptrdiff_t;
+
+	recv_value_iterator() = default;
+
+	explicit recv_value_iterator(receiver<T>& chan)
+	    : chan_(&chan) { }
+
+	recv_value_iterator(recv_value_iterator const& other) = delete;
+	recv_value_iterator(recv_value_iterator&& other)      = default;
+
+	recv_value_iterator& operator=(recv_value_iterator const& other) = delete;
+	recv_value_iterator& operator=(recv_value_iterator&& other)      = default;
+
+	T& operator*() const noexcept {
+		return value_;
+	}
+
+	recv_value_iterator& operator++() noexcept {
+		has_value_ = false;
+		return *this;
+	}
+
+	void operator++(int) noexcept {
+		++*this;
+	}
+
+	friend bool operator==(recv_value_iterator const& it, std::default_sentinel_t) {
+		if(it.chan_ == nullptr) {
+			return true;
+		}
+		if(!it.has_value_) {
+			it.has_value_ = it.chan_->recv(it.value_);
+		}
+
+		return !it.has_value_;
+	}
+
+   private:
+	receiver<T>* chan_ = nullptr;
+
+	mutable T    value_{};
+	mutable bool has_value_ = false;
+};
+
+/**
+ * @brief View over the values received from a channel.
+ *
+ * It is single-pass; each \ref begin continues from the value the previous iteration stopped at.
+ * Its copies share the values taken but not visited.
+ */
+template<typename T>
+class recv_range: public std::ranges::view_base {
+   public:
+	recv_range() = default;
+
+	recv_range(receiver<T>& chan, std::stop_token token, std::size_t batch_size)
+	    : batch_(std::make_shared<recv_batch<T>>(chan, std::move(token), batch_size)) { }
+
+	recv_iterator<T> begin() const noexcept {
+		return recv_iterator<T>(batch_);
+	}
+
+	std::default_sentinel_t end() const noexcept {
+		return std::default_sentinel;
+	}
+
+   private:
+	std::shared_ptr<recv_batch<T>> batch_;
+};
+
+}  // namespace detail
+
 template<typename T>
 class sender: public virtual detail::chan_base {
    public:
@@ -203,6 +778,34 @@ class sender: public virtual detail::chan_base {
 		return ec == channel_errc::ok;
 	}
 
+	/**
+	 * @brief Sends as many elements of \p values as possible without blocking.
+	 * 
+	 * The channel is locked once for the whole batch and the woken receivers are settled after it is unlocked.
+	 * The values are moved only if they are sent.
+	 * 
+	 * @param values Values to send in order.
+	 * @param[out] ec Why it stopped: \a ok if all are sent, \a exhausted or \a closed otherwise.
+	 * @return The number of the sent values.
+	 */
+	std::size_t try_send_many(std::span<T> values, std::error_code& ec) {
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(*this);
+
+		ec = channel_errc::ok;
+
+		std::size_t n = 0;
+		while(n < values.size()) {
+			try_send_locked(std::move(values[n]), ec, batch);
+			if(ec != channel_errc::ok) {
+				break;
+			}
+			++n;
+		}
+
+		return n;
+	}
+
 	/**
 	 * @brief Appends the value to the end of the buffer.
 	 * 
@@ -285,11 +888,174 @@ class sender: public virtual detail::chan_base {
 		return send(std::stop_token{}, std::move(value));
 	}
 
+	/**
+	 * @brief Appends the value to the end of the buffer.
+	 * 
+	 * Unlike \ref send, it gives up when \p deadline is exceeded.
+	 * Fails if \p token is stop requested, the channel closed, or the deadline exceeded.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[in]  deadline Time point to give up.
+	 * @param[in]  value Value to send.
+	 * @param[out] ec Error report.
+	 */
+	virtual void send_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T const& value, std::error_code& ec) = 0;
+
+	/**
+	 * @brief Appends the value to the end of the buffer.
+	 * 
+	 * Unlike \ref send, it gives up when \p deadline is exceeded.
+	 * Fails if \p token is stop requested, the channel closed, or the deadline exceeded.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[in]  deadline Time point to give up.
+	 * @param[in]  value Value to send.
+	 * @param[out] ec Error report.
+	 */
+	virtual void send_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T&& value, std::error_code& ec) = 0;
+
+	/**
+	 * @brief Appends the value to the end of the buffer.
+	 * 
+	 * Unlike \ref send, it gives up when \p deadline is exceeded.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[in]  deadline Time point to give up.
+	 * @param[in]  value Value to send.
+	 * @param[out] ec Error report.
+	 */
+	template<typename Clock, typename Duration, typename U>
+	requires std::convertible_to<U&&, T>
+	         && (!std::same_as<std::chrono::time_point<Clock, Duration>, std::chrono::steady_clock::time_point>)
+	void send_until(std::stop_token token, std::chrono::time_point<Clock, Duration> const& deadline, U&& value, std::error_code& ec) {
+		send_until(std::move(token), detail::to_steady(deadline), std::forward<U>(value), ec);
+	}
+
+	/**
+	 * @brief Appends the value to the end of the buffer.
+	 * 
+	 * Unlike \ref send, it gives up when \p deadline is exceeded.
+	 * 
+	 * @param[in]  deadline Time point to give up.
+	 * @param[in]  value Value to send.
+	 * @param[out] ec Error report.
+	 */
+	template<typename Clock, typename Duration, typename U>
+	requires std::convertible_to<U&&, T>
+	void send_until(std::chrono::time_point<Clock, Duration> const& deadline, U&& value, std::error_code& ec) {
+		send_until(std::stop_token{}, detail::to_steady(deadline), std::forward<U>(value), ec);
+	}
+
+	/**
+	 * @brief Appends the value to the end of the buffer.
+	 * 
+	 * Unlike \ref send, it gives up when \p deadline is exceeded.
+	 * 
+	 * @param deadline Time point to give up.
+	 * @param value Value to send.
+	 * @return False if no value is sent.
+	 */
+	template<typename Clock, typename Duration, typename U>
+	requires std::convertible_to<U&&, T>
+	bool send_until(std::chrono::time_point<Clock, Duration> const& deadline, U&& value) {
+		std::error_code ec;
+		send_until(deadline, std::forward<U>(value), ec);
+		return ec == channel_errc::ok;
+	}
+
+	/**
+	 * @brief Appends the value to the end of the buffer.
+	 * 
+	 * Unlike \ref send, it gives up when \p timeout is elapsed.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[in]  timeout Duration to give up.
+	 * @param[in]  value Value to send.
+	 * @param[out] ec Error report.
+	 */
+	template<typename Rep, typename Period, typename U>
+	requires std::convertible_to<U&&, T>
+	void send_for(std::stop_token token, std::chrono::duration<Rep, Period> const& timeout, U&& value, std::error_code& ec) {
+		send_until(std::move(token), detail::to_deadline(timeout), std::forward<U>(value), ec);
+	}
+
+	/**
+	 * @brief Appends the value to the end of the buffer.
+	 * 
+	 * Unlike \ref send, it gives up when \p timeout is elapsed.
+	 * 
+	 * @param[in]  timeout Duration to give up.
+	 * @param[in]  value Value to send.
+	 * @param[out] ec Error report.
+	 */
+	template<typename Rep, typename Period, typename U>
+	requires std::convertible_to<U&&, T>
+	void send_for(std::chrono::duration<Rep, Period> const& timeout, U&& value, std::error_code& ec) {
+		send_until(std::stop_token{}, detail::to_deadline(timeout), std::forward<U>(value), ec);
+	}
+
+	/**
+	 * @brief Appends the value to the end of the buffer.
+	 * 
+	 * Unlike \ref send, it gives up when \p timeout is elapsed.
+	 * 
+	 * @param timeout Duration to give up.
+	 * @param value Value to send.
+	 * @return False if no value is sent.
+	 */
+	template<typename Rep, typename Period, typename U>
+	requires std::convertible_to<U&&, T>
+	bool send_for(std::chrono::duration<Rep, Period> const& timeout, U&& value) {
+		std::error_code ec;
+		send_for(timeout, std::forward<U>(value), ec);
+		return ec == channel_errc::ok;
+	}
+
+	/**
+	 * @brief Registers callback function that will be called when the value is sent.
+	 * 
+	 * If the buffer is not full or there are hanging receivers, the callback function is called immediately
+	 * on the caller's thread. Otherwise, the callback function is posted to \p ex by the receiver.
+	 * 
+	 * When accessing the buffer, \p need_abort is called to see if the scheduled
+	 * operation is steel valid. If \p need_abort returns false, the callback is removed.
+	 * 
+	 * Unlike \p on_settled, \p need_abort is called and an aborted operation is destroyed along with its callbacks
+	 * while the channel is locked, once per hanging operation on a match,
+	 * so they must be cheap and must not use the channel. On close, they run after the channel is unlocked.
+	 * 
+	 * @param value Value to send.
+	 * @param need_abort Validator.
+	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
+	 */
+	virtual void send_sched(T const& value, std::function<bool()> need_abort, std::function<void(bool)> on_settled, executor& ex) = 0;
+
+	/**
+	 * @brief Registers callback function that will be called when the value is sent.
+	 * 
+	 * If the buffer is not full or there are hanging receivers, the callback function is called immediately
+	 * on the caller's thread. Otherwise, the callback function is posted to \p ex by the receiver.
+	 * 
+	 * When accessing the buffer, \p need_abort is called to see if the scheduled
+	 * operation is steel valid. If \p need_abort returns false, the callback is removed.
+	 * 
+	 * Unlike \p on_settled, \p need_abort is called and an aborted operation is destroyed along with its callbacks
+	 * while the channel is locked, once per hanging operation on a match,
+	 * so they must be cheap and must not use the channel. On close, they run after the channel is unlocked.
+	 * 
+	 * @param value Value to send.
+	 * @param need_abort Validator.
+	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
+	 */
+	virtual void send_sched(T&& value, std::function<bool()> need_abort, std::function<void(bool)> on_settled, executor& ex) = 0;
+
 	/**
 	 * @brief Registers callback function that will be called when the value is sent.
 	 * 
 	 * If the buffer is not full or there are hanging receivers, the callback function is called immediately,
-	 * otherwise the callback function is called on the sender's thread.
+	 * otherwise the callback function is called on the receiver's thread.
 	 * 
 	 * When accessing the buffer, \p need_abort is called to see if the scheduled
 	 * operation is steel valid. If \p need_abort returns false, the callback is removed.
@@ -298,13 +1064,15 @@ class sender: public virtual detail::chan_base {
 	 * @param need_abort Validator.
 	 * @param on_settled Callback function.
 	 */
-	virtual void send_sched(T const& value, std::function<bool()> need_abort, std::function<void(bool)> on_settled) = 0;
+	void send_sched(T const& value, std::function<bool()> need_abort, std::function<void(bool)> on_settled) {
+		send_sched(value, std::move(need_abort), std::move(on_settled), inline_executor::instance());
+	}
 
 	/**
 	 * @brief Registers callback function that will be called when the value is sent.
 	 * 
 	 * If the buffer is not full or there are hanging receivers, the callback function is called immediately,
-	 * otherwise the callback function is called on the sender's thread.
+	 * otherwise the callback function is called on the receiver's thread.
 	 * 
 	 * When accessing the buffer, \p need_abort is called to see if the scheduled
 	 * operation is steel valid. If \p need_abort returns false, the callback is removed.
@@ -313,13 +1081,15 @@ class sender: public virtual detail::chan_base {
 	 * @param need_abort Validator.
 	 * @param on_settled Callback function.
 	 */
-	virtual void send_sched(T&& value, std::function<bool()> need_abort, std::function<void(bool)> on_settled) = 0;
+	void send_sched(T&& value, std::function<bool()> need_abort, std::function<void(bool)> on_settled) {
+		send_sched(std::move(value), std::move(need_abort), std::move(on_settled), inline_executor::instance());
+	}
 
 	/**
 	 * @brief Registers callback function that will be called when the value is sent.
 	 * 
 	 * If the buffer is not full or there are hanging receivers, the callback function is called immediately,
-	 * otherwise the callback function is called on the sender's thread.
+	 * otherwise the callback function is run on \p ex, which is the receiver's thread by default.
 	 * 
 	 * When accessing the buffer, \p token is checked to see if the scheduled
 	 * operation is steel valid. If \p token is stop requested, the callback is removed.
@@ -327,21 +1097,22 @@ class sender: public virtual detail::chan_base {
 	 * @param value Value to send.
 	 * @param token Validator.
 	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
 	 */
-	void send_sched(std::stop_token token, T const& value, std::function<void(bool, T&&)> on_settled) {
+	void send_sched(std::stop_token token, T const& value, std::function<void(bool)> on_settled, executor& ex = inline_executor::instance()) {
 		if(token.stop_requested()) [[unlikely]] {
 			return;
 		}
 
 		send_sched(
-		    value, [token] { return token.stop_requested(); }, std::move(on_settled));
+		    value, [token] { return token.stop_requested(); }, std::move(on_settled), ex);
 	}
 
 	/**
 	 * @brief Registers callback function that will be called when the value is sent.
 	 * 
 	 * If the buffer is not full or there are hanging receivers, the callback function is called immediately,
-	 * otherwise the callback function is called on the sender's thread.
+	 * otherwise the callback function is run on \p ex, which is the receiver's thread by default.
 	 * 
 	 * When accessing the buffer, \p token is checked to see if the scheduled
 	 * operation is steel valid. If \p token is stop requested, the callback is removed.
@@ -349,43 +1120,136 @@ class sender: public virtual detail::chan_base {
 	 * @param value Value to send.
 	 * @param token Validator.
 	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
 	 */
-	void send_sched(std::stop_token token, T&& value, std::function<void(bool)> on_settled) {
+	void send_sched(std::stop_token token, T&& value, std::function<void(bool)> on_settled, executor& ex = inline_executor::instance()) {
 		if(token.stop_requested()) [[unlikely]] {
 			return;
 		}
 
 		send_sched(
-		    std::move(value), [token] { return token.stop_requested(); }, std::move(on_settled));
+		    std::move(value), [token] { return token.stop_requested(); }, std::move(on_settled), ex);
 	}
 
 	/**
 	 * @brief Registers callback function that will be called when the value is sent.
 	 * 
 	 * If the buffer is not full or there are hanging receivers, the callback function is called immediately,
-	 * otherwise the callback function is called on the sender's thread.
+	 * otherwise the callback function is run on \p ex, which is the receiver's thread by default.
 	 * 
 	 * @param value Value to send.
 	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
 	 */
-	void send_sched(T const& value, std::function<void(bool)> on_settled) {
+	void send_sched(T const& value, std::function<void(bool)> on_settled, executor& ex = inline_executor::instance()) {
 		send_sched(
-		    value, [] { return false; }, std::move(on_settled));
+		    value, [] { return false; }, std::move(on_settled), ex);
 	}
 
 	/**
 	 * @brief Registers callback function that will be called when the value is sent.
 	 * 
 	 * If the buffer is not full or there are hanging receivers, the callback function is called immediately,
-	 * otherwise the callback function is called on the sender's thread.
+	 * otherwise the callback function is run on \p ex, which is the receiver's thread by default.
 	 * 
 	 * @param value Value to send.
 	 * @param on_settled Callback function.
+	 * @param ex Executor where the callback is run if it is not settled immediately.
 	 */
-	void send_sched(T&& value, std::function<void(bool)> on_settled) {
+	void send_sched(T&& value, std::function<void(bool)> on_settled, executor& ex = inline_executor::instance()) {
 		send_sched(
-		    std::move(value), [] { return false; }, std::move(on_settled));
+		    std::move(value), [] { return false; }, std::move(on_settled), ex);
+	}
+
+	/**
+	 * @brief Returns the awaitable that sends \p value.
+	 * 
+	 * `co_await` on it results in true if the value is sent.
+	 * The coroutine is suspended without blocking the thread and resumed on \p ex once it is settled.
+	 * Nothing is allocated since the awaitable holds the value and is hanged on the channel as is.
+	 * 
+	 * @param value Value to send.
+	 * @param ex Executor where the coroutine is resumed.
+	 */
+	template<typename U>
+	requires std::constructible_from<T, U&&>
+	detail::send_awaiter<T> async_send(U&& value, executor& ex = executor::current()) {
+		return detail::send_awaiter<T>(*this, std::stop_token{}, std::forward<U>(value), ex);
+	}
+
+	/**
+	 * @brief Returns the awaitable that sends \p value.
+	 * 
+	 * @param[in] token Interrupt register.
+	 * @param[in] value Value to send.
+	 * @param ex Executor where the coroutine is resumed.
+	 */
+	template<typename U>
+	requires std::constructible_from<T, U&&>
+	detail::send_awaiter<T> async_send(std::stop_token token, U&& value, executor& ex = executor::current()) {
+		return detail::send_awaiter<T>(*this, std::move(token), std::forward<U>(value), ex);
+	}
+
+	/**
+	 * @brief Returns the awaitable that sends \p value.
+	 * 
+	 * @param[in]  token Interrupt register.
+	 * @param[in]  value Value to send.
+	 * @param[out] ec Error report. It must outlive the awaiting.
+	 * @param ex Executor where the coroutine is resumed.
+	 */
+	template<typename U>
+	requires std::constructible_from<T, U&&>
+	detail::send_awaiter<T> async_send(std::stop_token token, U&& value, std::error_code& ec, executor& ex = executor::current()) {
+		return detail::send_awaiter<T>(*this, std::move(token), std::forward<U>(value), ec, ex);
 	}
+
+	/**
+	 * @brief Hangs the task on the channel until a receiver settles it.
+	 * 
+	 * If the buffer is not full or the channel is closed, \p task is claimed and settled immediately.
+	 * Otherwise, it is settled on the receiver's thread or stays until \ref send_dequeue is called.
+	 * The value to send is moved from `task.elem()`.
+	 * 
+	 * @param task Task owned by the caller.
+	 * @return False if \p task is claimed but the receiver is gone in the meantime.
+	 *         The task is neither settled nor hanged then.
+	 */
+	virtual bool send_enqueue(detail::waiter<T>& task) = 0;
+
+	/**
+	 * @brief Removes the task from the channel if it is still hanging.
+	 * 
+	 * Once it returns, the channel no longer accesses \p task.
+	 * 
+	 * @param task Task passed to \ref send_enqueue.
+	 */
+	virtual void send_dequeue(detail::waiter<T>& task) = 0;
+
+	/**
+	 * @brief Same as \ref try_send but the channel must be locked.
+	 * 
+	 * \p value is moved only if it is sent.
+	 * The peer is added to \p batch so that it is settled after the channel is unlocked.
+	 */
+	virtual void try_send_locked(T&& value, std::error_code& ec, detail::settle_batch<T>& batch) = 0;
+
+	/**
+	 * @brief Hangs the task on the locked channel.
+	 * 
+	 * Unlike \ref send_enqueue, it does not check the readiness;
+	 * the caller must have seen the channel not ready with the lock held.
+	 * 
+	 * @param task Task owned by the caller.
+	 */
+	virtual void send_enqueue_locked(detail::waiter<T>& task) = 0;
+
+	/**
+	 * @brief Removes the task from the locked channel if it is still hanging.
+	 * 
+	 * @param task Task passed to \ref send_enqueue_locked.
+	 */
+	virtual void send_dequeue_locked(detail::waiter<T>& task) = 0;
 };
 
 template<typename T>
@@ -395,3 +1259,14 @@ class chan
 
 }  // namespace channel
 }  // namespace lesomnus
+
+namespace std::ranges {
+
+/**
+ * @brief Channels are not sized ranges; their `size()` counts the buffered values, not the values an iteration yields.
+ */
+template<typename C>
+	requires std::derived_from<C, lesomnus::channel::detail::chan_base>
+inline constexpr bool disable_sized_range<C> = true;
+
+}  // namespace std::ranges
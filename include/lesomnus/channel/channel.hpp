@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
@@ -8,48 +10,67 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <span>
 #include <stop_token>
 #include <system_error>
 #include <type_traits>
 #include <utility>
 
-#include "lesomnus/channel/channel.hpp"
-#include "lesomnus/channel/detail/task.hpp"
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/detail/parker.hpp"
+#include "lesomnus/channel/detail/waiter.hpp"
+#include "lesomnus/channel/detail/watcher.hpp"
 #include "lesomnus/channel/error.hpp"
+#include "lesomnus/channel/executor.hpp"
 
 namespace lesomnus {
 namespace channel {
 
 inline constexpr std::size_t unbounded_capacity = -1;
 
-template<typename T, std::size_t Cap = 0>
+namespace detail {
+
+/**
+ * @brief Buffer whose values are contiguous from the front, such as \ref mirrored_queue.
+ */
+template<typename Buffer, typename T>
+concept contiguous_buffer = requires(Buffer& b) {
+	{ b.values() } -> std::same_as<std::span<T>>;
+};
+
+}  // namespace detail
+
+/**
+ * @tparam Buffer Queue of the buffered values with `empty`, `size`, `front`, `pop` and `emplace` like `std::queue`.
+ *                If it also has `values()` that returns them contiguous from the front,
+ *                the channel exposes them in place by \ref recv_region.
+ */
+template<typename T, std::size_t Cap = 0, typename Buffer = std::queue<T>>
 class bounded_channel: public chan<T> {
    public:
-	using send_task = detail::task<std::function<void(bool, T&)>>;
-	using recv_task = detail::task<std::function<void(bool, T&&)>>;
-
+	using chan<T>::try_recv;
 	using chan<T>::recv;
+	using chan<T>::recv_until;
+	using chan<T>::recv_sched;
+	using chan<T>::try_send;
 	using chan<T>::send;
+	using chan<T>::send_until;
+	using chan<T>::send_sched;
+
+	bounded_channel() = default;
+
+	~bounded_channel() {
+		hanged_recv_tasks.clear();
+		hanged_send_tasks.clear();
+	}
 
 	std::intmax_t size() const override {
 		std::scoped_lock l(mutex_);
 
-		while(!hanged_recv_tasks.empty()) {
-			if(!hanged_recv_tasks.front().need_abort()) {
-				break;
-			}
-
-			hanged_recv_tasks.pop();
-		}
+		hanged_recv_tasks.prune();
 
 		if constexpr(Cap != unbounded_capacity) {
-			while(!hanged_send_tasks.empty()) {
-				if(!hanged_send_tasks.front().need_abort()) {
-					break;
-				}
-
-				hanged_send_tasks.pop();
-			}
+			hanged_send_tasks.prune();
 
 			return static_cast<std::intmax_t>(buffer_.size()) - hanged_recv_tasks.size() + hanged_send_tasks.size();
 		} else {
@@ -62,123 +83,197 @@ class bounded_channel: public chan<T> {
 	}
 
 	void close() override {
-		std::scoped_lock l(mutex_);
+		// Waiters are only detached with the lock held and woken up after it is released.
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(mutex_);
 		is_closed_ = true;
 
-		T v;
-		while(!hanged_recv_tasks.empty()) {
-			auto& task = hanged_recv_tasks.front();
-			if(!task.need_abort()) {
-				task.execute(false, std::move(v));
-			}
-			hanged_recv_tasks.pop();
-		}
+		recv_watchers_.notify_all();
+		send_watchers_.notify_all();
 
+		batch.close(hanged_recv_tasks);
 		if constexpr(Cap != unbounded_capacity) {
-			while(!hanged_send_tasks.empty()) {
-				auto& task = hanged_send_tasks.front();
-				if(!task.need_abort()) {
-					task.execute(false, v);
-				}
-				hanged_send_tasks.pop();
-			}
+			batch.close(hanged_send_tasks);
 		}
 	}
 
 	void try_recv(T& value, std::error_code& ec) override {
-		std::scoped_lock l(mutex_);
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(mutex_);
+		try_recv_locked(value, ec, batch);
+	}
 
+	void try_recv_locked(T& value, std::error_code& ec, detail::settle_batch<T>& batch) override {
 		if(is_closed_) {
 			ec = channel_errc::closed;
-		} else if(try_recv_(value)) {
+		} else if(try_recv_(value, batch)) {
 			ec = channel_errc::ok;
 		} else {
 			ec = channel_errc::exhausted;
 		}
 	}
 
-	void recv(std::stop_token token, T& value, std::error_code& ec) override {
-		std::unique_lock l(mutex_);
+	std::size_t try_recv_many(std::span<T> values, std::error_code& ec) override {
+		if constexpr(!IsContiguous) {
+			return chan<T>::try_recv_many(values, ec);
+		} else {
+			detail::settle_batch<T> batch;
+			std::scoped_lock        l(mutex_);
 
-		if(token.stop_requested()) [[unlikely]] {
-			ec = channel_errc::canceled;
-			return;
+			ec = channel_errc::ok;
+			if(values.empty()) {
+				return 0;
+			}
+			if(is_closed_) [[unlikely]] {
+				ec = channel_errc::closed;
+				return 0;
+			}
+
+			// Moved from the buffer in one step; the hanging senders refill it for the next one.
+			std::size_t n = 0;
+			while(n < values.size() && !buffer_.empty()) {
+				auto const region = buffer_.values();
+				auto const m      = std::min(values.size() - n, region.size());
+				std::move(region.begin(), region.begin() + m, values.begin() + n);
+				release_(m, batch);
+				n += m;
+			}
+
+			if(n < values.size()) {
+				ec = channel_errc::exhausted;
+			}
+			return n;
 		}
+	}
 
+	/**
+	 * @brief Returns the buffered values in place, contiguous from the front, without waiting.
+	 *
+	 * It is available if the buffer has `values()`, such as \ref mirrored_queue.
+	 * The values stay valid until they are released by \ref consume.
+	 * While a region is held, no other thread may receive from the channel.
+	 * The values that hanging senders have not moved into the buffer yet are not in the region.
+	 *
+	 * @param[out] ec \a ok if any value is buffered, \a exhausted if none is, or \a closed.
+	 */
+	std::span<T> recv_region(std::error_code& ec)
+	requires IsContiguous
+	{
+		std::scoped_lock l(mutex_);
 		if(is_closed_) [[unlikely]] {
 			ec = channel_errc::closed;
-			return;
+			return {};
 		}
 
-		if(try_recv_(value)) {
-			ec = channel_errc::ok;
+		auto const region = buffer_.values();
+		ec                = region.empty() ? channel_errc::exhausted : channel_errc::ok;
+		return region;
+	}
+
+	/**
+	 * @brief Releases the first \p n values of the region returned by \ref recv_region.
+	 *
+	 * The hanging senders move their values into the room in order.
+	 */
+	void consume(std::size_t n)
+	requires IsContiguous
+	{
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(mutex_);
+		if(is_closed_) [[unlikely]] {
 			return;
 		}
 
-		std::mutex done;
-		done.lock();
-
-		std::stop_source task_stop_source;
-		std::stop_token  task_token = task_stop_source.get_token();
+		assert(n <= buffer_.size());
+		release_(n, batch);
+	}
 
-		std::stop_callback on_cancel(token, [this, &ec, &done, &task_stop_source, task_token] {
-			std::unique_lock l(mutex_);
+	void recv(std::stop_token token, T& value, std::error_code& ec) override {
+		recv_(token, std::chrono::steady_clock::time_point::max(), value, ec);
+	}
 
-			// Task already processed so captured references are invalid.
-			if(task_token.stop_requested()) {
-				return;
-			}
+	void recv_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T& value, std::error_code& ec) override {
+		recv_(token, deadline, value, ec);
+	}
 
-			ec = channel_errc::canceled;
+	void recv_sched(
+	    std::function<bool()>          need_abort,
+	    std::function<void(bool, T&&)> on_settled,
+	    executor&                      ex) override {
+		detail::settle_batch<T> batch;
+		std::unique_lock        l(mutex_);
 
-			done.unlock();
-			task_stop_source.request_stop();
-		});
+		T value;
 
-		hanged_recv_tasks.emplace(recv_task{
-		    [task_token] { return task_token.stop_requested(); },
-		    [&value, &ec, &done, &task_stop_source](bool ok, T&& src) {
-			    // `mutex_` must be locked invoke this before.
-			    // It must not be invoked if `task_token` is expired.
+		if(is_closed_) [[unlikely]] {
+			if(!need_abort()) {
+				l.unlock();
+				on_settled(false, std::move(value));
+			}
+			return;
+		}
 
-			    // Prevent on_cancel to be proceed.
-			    task_stop_source.request_stop();
+		if(is_recv_ready_()) {
+			if(need_abort()) {
+				return;
+			}
 
-			    if(ok) [[likely]] {
-				    value = std::move(src);
-				    ec    = channel_errc::ok;
-			    } else {
-				    ec = channel_errc::closed;
-			    }
+			// Settled by the caller itself, so it is run inline rather than posted.
+			if(try_recv_(value, batch)) {
+				l.unlock();
+				batch.settle();
+				on_settled(true, std::move(value));
+				return;
+			}
 
-			    done.unlock();
-		    },
-		});
+			// The sender is gone in the meantime, so it waits for the next one.
+		}
 
-		l.unlock();
-		std::scoped_lock wait(done);
+		hang_recv_(*new detail::sched_waiter<T, std::function<void(bool, T&&)>>(
+		    std::move(need_abort),
+		    std::move(on_settled),
+		    ex));
 	}
 
-	void recv_sched(
-	    std::function<bool()>          need_abort,
-	    std::function<void(bool, T&&)> on_settled) override {
-		std::unique_lock l(mutex_);
-
-		T value;
+	bool recv_enqueue(detail::waiter<T>& task) override {
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(mutex_);
 
 		if(is_closed_) [[unlikely]] {
-			on_settled(false, std::move(value));
-			return;
+			settle_or_drop_(task, false, batch);
+			return true;
 		}
 
-		if(try_recv_(value)) {
-			on_settled(true, std::move(value));
-			return;
+		if(is_recv_ready_()) {
+			if(!task.claim()) {
+				task.drop();
+				return true;
+			}
+
+			if(!try_recv_(*task.elem(), batch)) {
+				return false;
+			}
+
+			batch.push_back(task, true);
+			return true;
 		}
 
-		hanged_recv_tasks.emplace(
-		    std::move(need_abort),
-		    std::move(on_settled));
+		hang_recv_(task);
+		return true;
+	}
+
+	void recv_dequeue(detail::waiter<T>& task) override {
+		std::scoped_lock l(mutex_);
+		recv_dequeue_locked(task);
+	}
+
+	void recv_enqueue_locked(detail::waiter<T>& task) override {
+		assert(not is_closed_);
+		hang_recv_(task);
+	}
+
+	void recv_dequeue_locked(detail::waiter<T>& task) override {
+		hanged_recv_tasks.erase(task);
 	}
 
 	void try_send(T const& value, std::error_code& ec) override {
@@ -190,29 +285,178 @@ class bounded_channel: public chan<T> {
 	}
 
 	void send(std::stop_token token, T const& value, std::error_code& ec) override {
-		return send_(token, value, ec);
+		return send_(token, std::chrono::steady_clock::time_point::max(), value, ec);
 	}
 
 	void send(std::stop_token token, T&& value, std::error_code& ec) override {
-		return send_(token, std::move(value), ec);
+		return send_(token, std::chrono::steady_clock::time_point::max(), std::move(value), ec);
+	}
+
+	void send_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T const& value, std::error_code& ec) override {
+		return send_(token, deadline, value, ec);
+	}
+
+	void send_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T&& value, std::error_code& ec) override {
+		return send_(token, deadline, std::move(value), ec);
 	}
 
 	void send_sched(
 	    T const&                  value,
 	    std::function<bool()>     need_abort,
-	    std::function<void(bool)> on_settled) override {
-		send_sched_(value, std::move(need_abort), std::move(on_settled));
+	    std::function<void(bool)> on_settled,
+	    executor&                 ex) override {
+		send_sched_(value, std::move(need_abort), std::move(on_settled), ex);
 	}
 
 	void send_sched(
 	    T&&                       value,
 	    std::function<bool()>     need_abort,
-	    std::function<void(bool)> on_settled) override {
-		send_sched_(std::move(value), std::move(need_abort), std::move(on_settled));
+	    std::function<void(bool)> on_settled,
+	    executor&                 ex) override {
+		send_sched_(std::move(value), std::move(need_abort), std::move(on_settled), ex);
+	}
+
+	bool send_enqueue(detail::waiter<T>& task) override {
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(mutex_);
+
+		if(is_closed_) [[unlikely]] {
+			settle_or_drop_(task, false, batch);
+			return true;
+		}
+
+		if(is_send_ready_()) {
+			if(!task.claim()) {
+				task.drop();
+				return true;
+			}
+
+			if(!try_send_(std::move(*task.elem()), batch)) {
+				return false;
+			}
+
+			batch.push_back(task, true);
+			return true;
+		}
+
+		hang_send_(task);
+		return true;
+	}
+
+	void send_dequeue(detail::waiter<T>& task) override {
+		std::scoped_lock l(mutex_);
+		send_dequeue_locked(task);
+	}
+
+	void try_send_locked(T&& value, std::error_code& ec, detail::settle_batch<T>& batch) override {
+		try_send_locked_(std::move(value), ec, batch);
+	}
+
+	void send_enqueue_locked(detail::waiter<T>& task) override {
+		assert(not is_closed_);
+		hang_send_(task);
+	}
+
+	void send_dequeue_locked(detail::waiter<T>& task) override {
+		hanged_send_tasks.erase(task);
+	}
+
+	void lock() override {
+		mutex_.lock();
+	}
+
+	void unlock() override {
+		mutex_.unlock();
+	}
+
+	bool watch_recv(detail::watcher& w) override {
+		std::scoped_lock l(mutex_);
+		if(!recv_watchers_.contains(w)) {
+			recv_watchers_.push_back(w);
+		}
+
+		return is_closed_ || is_recv_ready_();
+	}
+
+	void unwatch_recv(detail::watcher& w) override {
+		std::scoped_lock l(mutex_);
+		recv_watchers_.erase(w);
+	}
+
+	bool watch_send(detail::watcher& w) override {
+		std::scoped_lock l(mutex_);
+		if(!send_watchers_.contains(w)) {
+			send_watchers_.push_back(w);
+		}
+
+		return is_closed_ || is_send_ready_();
+	}
+
+	void unwatch_send(detail::watcher& w) override {
+		std::scoped_lock l(mutex_);
+		send_watchers_.erase(w);
 	}
 
    private:
-	bool try_recv_(T& value) {
+	static constexpr bool IsContiguous = Cap != 0 && Cap != unbounded_capacity && detail::contiguous_buffer<Buffer, T>;
+
+	/**
+	 * @brief Pops \p n values from the buffer and lets the hanging senders fill the room.
+	 */
+	void release_(std::size_t n, detail::settle_batch<T>& batch) {
+		for(std::size_t i = 0; i < n; ++i) {
+			buffer_.pop();
+		}
+
+		while(buffer_.size() < Cap) {
+			auto* const task = hanged_send_tasks.claim_front();
+			if(task == nullptr) {
+				send_watchers_.notify_all();
+				break;
+			}
+
+			buffer_.emplace(std::move(*task->elem()));
+			batch.push_back(*task, true);
+		}
+	}
+
+	static void settle_or_drop_(detail::waiter<T>& task, bool ok, detail::settle_batch<T>& batch) {
+		if(task.claim()) {
+			batch.push_back(task, ok);
+		} else {
+			task.drop();
+		}
+	}
+
+	void recv_(std::stop_token token, std::chrono::steady_clock::time_point deadline, T& value, std::error_code& ec) {
+		detail::settle_batch<T> batch;
+		std::unique_lock        l(mutex_);
+
+		if(token.stop_requested()) [[unlikely]] {
+			ec = channel_errc::canceled;
+			return;
+		}
+
+		if(is_closed_) [[unlikely]] {
+			ec = channel_errc::closed;
+			return;
+		}
+
+		if(try_recv_(value, batch)) {
+			ec = channel_errc::ok;
+			return;
+		}
+
+		// The sender moves its value directly into `value`.
+		detail::parker    parker;
+		detail::waiter<T> task(&value, &parker);
+		hang_recv_(task);
+
+		l.unlock();
+		ec = wait_(token, deadline, parker, task, hanged_recv_tasks);
+	}
+
+	bool try_recv_(T& value, detail::settle_batch<T>& batch) {
 		assert(not is_closed_);
 
 		if constexpr(Cap != 0) {
@@ -221,19 +465,13 @@ class bounded_channel: public chan<T> {
 				buffer_.pop();
 
 				if constexpr(Cap != unbounded_capacity) {
-					while(!hanged_send_tasks.empty()) {
+					if(auto* const task = hanged_send_tasks.claim_front()) {
 						assert(buffer_.size() < Cap);
 
-						auto const& task = hanged_send_tasks.front();
-						if(task.need_abort()) {
-							hanged_send_tasks.pop();
-							continue;
-						}
-
-						T& v = buffer_.emplace();
-						task.execute(true, v);
-
-						break;
+						buffer_.emplace(std::move(*task->elem()));
+						batch.push_back(*task, true);
+					} else {
+						send_watchers_.notify_all();
 					}
 				}
 
@@ -242,20 +480,10 @@ class bounded_channel: public chan<T> {
 		} else {
 			// If the capacity is not 0, there can be no hanged send tasks.
 			// If there is, the buffer is not empty, so the execution would have already been done before.
-			if(!hanged_send_tasks.empty()) {
-				while(!hanged_send_tasks.empty()) {
-					assert(buffer_.size() >= Cap);
-
-					auto const& task = hanged_send_tasks.front();
-					if(task.need_abort()) {
-						hanged_send_tasks.pop();
-						continue;
-					}
-
-					task.execute(true, value);
-					hanged_send_tasks.pop();
-					return true;
-				}
+			if(auto* const task = hanged_send_tasks.claim_front()) {
+				value = std::move(*task->elem());
+				batch.push_back(*task, true);
+				return true;
 			}
 		}
 
@@ -264,22 +492,15 @@ class bounded_channel: public chan<T> {
 
 	template<typename U>
 	requires std::same_as<std::remove_cvref_t<U>, T>
-	bool try_send_(U&& value) {
+	bool try_send_(U&& value, detail::settle_batch<T>& batch) {
 		assert(not is_closed_);
 
-		while(!hanged_recv_tasks.empty()) {
+		if(auto* const task = hanged_recv_tasks.claim_front()) {
 			assert(buffer_.empty());
 
-			auto const& task = hanged_recv_tasks.front();
-			if(task.need_abort()) {
-				hanged_recv_tasks.pop();
-				continue;
-			}
-
-			T v = std::forward<U>(value);
-			task.execute(true, std::move(v));
-
-			hanged_recv_tasks.pop();
+			// Hand over directly to the receiver's destination.
+			*task->elem() = std::forward<U>(value);
+			batch.push_back(*task, true);
 			return true;
 		}
 
@@ -292,24 +513,31 @@ class bounded_channel: public chan<T> {
 		}
 
 		buffer_.emplace(std::forward<U>(value));
+		recv_watchers_.notify_all();
 		return true;
 	}
 
 	template<typename U>
 	requires std::same_as<std::remove_cvref_t<U>, T>
 	void try_send_(U&& value, std::error_code& ec) {
-		std::scoped_lock l(mutex_);
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(mutex_);
+		try_send_locked_(std::forward<U>(value), ec, batch);
+	}
 
+	template<typename U>
+	requires std::same_as<std::remove_cvref_t<U>, T>
+	void try_send_locked_(U&& value, std::error_code& ec, detail::settle_batch<T>& batch) {
 		if(is_closed_) [[unlikely]] {
 			ec = channel_errc::closed;
 			return;
 		}
 
 		if constexpr(Cap == unbounded_capacity) {
-			try_send_(std::forward<U>(value));
+			try_send_(std::forward<U>(value), batch);
 			ec = channel_errc::ok;
 		} else {
-			if(try_send_(std::forward<U>(value))) {
+			if(try_send_(std::forward<U>(value), batch)) {
 				ec = channel_errc::ok;
 			} else {
 				ec = channel_errc::exhausted;
@@ -319,8 +547,9 @@ class bounded_channel: public chan<T> {
 
 	template<typename U>
 	requires std::same_as<std::remove_cvref_t<U>, T>
-	void send_(std::stop_token token, U&& value, std::error_code& ec) {
-		std::unique_lock l(mutex_);
+	void send_(std::stop_token token, std::chrono::steady_clock::time_point deadline, U&& value, std::error_code& ec) {
+		detail::settle_batch<T> batch;
+		std::unique_lock        l(mutex_);
 
 		if(token.stop_requested()) [[unlikely]] {
 			ec = channel_errc::canceled;
@@ -333,58 +562,63 @@ class bounded_channel: public chan<T> {
 		}
 
 		if constexpr(Cap == unbounded_capacity) {
-			try_send_(std::forward<U>(value));
+			try_send_(std::forward<U>(value), batch);
 			ec = channel_errc::ok;
 			return;
 		} else {
-			if(try_send_(std::forward<U>(value))) {
+			if(try_send_(std::forward<U>(value), batch)) {
 				ec = channel_errc::ok;
 				return;
 			}
-		}
-
-		std::mutex done;
-		done.lock();
-
-		std::stop_source task_stop_source;
-		std::stop_token  task_token = task_stop_source.get_token();
-
-		std::stop_callback on_cancel(token, [this, &ec, &done, &task_stop_source, task_token] {
-			std::unique_lock l(mutex_);
 
-			// Task already processed so captured references are invalid.
-			if(task_token.stop_requested()) {
-				return;
+			// The receiver moves the value directly from the source.
+			if constexpr(std::is_const_v<std::remove_reference_t<U>>) {
+				T v = value;
+				ec  = send_wait_(token, deadline, l, v);
+			} else {
+				ec = send_wait_(token, deadline, l, value);
 			}
+		}
+	}
 
-			ec = channel_errc::canceled;
+	std::error_code send_wait_(std::stop_token token, std::chrono::steady_clock::time_point deadline, std::unique_lock<std::mutex>& l, T& value) {
+		detail::parker    parker;
+		detail::waiter<T> task(&value, &parker);
+		hang_send_(task);
+
+		l.unlock();
+		return wait_(token, deadline, parker, task, hanged_send_tasks);
+	}
 
-			done.unlock();
-			task_stop_source.request_stop();
-		});
+	std::error_code wait_(
+	    std::stop_token                       token,
+	    std::chrono::steady_clock::time_point deadline,
+	    detail::parker&                       parker,
+	    detail::waiter<T>&                    task,
+	    detail::waiter_queue<T>&              tasks) {
+		{
+			std::stop_callback on_cancel(token, [&parker] {
+				if(parker.cancel()) {
+					parker.unpark();
+				}
+			});
 
-		hanged_send_tasks.emplace(send_task{
-		    [task_token] { return task_token.stop_requested(); },
-		    [&value, &ec, &done, &task_stop_source](bool ok, T& dst) {
-			    // `mutex_` must be locked invoke this before.
-			    // It must not be invoked if `task_token` is expired.
+			parker.park_until(deadline);
+		}
 
-			    // Prevent on_cancel to be proceed.
-			    task_stop_source.request_stop();
+		if(parker.is_claimed_by(&task)) [[likely]] {
+			return task.ok() ? channel_errc::ok : channel_errc::closed;
+		}
 
-			    if(ok) [[likely]] {
-				    dst = std::move(value);
-				    ec  = channel_errc::ok;
-			    } else {
-				    ec = channel_errc::closed;
-			    }
+		// Nobody can claim the task anymore, but it may still be queued.
+		std::scoped_lock l(mutex_);
+		tasks.erase(task);
 
-			    done.unlock();
-		    },
-		});
+		if(parker.is_timed_out()) {
+			return channel_errc::timeout;
+		}
 
-		l.unlock();
-		std::scoped_lock wait(done);
+		return channel_errc::canceled;
 	}
 
 	template<typename U>
@@ -392,44 +626,87 @@ class bounded_channel: public chan<T> {
 	void send_sched_(
 	    U&&                       value,
 	    std::function<bool()>     need_abort,
-	    std::function<void(bool)> on_settled) {
-		std::unique_lock l(mutex_);
+	    std::function<void(bool)> on_settled,
+	    executor&                 ex) {
+		detail::settle_batch<T> batch;
+		std::unique_lock        l(mutex_);
 
 		if(is_closed_) [[unlikely]] {
-			on_settled(false);
+			if(!need_abort()) {
+				l.unlock();
+				on_settled(false);
+			}
 			return;
 		}
 
-		if constexpr(Cap == unbounded_capacity) {
-			try_send_(std::forward<U>(value));
-			on_settled(true);
-			return;
-		} else if constexpr(Cap == 0) {
-			if(try_send_(std::forward<U>(value))) {
+		if(is_send_ready_()) {
+			if(need_abort()) {
+				return;
+			}
+
+			// Settled by the caller itself, so it is run inline rather than posted.
+			if(try_send_(std::forward<U>(value), batch)) {
+				l.unlock();
+				batch.settle();
 				on_settled(true);
 				return;
 			}
+
+			// The receiver is gone in the meantime, so it waits for the next one.
 		}
 
-		hanged_send_tasks.emplace(send_task{
+		// The task owns the value so it outlives the caller's one.
+		hang_send_(*new detail::sched_waiter<T, std::function<void(bool)>>(
 		    std::move(need_abort),
-		    [&value, f = std::move(on_settled)](bool ok, T& dst) {
-			    if(ok) {
-				    dst = std::forward<U>(value);
-			    }
+		    std::move(on_settled),
+		    ex,
+		    std::forward<U>(value)));
+	}
+
+	void hang_recv_(detail::waiter<T>& task) {
+		hanged_recv_tasks.push_back(task);
+		send_watchers_.notify_all();
+	}
+
+	void hang_send_(detail::waiter<T>& task) {
+		hanged_send_tasks.push_back(task);
+		recv_watchers_.notify_all();
+	}
+
+	bool is_recv_ready_() {
+		if constexpr(Cap != 0) {
+			if(!buffer_.empty()) {
+				return true;
+			}
+		}
+
+		hanged_send_tasks.prune();
+		return !hanged_send_tasks.empty();
+	}
+
+	bool is_send_ready_() {
+		if constexpr(Cap == unbounded_capacity) {
+			return true;
+		} else {
+			if(buffer_.size() < Cap) {
+				return true;
+			}
 
-			    f(ok);
-		    },
-		});
+			hanged_recv_tasks.prune();
+			return !hanged_recv_tasks.empty();
+		}
 	}
 
 	mutable std::mutex mutex_;
 
 	bool          is_closed_ = false;
-	std::queue<T> buffer_;
+	Buffer        buffer_;
+
+	mutable detail::waiter_queue<T> hanged_recv_tasks;
+	mutable detail::waiter_queue<T> hanged_send_tasks;
 
-	mutable std::queue<recv_task> hanged_recv_tasks;
-	mutable std::queue<send_task> hanged_send_tasks;
+	detail::watcher_list recv_watchers_;
+	detail::watcher_list send_watchers_;
 };
 
 template<typename T>
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <stop_token>
+#include <system_error>
+#include <utility>
+
+#include "lesomnus/channel/detail/waiter.hpp"
+#include "lesomnus/channel/error.hpp"
+#include "lesomnus/channel/executor.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+template<typename T>
+class receiver;
+
+template<typename T>
+class sender;
+
+namespace detail {
+
+/**
+ * @brief Resumes the suspended coroutine on the executor once its operation is settled.
+ *
+ * The operation may be settled while the coroutine is being suspended,
+ * then the coroutine is not suspended at all.
+ * Instead of a coroutine, it can resume any continuation given as a function.
+ */
+class resumer final: public work {
+   public:
+	explicit resumer(executor& ex) noexcept
+	    : ex_(&ex) { }
+
+	/**
+	 * @brief Suspends the coroutine after \p hang hangs its operation.
+	 *
+	 * @return False if the operation is settled in the meantime
+	 *         so the coroutine must not be suspended.
+	 */
+	template<typename F>
+	bool suspend(std::coroutine_handle<> h, F&& hang) {
+		return suspend([](void* p) { std::coroutine_handle<>::from_address(p).resume(); }, h.address(), std::forward<F>(hang));
+	}
+
+	/**
+	 * @brief Same as above but \p on_resumed is invoked with \p arg instead of resuming a coroutine.
+	 */
+	template<typename F>
+	bool suspend(void (*on_resumed)(void*), void* arg, F&& hang) {
+		on_resumed_ = on_resumed;
+		arg_        = arg;
+		state_.store(state::suspending, std::memory_order_relaxed);
+		std::forward<F>(hang)();
+
+		auto expected = state::suspending;
+		return state_.compare_exchange_strong(expected, state::suspended, std::memory_order_acq_rel, std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Resumes the coroutine.
+	 *
+	 * It must be called once the result of the operation is written.
+	 */
+	void resume() {
+		auto expected = state::suspending;
+		if(state_.compare_exchange_strong(expected, state::settled, std::memory_order_acq_rel, std::memory_order_acquire)) {
+			return;
+		}
+
+		ex_->post(*this);
+	}
+
+	void run() override {
+		on_resumed_(arg_);
+	}
+
+   private:
+	enum class state : std::uint8_t {
+		suspending,
+		suspended,
+		settled,
+	};
+
+	executor* ex_;
+
+	void (*on_resumed_)(void*) = nullptr;
+	void* arg_                 = nullptr;
+
+	std::atomic<state> state_ = state::suspending;
+};
+
+/**
+ * @brief Waiter of a single asynchronous operation embedded in the coroutine frame.
+ */
+template<typename T, typename Derived>
+class async_waiter: public waiter<T> {
+   public:
+	async_waiter(T* elem, std::stop_token token, std::error_code& ec, executor& ex) noexcept
+	    : waiter<T>(elem)
+	    , token_(std::move(token))
+	    , ec_(ec)
+	    , resumer_(ex) { }
+
+	bool await_suspend(std::coroutine_handle<> h) {
+		return suspend([](void* p) { std::coroutine_handle<>::from_address(p).resume(); }, h.address());
+	}
+
+	/**
+	 * @brief Hangs the operation and invokes \p on_settled with \p arg once it is settled.
+	 *
+	 * @return False if it is settled in the meantime so \p on_settled is not invoked.
+	 */
+	bool suspend(void (*on_settled)(void*), void* arg) {
+		return resumer_.suspend(on_settled, arg, [this] {
+			auto& self = static_cast<Derived&>(*this);
+			while(!self.enqueue_()) {
+				// It claimed itself but the peer is gone, so nobody else holds it.
+				is_claimed_.store(false, std::memory_order_relaxed);
+			}
+
+			if(token_.stop_possible()) {
+				on_cancel_.emplace(token_, canceler{this});
+			}
+		});
+	}
+
+	bool await_resume() noexcept {
+		on_cancel_.reset();
+		return ec_ == channel_errc::ok;
+	}
+
+   protected:
+	bool is_abandoned_() override {
+		return is_claimed_.load(std::memory_order_acquire);
+	}
+
+	bool claim_() override {
+		return !is_claimed_.exchange(true, std::memory_order_acq_rel);
+	}
+
+	void settle_(bool ok) override {
+		ec_ = ok ? channel_errc::ok : channel_errc::closed;
+		resumer_.resume();
+	}
+
+	std::stop_token  token_;
+	std::error_code& ec_;
+
+   private:
+	struct canceler {
+		async_waiter* self;
+
+		void operator()() const {
+			self->cancel_();
+		}
+	};
+
+	void cancel_() {
+		if(is_claimed_.exchange(true, std::memory_order_acq_rel)) {
+			return;
+		}
+
+		static_cast<Derived&>(*this).dequeue_();
+		ec_ = channel_errc::canceled;
+		resumer_.resume();
+	}
+
+	std::atomic<bool> is_claimed_ = false;
+	resumer           resumer_;
+
+	std::optional<std::stop_callback<canceler>> on_cancel_;
+};
+
+/**
+ * @brief Awaitable made by `async_recv`.
+ *
+ * The received value is moved directly into the destination given by the caller.
+ */
+template<typename T>
+class recv_awaiter final: public async_waiter<T, recv_awaiter<T>> {
+   public:
+	recv_awaiter(receiver<T>& chan, std::stop_token token, T& value, std::error_code& ec, executor& ex) noexcept
+	    : async_waiter<T, recv_awaiter<T>>(&value, std::move(token), ec, ex)
+	    , chan_(chan) { }
+
+	recv_awaiter(receiver<T>& chan, std::stop_token token, T& value, executor& ex) noexcept
+	    : recv_awaiter(chan, std::move(token), value, own_ec_, ex) { }
+
+	bool await_ready() {
+		if(this->token_.stop_requested()) [[unlikely]] {
+			this->ec_ = channel_errc::canceled;
+			return true;
+		}
+
+		chan_.try_recv(*this->elem(), this->ec_);
+		return this->ec_ != channel_errc::exhausted;
+	}
+
+   private:
+	friend class async_waiter<T, recv_awaiter<T>>;
+
+	bool enqueue_() {
+		return chan_.recv_enqueue(*this);
+	}
+
+	void dequeue_() {
+		chan_.recv_dequeue(*this);
+	}
+
+	receiver<T>& chan_;
+
+	// Used if the caller does not need the error.
+	std::error_code own_ec_;
+};
+
+/**
+ * @brief Awaitable made by `async_send`.
+ *
+ * It holds the value to send so the value outlives the caller's one.
+ */
+template<typename T>
+class send_awaiter final: public async_waiter<T, send_awaiter<T>> {
+   public:
+	template<typename U>
+	send_awaiter(sender<T>& chan, std::stop_token token, U&& value, std::error_code& ec, executor& ex)
+	    : async_waiter<T, send_awaiter<T>>(&value_, std::move(token), ec, ex)
+	    , chan_(chan)
+	    , value_(std::forward<U>(value)) { }
+
+	template<typename U>
+	send_awaiter(sender<T>& chan, std::stop_token token, U&& value, executor& ex)
+	    : send_awaiter(chan, std::move(token), std::forward<U>(value), own_ec_, ex) { }
+
+	bool await_ready() {
+		if(this->token_.stop_requested()) [[unlikely]] {
+			this->ec_ = channel_errc::canceled;
+			return true;
+		}
+
+		chan_.try_send(std::move(value_), this->ec_);
+		return this->ec_ != channel_errc::exhausted;
+	}
+
+   private:
+	friend class async_waiter<T, send_awaiter<T>>;
+
+	bool enqueue_() {
+		return chan_.send_enqueue(*this);
+	}
+
+	void dequeue_() {
+		chan_.send_dequeue(*this);
+	}
+
+	sender<T>& chan_;
+
+	T value_;
+
+	// Used if the caller does not need the error.
+	std::error_code own_ec_;
+};
+
+}  // namespace detail
+}  // namespace channel
+}  // namespace lesomnus
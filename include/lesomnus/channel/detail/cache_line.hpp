@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lesomnus {
+namespace channel {
+namespace detail {
+
+/**
+ * @brief Alignment that keeps the data written by different threads off the same cache line.
+ */
+inline constexpr std::size_t CacheLineSize = 64;
+
+}  // namespace detail
+}  // namespace channel
+}  // namespace lesomnus
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lesomnus {
+namespace channel {
+namespace detail {
+
+/**
+ * @brief Hints the processor that the thread is spinning.
+ */
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief Sleeps while \p word is \p expected, until it is woken up or \p deadline is reached.
+ *
+ * The futex is not private, so it works on the memory shared between the processes.
+ * It may return spuriously.
+ *
+ * @return False if \p deadline is reached.
+ */
+inline bool futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::steady_clock::time_point deadline) noexcept {
+	static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+	timespec  ts{};
+	timespec* timeout = nullptr;
+	if(deadline != std::chrono::steady_clock::time_point::max()) {
+		// The steady clock is CLOCK_MONOTONIC that FUTEX_WAIT_BITSET takes as an absolute time.
+		auto const ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+
+		ts.tv_sec  = static_cast<std::time_t>(ns / 1'000'000'000);
+		ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+		timeout    = &ts;
+	}
+
+	auto const rc = ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_BITSET, expected, timeout, nullptr, FUTEX_BITSET_MATCH_ANY);
+	return rc == 0 || errno != ETIMEDOUT;
+}
+
+/**
+ * @brief Wakes up all the threads sleeping on \p word in any process.
+ */
+inline void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept {
+	::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+}  // namespace detail
+}  // namespace channel
+}  // namespace lesomnus
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <semaphore>
+#include <utility>
+
+#include "lesomnus/channel/timer.hpp"
+
+namespace lesomnus {
+namespace channel {
+namespace detail {
+
+/**
+ * @brief User-space thread, such as a fiber, that the blocking operations suspend instead of the OS thread.
+ *
+ * A runtime of the user-space threads sets \ref current_suspendable while it runs one.
+ */
+class suspendable {
+   public:
+	/**
+	 * @brief Switches out of the running user-space thread.
+	 *
+	 * @param after Invoked with \p arg on the OS thread once it is switched out.
+	 */
+	virtual void suspend(void (*after)(void*), void* arg) = 0;
+
+	/**
+	 * @brief Makes the suspended user-space thread run again.
+	 *
+	 * It can be called from any thread.
+	 */
+	virtual void resume() = 0;
+
+   protected:
+	~suspendable() = default;
+};
+
+inline thread_local suspendable* current_suspendable = nullptr;
+
+/**
+ * @brief Binary semaphore that suspends the user-space thread if it is made on one.
+ *
+ * Otherwise, it blocks the OS thread.
+ */
+class park_semaphore {
+   public:
+	park_semaphore() noexcept
+	    : self_(current_suspendable) { }
+
+	park_semaphore(park_semaphore const& other) = delete;
+	park_semaphore(park_semaphore&& other)      = delete;
+
+	park_semaphore& operator=(park_semaphore const& other) = delete;
+	park_semaphore& operator=(park_semaphore&& other)      = delete;
+
+	void acquire() {
+		if(self_ == nullptr) {
+			sem_.acquire();
+			return;
+		}
+
+		if(try_acquire()) {
+			return;
+		}
+
+		// Marked as suspended once it is switched out, so it is never resumed while it is running.
+		self_->suspend(
+		    [](void* arg) {
+			    auto&       self     = *static_cast<park_semaphore*>(arg);
+			    auto* const fiber    = self.self_;
+			    auto        expected = state::idle;
+			    if(!self.state_.compare_exchange_strong(expected, state::suspended, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+				    // Released in the meantime.
+				    fiber->resume();
+			    }
+		    },
+		    this);
+
+		state_.store(state::idle, std::memory_order_relaxed);
+	}
+
+	bool try_acquire() noexcept {
+		if(self_ == nullptr) {
+			return sem_.try_acquire();
+		}
+
+		auto expected = state::released;
+		return state_.compare_exchange_strong(expected, state::idle, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Blocks the OS thread until it is released or \p deadline is exceeded.
+	 *
+	 * It must not be made on a user-space thread.
+	 *
+	 * @return False if \p deadline is exceeded.
+	 */
+	bool try_acquire_until(std::chrono::steady_clock::time_point deadline) {
+		assert(self_ == nullptr);
+		return sem_.try_acquire_until(deadline);
+	}
+
+	[[nodiscard]] bool is_suspendable() const noexcept {
+		return self_ != nullptr;
+	}
+
+	void release() {
+		if(self_ == nullptr) {
+			sem_.release();
+			return;
+		}
+
+		auto* const self = self_;
+		if(state_.exchange(state::released, std::memory_order_acq_rel) == state::suspended) {
+			self->resume();
+		}
+	}
+
+   private:
+	enum class state : std::uint8_t {
+		idle,
+		released,
+		suspended,
+	};
+
+	suspendable* self_;
+
+	std::binary_semaphore sem_{0};
+	std::atomic<state>    state_ = state::idle;
+};
+
+/**
+ * @brief One-shot rendezvous point of a blocked operation.
+ *
+ * Exactly one party claims the parker; the one who claimed it settles the operation
+ * and then unparks the blocked thread, or the blocked fiber if it is made on a fiber.
+ */
+class parker {
+   public:
+	/**
+	 * @brief Claims the parker on behalf of \p by.
+	 *
+	 * @param by Identity of the claimer.
+	 * @return False if the parker is already claimed.
+	 */
+	bool claim(void const* by) noexcept {
+		void const* expected = nullptr;
+		return owner_.compare_exchange_strong(expected, by, std::memory_order_acq_rel, std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Claims the parker on behalf of the blocked thread itself.
+	 *
+	 * @return False if the parker is already claimed.
+	 */
+	bool cancel() noexcept {
+		return claim(this);
+	}
+
+	/**
+	 * @brief Claims the parker on behalf of the blocked thread whose deadline is exceeded.
+	 *
+	 * @return False if the parker is already claimed.
+	 */
+	bool time_out() noexcept {
+		return claim(&timed_out_);
+	}
+
+	[[nodiscard]] bool is_claimed() const noexcept {
+		return owner_.load(std::memory_order_acquire) != nullptr;
+	}
+
+	[[nodiscard]] bool is_claimed_by(void const* by) const noexcept {
+		return owner_.load(std::memory_order_acquire) == by;
+	}
+
+	[[nodiscard]] bool is_canceled() const noexcept {
+		return is_claimed_by(this);
+	}
+
+	[[nodiscard]] bool is_timed_out() const noexcept {
+		return is_claimed_by(&timed_out_);
+	}
+
+	/**
+	 * @brief Blocks until \ref unpark is called.
+	 */
+	void park() {
+		sem_.acquire();
+	}
+
+	/**
+	 * @brief Blocks until \ref unpark is called or \p deadline is exceeded.
+	 *
+	 * A blocked thread times out natively in the semaphore.
+	 * A suspended user-space thread has no such wait, so its deadline is kept by the global \ref timer_service
+	 * as `after` is, which claims the parker by \ref time_out and unparks it.
+	 * Once it returns, the parker is claimed by someone.
+	 */
+	void park_until(std::chrono::steady_clock::time_point deadline) {
+		if(deadline == std::chrono::steady_clock::time_point::max()) {
+			park();
+			return;
+		}
+
+		if(!sem_.is_suspendable()) {
+			if(!sem_.try_acquire_until(deadline) && !time_out()) {
+				// Someone claimed it just before the deadline
+				// so wait for them to finish settling it.
+				park();
+			}
+			return;
+		}
+
+		timer<expirer> t(expirer{this});
+		timer_service::global().arm(t, deadline);
+		park();
+	}
+
+	/**
+	 * @brief Wakes up the parked thread.
+	 *
+	 * The parker must not be accessed after this call since the parked thread owns it.
+	 */
+	void unpark() {
+		sem_.release();
+	}
+
+   private:
+	struct expirer {
+		parker* self;
+
+		void operator()() const {
+			if(self->time_out()) {
+				self->unpark();
+			}
+		}
+	};
+
+	static constexpr char timed_out_ = 0;
+
+	std::atomic<void const*> owner_ = nullptr;
+	park_semaphore           sem_;
+};
+
+}  // namespace detail
+}  // namespace channel
+}  // namespace lesomnus
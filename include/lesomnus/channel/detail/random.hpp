@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace lesomnus {
+namespace channel {
+namespace detail {
+
+/**
+ * @brief Returns a pseudo-random number from the generator of the current thread.
+ *
+ * It is not cryptographically secure; it is for spreading the choices cheaply.
+ */
+inline std::uint64_t fast_rand() noexcept {
+	thread_local std::uint64_t state = [] {
+		// Threads started at the same time get different seeds from their stacks.
+		std::uint64_t seed = 0;
+		return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())
+		       ^ reinterpret_cast<std::uintptr_t>(&seed);
+	}();
+
+	// splitmix64
+	std::uint64_t z = (state += 0x9E3779B97F4A7C15);
+	z               = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+	z               = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+	return z ^ (z >> 31);
+}
+
+/**
+ * @brief Returns a pseudo-random number in [0, n).
+ */
+inline std::size_t fast_range(std::size_t n) noexcept {
+	return static_cast<std::size_t>((fast_rand() >> 32) * n >> 32);
+}
+
+}  // namespace detail
+}  // namespace channel
+}  // namespace lesomnus
@@ -0,0 +1,417 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "lesomnus/channel/detail/parker.hpp"
+#include "lesomnus/channel/executor.hpp"
+
+namespace lesomnus {
+namespace channel {
+namespace detail {
+
+template<typename T>
+class waiter_queue;
+
+template<typename T>
+class settle_batch;
+
+/**
+ * @brief Operation hanging on a channel.
+ *
+ * For receivers, \ref elem is the destination the value is moved into;
+ * for senders, it is the source the value is moved from.
+ * So the peer hands the value over with a single move.
+ *
+ * If the waiter is made with a \ref parker, it is claimed and woken up without any indirection.
+ * Otherwise, the virtual hooks decide it.
+ */
+template<typename T>
+class waiter {
+   public:
+	explicit waiter(T* elem, parker* p = nullptr) noexcept
+	    : elem_(elem)
+	    , parker_(p) { }
+
+	waiter(waiter const& other) = delete;
+	waiter(waiter&& other)      = delete;
+
+	waiter& operator=(waiter const& other) = delete;
+	waiter& operator=(waiter&& other)      = delete;
+
+	virtual ~waiter() = default;
+
+	/**
+	 * @brief Tests if the waiter no longer needs to be settled.
+	 */
+	[[nodiscard]] bool is_abandoned() {
+		if(parker_ != nullptr) {
+			return parker_->is_claimed();
+		}
+
+		return is_abandoned_();
+	}
+
+	/**
+	 * @brief Takes the right to settle the waiter.
+	 *
+	 * `mutex_` of the channel must be locked.
+	 * If it returns true, the waiter must be settled by the caller,
+	 * otherwise, it must be dropped.
+	 */
+	[[nodiscard]] bool claim() {
+		if(parker_ != nullptr) {
+			return parker_->claim(this);
+		}
+
+		return claim_();
+	}
+
+	/**
+	 * @brief Completes the claimed waiter.
+	 *
+	 * The waiter must not be accessed after this call.
+	 *
+	 * @param ok False if the channel is closed.
+	 */
+	void settle(bool ok) {
+		ok_ = ok;
+		if(parker_ != nullptr) {
+			parker_->unpark();
+			return;
+		}
+
+		settle_(ok);
+	}
+
+	/**
+	 * @brief Releases the waiter that is failed to claim.
+	 *
+	 * The waiter must not be accessed after this call.
+	 */
+	void drop() {
+		if(parker_ != nullptr) {
+			return;
+		}
+
+		drop_();
+	}
+
+	[[nodiscard]] T* elem() const noexcept {
+		return elem_;
+	}
+
+	[[nodiscard]] bool ok() const noexcept {
+		return ok_;
+	}
+
+	/**
+	 * @brief Tests if nobody but the channel removes the waiter once it hangs,
+	 * so it can be claimed after the channel is unlocked.
+	 */
+	[[nodiscard]] bool is_self_owned() const noexcept {
+		return parker_ == nullptr && is_self_owned_();
+	}
+
+   protected:
+	virtual bool is_self_owned_() const noexcept {
+		return false;
+	}
+
+	virtual bool is_abandoned_() {
+		return false;
+	}
+
+	virtual bool claim_() {
+		return true;
+	}
+
+	virtual void settle_(bool) { }
+
+	virtual void drop_() { }
+
+   private:
+	friend class waiter_queue<T>;
+	friend class settle_batch<T>;
+
+	waiter* prev_   = nullptr;
+	waiter* next_   = nullptr;
+	bool    linked_ = false;
+
+	T*      elem_;
+	parker* parker_;
+	bool    ok_         = false;
+	bool    is_claimed_ = true;
+};
+
+/**
+ * @brief Intrusive FIFO of the waiters.
+ *
+ * Waiters can be removed from the middle in constant time.
+ */
+template<typename T>
+class waiter_queue {
+   public:
+	[[nodiscard]] bool empty() const noexcept {
+		return head_ == nullptr;
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return size_;
+	}
+
+	[[nodiscard]] waiter<T>* front() const noexcept {
+		return head_;
+	}
+
+	void push_back(waiter<T>& w) noexcept {
+		assert(not w.linked_);
+
+		w.prev_   = tail_;
+		w.next_   = nullptr;
+		w.linked_ = true;
+		if(tail_ == nullptr) {
+			head_ = &w;
+		} else {
+			tail_->next_ = &w;
+		}
+
+		tail_ = &w;
+		++size_;
+	}
+
+	/**
+	 * @brief Removes the first waiter.
+	 *
+	 * @return The removed waiter or \a nullptr if it is empty.
+	 */
+	waiter<T>* pop_front() noexcept {
+		waiter<T>* const w = head_;
+		if(w != nullptr) {
+			erase(*w);
+		}
+
+		return w;
+	}
+
+	/**
+	 * @brief Removes the waiter.
+	 *
+	 * It does nothing if the waiter is not queued.
+	 */
+	void erase(waiter<T>& w) noexcept {
+		if(!w.linked_) {
+			return;
+		}
+
+		if(w.prev_ == nullptr) {
+			head_ = w.next_;
+		} else {
+			w.prev_->next_ = w.next_;
+		}
+		if(w.next_ == nullptr) {
+			tail_ = w.prev_;
+		} else {
+			w.next_->prev_ = w.prev_;
+		}
+
+		w.prev_   = nullptr;
+		w.next_   = nullptr;
+		w.linked_ = false;
+		--size_;
+	}
+
+	/**
+	 * @brief Pops abandoned waiters from the front.
+	 */
+	void prune() {
+		while(!empty()) {
+			if(!head_->is_abandoned()) {
+				break;
+			}
+
+			pop_front()->drop();
+		}
+	}
+
+	/**
+	 * @brief Pops the first waiter that could be claimed.
+	 *
+	 * Waiters failed to claim are dropped.
+	 *
+	 * @return The claimed waiter or \a nullptr if there is no such waiter.
+	 */
+	waiter<T>* claim_front() {
+		while(!empty()) {
+			waiter<T>* const w = pop_front();
+			if(w->claim()) {
+				return w;
+			}
+
+			w->drop();
+		}
+
+		return nullptr;
+	}
+
+	/**
+	 * @brief Drops all the waiters.
+	 */
+	void clear() {
+		while(!empty()) {
+			pop_front()->drop();
+		}
+	}
+
+   private:
+	waiter<T>* head_ = nullptr;
+	waiter<T>* tail_ = nullptr;
+
+	std::size_t size_ = 0;
+};
+
+/**
+ * @brief Claimed waiters whose values are moved but not settled yet.
+ *
+ * Channels detach the waiters into the batch with the lock held,
+ * and settle them once the lock is released, so no wakeup or settled callback runs in the critical section.
+ * Claiming and dropping a \ref sched_waiter on a match still run with the lock held; see \ref sched_waiter.
+ * It settles the rest on destruction, so it must be declared before the lock.
+ */
+template<typename T>
+class settle_batch {
+   public:
+	settle_batch() = default;
+
+	settle_batch(settle_batch const& other) = delete;
+	settle_batch(settle_batch&& other)      = delete;
+
+	settle_batch& operator=(settle_batch const& other) = delete;
+	settle_batch& operator=(settle_batch&& other)      = delete;
+
+	~settle_batch() {
+		settle();
+	}
+
+	[[nodiscard]] bool empty() const noexcept {
+		return queue_.empty();
+	}
+
+	/**
+	 * @brief Adds the claimed waiter.
+	 *
+	 * @param ok False if the channel is closed.
+	 */
+	void push_back(waiter<T>& w, bool ok) noexcept {
+		w.ok_         = ok;
+		w.is_claimed_ = true;
+		queue_.push_back(w);
+	}
+
+	/**
+	 * @brief Detaches all the waiters of the closed channel to be settled with `false`.
+	 *
+	 * The waiters that own themselves are claimed, or dropped, when the batch is settled,
+	 * so no user code of theirs runs with the lock held.
+	 * The others may be removed by their owners once the lock is released, so they are claimed now.
+	 */
+	void close(waiter_queue<T>& waiters) {
+		while(auto* const w = waiters.pop_front()) {
+			if(w->is_self_owned()) {
+				w->ok_         = false;
+				w->is_claimed_ = false;
+				queue_.push_back(*w);
+			} else if(w->claim()) {
+				push_back(*w, false);
+			} else {
+				w->drop();
+			}
+		}
+	}
+
+	/**
+	 * @brief Settles the waiters in order they are added.
+	 */
+	void settle() {
+		while(auto* const w = queue_.pop_front()) {
+			if(w->is_claimed_ || w->claim()) {
+				w->settle(w->ok_);
+			} else {
+				w->drop();
+			}
+		}
+	}
+
+   private:
+	waiter_queue<T> queue_;
+};
+
+/**
+ * @brief Waiter made by `recv_sched` and `send_sched`.
+ *
+ * It owns the value and deletes itself once it is settled or dropped.
+ * The callback is posted to the executor by the settling thread,
+ * so the settling thread does not run it unless the executor runs it inline.
+ * Its `need_abort` is called on claim and it is deleted on drop with the channel locked on a match.
+ * Nobody else removes it once it hangs, so a closing channel claims and drops it after it is unlocked.
+ *
+ * @tparam F `void(bool, T&&)` for receivers, `void(bool)` for senders.
+ */
+template<typename T, typename F>
+class sched_waiter final
+    : public waiter<T>
+    , public work {
+   public:
+	template<typename U = T>
+	sched_waiter(std::function<bool()> need_abort, F on_settled, executor& ex, U&& value = T{})
+	    : waiter<T>(&value_)
+	    , need_abort_(std::move(need_abort))
+	    , on_settled_(std::move(on_settled))
+	    , ex_(ex)
+	    , value_(std::forward<U>(value)) { }
+
+	void run() override {
+		if constexpr(std::is_invocable_v<F, bool, T&&>) {
+			on_settled_(this->ok(), std::move(value_));
+		} else {
+			on_settled_(this->ok());
+		}
+
+		delete this;
+	}
+
+   protected:
+	bool is_self_owned_() const noexcept override {
+		return true;
+	}
+
+	bool is_abandoned_() override {
+		return need_abort_();
+	}
+
+	bool claim_() override {
+		return !need_abort_();
+	}
+
+	void settle_(bool) override {
+		ex_.post(*this);
+	}
+
+	void drop_() override {
+		delete this;
+	}
+
+   private:
+	std::function<bool()> need_abort_;
+
+	F         on_settled_;
+	executor& ex_;
+	T         value_;
+};
+
+}  // namespace detail
+}  // namespace channel
+}  // namespace lesomnus
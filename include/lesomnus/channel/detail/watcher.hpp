@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cassert>
+
+namespace lesomnus {
+namespace channel {
+namespace detail {
+
+class watcher_list;
+
+/**
+ * @brief Persistent observer of the readiness of a channel.
+ *
+ * Unlike \ref waiter, it stays registered after it is notified.
+ * It is registered in at most one \ref watcher_list at a time.
+ */
+class watcher {
+   public:
+	watcher() = default;
+
+	watcher(watcher const& other) = delete;
+	watcher(watcher&& other)      = delete;
+
+	watcher& operator=(watcher const& other) = delete;
+	watcher& operator=(watcher&& other)      = delete;
+
+	/**
+	 * @brief Invoked with `mutex_` of the channel locked when the channel becomes ready.
+	 *
+	 * It may be invoked even if the channel is not ready anymore.
+	 */
+	virtual void notify() = 0;
+
+   protected:
+	~watcher() = default;
+
+   private:
+	friend class watcher_list;
+
+	watcher*      prev_  = nullptr;
+	watcher*      next_  = nullptr;
+	watcher_list* owner_ = nullptr;
+};
+
+/**
+ * @brief Intrusive list of the watchers.
+ */
+class watcher_list {
+   public:
+	[[nodiscard]] bool empty() const noexcept {
+		return head_ == nullptr;
+	}
+
+	/**
+	 * @brief Tests if the watcher is registered in this list, not in any other.
+	 */
+	[[nodiscard]] bool contains(watcher const& w) const noexcept {
+		return w.owner_ == this;
+	}
+
+	void push_back(watcher& w) noexcept {
+		assert(w.owner_ == nullptr);
+
+		w.prev_  = tail_;
+		w.next_  = nullptr;
+		w.owner_ = this;
+		if(tail_ == nullptr) {
+			head_ = &w;
+		} else {
+			tail_->next_ = &w;
+		}
+
+		tail_ = &w;
+	}
+
+	/**
+	 * @brief Removes the watcher.
+	 *
+	 * It does nothing if the watcher is not registered.
+	 * It must not be registered in another list.
+	 */
+	void erase(watcher& w) noexcept {
+		assert(w.owner_ == nullptr || w.owner_ == this);
+		if(w.owner_ != this) {
+			return;
+		}
+
+		if(w.prev_ == nullptr) {
+			head_ = w.next_;
+		} else {
+			w.prev_->next_ = w.next_;
+		}
+		if(w.next_ == nullptr) {
+			tail_ = w.prev_;
+		} else {
+			w.next_->prev_ = w.prev_;
+		}
+
+		w.prev_  = nullptr;
+		w.next_  = nullptr;
+		w.owner_ = nullptr;
+	}
+
+	void notify_all() {
+		for(auto* w = head_; w != nullptr; w = w->next_) {
+			w->notify();
+		}
+	}
+
+   private:
+	watcher* head_ = nullptr;
+	watcher* tail_ = nullptr;
+};
+
+}  // namespace detail
+}  // namespace channel
+}  // namespace lesomnus
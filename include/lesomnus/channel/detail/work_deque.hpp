@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "lesomnus/channel/executor.hpp"
+
+namespace lesomnus {
+namespace channel {
+namespace detail {
+
+/**
+ * @brief Chase-Lev work-stealing deque.
+ *
+ * The owner pushes and pops at the bottom without contention,
+ * and the other threads steal from the top.
+ * It grows as needed; the outgrown buffers are retired at destruction
+ * since the thieves may still read them.
+ *
+ * @see "Correct and Efficient Work-Stealing for Weak Memory Models" by Lê et al.
+ */
+class work_deque {
+   public:
+	explicit work_deque(std::size_t capacity = 256)
+	    : ring_(new ring(capacity)) {
+		rings_.emplace_back(ring_.load(std::memory_order_relaxed));
+	}
+
+	work_deque(work_deque const& other) = delete;
+	work_deque(work_deque&& other)      = delete;
+
+	work_deque& operator=(work_deque const& other) = delete;
+	work_deque& operator=(work_deque&& other)      = delete;
+
+	/**
+	 * @brief Returns the approximate number of the works.
+	 */
+	[[nodiscard]] std::size_t size() const noexcept {
+		auto const b = bottom_.load(std::memory_order_relaxed);
+		auto const t = top_.load(std::memory_order_relaxed);
+		return b > t ? static_cast<std::size_t>(b - t) : 0;
+	}
+
+	/**
+	 * @brief Pushes the work at the bottom.
+	 *
+	 * Only the owner may call it.
+	 */
+	void push(work& w) {
+		auto const b = bottom_.load(std::memory_order_relaxed);
+		auto const t = top_.load(std::memory_order_acquire);
+
+		ring* r = ring_.load(std::memory_order_relaxed);
+		if(b - t > static_cast<std::int64_t>(r->mask)) {
+			r = grow_(*r, t, b);
+		}
+
+		r->put(b, &w);
+		bottom_.store(b + 1, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Pops the most recently pushed work.
+	 *
+	 * Only the owner may call it.
+	 *
+	 * @return The work or \a nullptr if it is empty.
+	 */
+	work* pop() {
+		auto const b = bottom_.load(std::memory_order_relaxed) - 1;
+		ring* const r = ring_.load(std::memory_order_relaxed);
+		bottom_.store(b, std::memory_order_seq_cst);
+
+		auto t = top_.load(std::memory_order_seq_cst);
+		if(t > b) {
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		work* w = r->get(b);
+		if(t == b) {
+			// Last one, so it races with the thieves.
+			if(!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				w = nullptr;
+			}
+
+			bottom_.store(b + 1, std::memory_order_relaxed);
+		}
+
+		return w;
+	}
+
+	/**
+	 * @brief Steals the least recently pushed work.
+	 *
+	 * @return The work or \a nullptr if it is empty or lost the race.
+	 */
+	work* steal() {
+		auto       t = top_.load(std::memory_order_seq_cst);
+		auto const b = bottom_.load(std::memory_order_seq_cst);
+		if(t >= b) {
+			return nullptr;
+		}
+
+		ring* const r = ring_.load(std::memory_order_acquire);
+		work* const w = r->get(t);
+		if(!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			return nullptr;
+		}
+
+		return w;
+	}
+
+   private:
+	struct ring {
+		std::size_t                          mask;
+		std::unique_ptr<std::atomic<work*>[]> slots;
+
+		explicit ring(std::size_t capacity)
+		    : mask(capacity - 1)
+		    , slots(new std::atomic<work*>[capacity]) { }
+
+		void put(std::int64_t i, work* w) noexcept {
+			slots[static_cast<std::size_t>(i) & mask].store(w, std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] work* get(std::int64_t i) const noexcept {
+			return slots[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed);
+		}
+	};
+
+	ring* grow_(ring const& r, std::int64_t t, std::int64_t b) {
+		auto* const next = new ring((r.mask + 1) * 2);
+		for(auto i = t; i < b; ++i) {
+			next->put(i, r.get(i));
+		}
+
+		rings_.emplace_back(next);
+		ring_.store(next, std::memory_order_release);
+		return next;
+	}
+
+	std::atomic<std::int64_t> top_    = 0;
+	std::atomic<std::int64_t> bottom_ = 0;
+	std::atomic<ring*>        ring_;
+
+	// Owned by the owner of the deque.
+	std::vector<std::unique_ptr<ring>> rings_;
+};
+
+}  // namespace detail
+}  // namespace channel
+}  // namespace lesomnus
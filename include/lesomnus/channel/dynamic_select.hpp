@@ -0,0 +1,326 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stop_token>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/detail/random.hpp"
+#include "lesomnus/channel/select.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Case of \ref dynamic_select.
+ *
+ * Cases can be reused across the calls, so nothing is allocated per call.
+ * Spans of a concrete case type are dispatched without virtual calls;
+ * spans of pointers to this type allow cases of different types.
+ */
+class select_case {
+   public:
+	virtual ~select_case() = default;
+
+	/**
+	 * @brief Returns true if the selected operation is completed,
+	 *        or false if the channel is closed.
+	 */
+	[[nodiscard]] bool ok() const noexcept {
+		return ok_;
+	}
+
+	/**
+	 * @brief Completes the operation if it is ready.
+	 */
+	virtual bool try_execute() = 0;
+
+	/**
+	 * @brief Hangs the operation on the channel.
+	 *
+	 * @return False if the operation claimed the select but its peer is gone in the meantime.
+	 */
+	virtual bool schedule(detail::select_context& ctx) = 0;
+
+	/**
+	 * @brief Unhangs the operation.
+	 *
+	 * @return True if the operation is selected.
+	 */
+	virtual bool cancel() = 0;
+
+   protected:
+	bool ok_ = false;
+};
+
+template<typename T>
+class recv_case final: public select_case {
+   public:
+	explicit recv_case(receiver<T>& chan)
+	    : chan_(&chan) { }
+
+	recv_case(recv_case const& other)
+	    : chan_(other.chan_)
+	    , value_(other.value_) { }
+
+	recv_case& operator=(recv_case const& other) {
+		chan_  = other.chan_;
+		value_ = other.value_;
+		return *this;
+	}
+
+	/**
+	 * @brief Returns the received value if the case is selected.
+	 */
+	[[nodiscard]] T& value() noexcept {
+		return value_;
+	}
+
+	bool try_execute() override {
+		std::error_code ec;
+		chan_->try_recv(value_, ec);
+
+		if(ec == channel_errc::exhausted) {
+			return false;
+		}
+
+		ok_ = ec == channel_errc::ok;
+		return true;
+	}
+
+	bool schedule(detail::select_context& ctx) override {
+		waiter_.bind(ctx);
+		return chan_->recv_enqueue(waiter_);
+	}
+
+	bool cancel() override {
+		chan_->recv_dequeue(waiter_);
+		if(!waiter_.is_selected()) {
+			return false;
+		}
+
+		ok_ = waiter_.ok();
+		return true;
+	}
+
+   private:
+	receiver<T>* chan_;
+
+	T                        value_{};
+	detail::select_waiter<T> waiter_{&value_};
+};
+
+template<typename T>
+class send_case final: public select_case {
+   public:
+	explicit send_case(sender<T>& chan, T value = T{})
+	    : chan_(&chan)
+	    , value_(std::move(value)) { }
+
+	send_case(send_case const& other)
+	    : chan_(other.chan_)
+	    , value_(other.value_) { }
+
+	send_case& operator=(send_case const& other) {
+		chan_  = other.chan_;
+		value_ = other.value_;
+		return *this;
+	}
+
+	/**
+	 * @brief Returns the value to send.
+	 *
+	 * It is moved out once the case is selected, so it needs to be refilled to send again.
+	 */
+	[[nodiscard]] T& value() noexcept {
+		return value_;
+	}
+
+	bool try_execute() override {
+		std::error_code ec;
+		chan_->try_send(std::move(value_), ec);
+
+		if(ec == channel_errc::exhausted) {
+			return false;
+		}
+
+		ok_ = ec == channel_errc::ok;
+		return true;
+	}
+
+	bool schedule(detail::select_context& ctx) override {
+		waiter_.bind(ctx);
+		return chan_->send_enqueue(waiter_);
+	}
+
+	bool cancel() override {
+		chan_->send_dequeue(waiter_);
+		if(!waiter_.is_selected()) {
+			return false;
+		}
+
+		ok_ = waiter_.ok();
+		return true;
+	}
+
+   private:
+	sender<T>* chan_;
+
+	T                        value_;
+	detail::select_waiter<T> waiter_{&value_};
+};
+
+namespace detail {
+
+/**
+ * @brief Number of the cases whose poll order \ref dynamic_select keeps without allocating.
+ */
+inline constexpr std::size_t DynamicSelectInlineSize = 64;
+
+template<typename C>
+auto& as_case_(C& c) noexcept {
+	if constexpr(std::is_pointer_v<C>) {
+		return *c;
+	} else {
+		return c;
+	}
+}
+
+template<typename C>
+concept select_case_like = std::is_base_of_v<select_case, std::remove_cvref_t<decltype(as_case_(std::declval<C&>()))>>;
+
+template<typename C>
+std::size_t dynamic_select_(std::stop_token const& token, std::span<C> cases, bool is_blocking) {
+	std::size_t const n = cases.size();
+	if(n == 0) {
+		return n;
+	}
+
+	// Polled in a random permutation so that a ready case after the unready ones is not favored.
+	// The permutation of a few cases is kept on the stack.
+	std::array<std::size_t, DynamicSelectInlineSize> inline_order;
+	std::unique_ptr<std::size_t[]>                    heap_order;
+
+	if(n > inline_order.size()) {
+		heap_order = std::make_unique_for_overwrite<std::size_t[]>(n);
+	}
+
+	std::span<std::size_t> const order(heap_order ? heap_order.get() : inline_order.data(), n);
+	shuffle_order_(order);
+
+	auto const at = [&](std::size_t k) -> auto& {
+		return as_case_(cases[order[k]]);
+	};
+	auto const index = [&](std::size_t k) {
+		return order[k];
+	};
+	auto const try_execute = [&] {
+		for(std::size_t k = 0; k < n; ++k) {
+			if(at(k).try_execute()) {
+				return index(k);
+			}
+		}
+
+		return n;
+	};
+
+	if(auto const i = try_execute(); i != n || !is_blocking) {
+		return i;
+	}
+
+	select_context     ctx;
+	std::stop_callback on_cancel(token, [&ctx] {
+		if(ctx.claim(&ctx)) {
+			ctx.settle();
+		}
+	});
+
+	while(true) {
+		bool        is_scheduled = true;
+		std::size_t scheduled    = 0;
+		// Cases after the selected one need not to be hanged.
+		while(scheduled < n && ctx.winner() == nullptr) {
+			if(!at(scheduled++).schedule(ctx)) {
+				is_scheduled = false;
+				break;
+			}
+		}
+
+		if(is_scheduled) {
+			ctx.wait();
+		}
+
+		std::size_t selected = n;
+		for(std::size_t k = 0; k < scheduled; ++k) {
+			if(at(k).cancel()) {
+				selected = index(k);
+			}
+		}
+
+		if(is_scheduled) {
+			return selected;
+		}
+
+		// A case claimed the select but its peer is gone,
+		// so nothing is selected yet.
+		ctx.reset();
+		if(token.stop_requested()) {
+			return n;
+		}
+		if(auto const i = try_execute(); i != n) {
+			return i;
+		}
+	}
+}
+
+}  // namespace detail
+
+/**
+ * @brief Waits for one of the cases whose number is known at runtime.
+ *
+ * Like Go's `reflect.Select`, the result of the selected case is held by the case.
+ * Each case is hanged and unhanged in constant time.
+ *
+ * @param token Interrupt register.
+ * @param cases Cases or pointers to the cases.
+ * @return Index of the selected case,
+ *         or the size of \p cases if \p token is stop requested or \p cases is empty.
+ */
+template<std::ranges::contiguous_range R>
+requires detail::select_case_like<std::ranges::range_value_t<R>>
+std::size_t dynamic_select(std::stop_token token, R&& cases) {
+	return detail::dynamic_select_(token, std::span<std::ranges::range_value_t<R>>(cases), true);
+}
+
+/**
+ * @brief Waits for one of the cases whose number is known at runtime.
+ *
+ * @param cases Cases or pointers to the cases.
+ * @return Index of the selected case, or the size of \p cases if it is empty.
+ */
+template<std::ranges::contiguous_range R>
+requires detail::select_case_like<std::ranges::range_value_t<R>>
+std::size_t dynamic_select(R&& cases) {
+	return detail::dynamic_select_(std::stop_token{}, std::span<std::ranges::range_value_t<R>>(cases), true);
+}
+
+/**
+ * @brief Completes one of the ready cases.
+ *
+ * @param cases Cases or pointers to the cases.
+ * @return Index of the selected case, or the size of \p cases if none of them is ready.
+ */
+template<std::ranges::contiguous_range R>
+requires detail::select_case_like<std::ranges::range_value_t<R>>
+std::size_t try_dynamic_select(R&& cases) {
+	return detail::dynamic_select_(std::stop_token{}, std::span<std::ranges::range_value_t<R>>(cases), false);
+}
+
+}  // namespace channel
+}  // namespace lesomnus
@@ -11,6 +11,7 @@ enum class channel_errc {
 	exhausted = 1,
 	closed    = 2,
 	canceled  = 3,
+	timeout   = 4,
 };
 
 namespace detail {
@@ -31,6 +32,8 @@ class channel_category: public std::error_category {
 			return "closed channel";
 		case channel_errc::canceled:
 			return "channel operation canceled";
+		case channel_errc::timeout:
+			return "channel operation timed out";
 
 		default:
 			return "unknown";
@@ -45,6 +48,8 @@ class channel_category: public std::error_category {
 	// 		return make_error_condition(std::errc::connection_reset);
 	// 	case channel_errc::canceled:
 	// 		return make_error_condition(std::errc::operation_canceled);
+	// 	case channel_errc::timeout:
+	// 		return make_error_condition(std::errc::timed_out);
 	// 	default:
 	// 		return std::error_condition(c, *this);
 	// 	}
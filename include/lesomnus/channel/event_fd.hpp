@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/detail/watcher.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Pollable `eventfd` that becomes readable when a channel is ready (Linux only).
+ *
+ * It lets an `epoll` or `poll` loop multiplex channels with sockets.
+ * The descriptor is signaled edge-style: once it is signaled, the following sends do not touch it
+ * until \ref reset is called, so a burst of sends costs one syscall.
+ * The loop calls \ref reset and then drains the channel with `try_*` operations until they are exhausted;
+ * anything that becomes ready after the reset signals the descriptor again.
+ *
+ * The descriptor is also signaled when the channel is closed.
+ * The channel must outlive it.
+ *
+ * @code
+ * auto ev = event_fd::watch_recv(chan);
+ * epoll_ctl(epfd, EPOLL_CTL_ADD, ev.fd(), &event);
+ * // When `ev.fd()` is readable:
+ * ev.reset();
+ * while(chan.try_recv(v)) { ... }
+ * @endcode
+ */
+class event_fd final: detail::watcher {
+   public:
+	/**
+	 * @brief Creates the descriptor signaled whenever a receive on \p chan may not block.
+	 *
+	 * @throws std::system_error If the descriptor cannot be created.
+	 */
+	[[nodiscard]] static event_fd watch_recv(detail::chan_base& chan) {
+		return event_fd(chan, false);
+	}
+
+	/**
+	 * @brief Creates the descriptor signaled whenever a send on \p chan may not block.
+	 *
+	 * @throws std::system_error If the descriptor cannot be created.
+	 */
+	[[nodiscard]] static event_fd watch_send(detail::chan_base& chan) {
+		return event_fd(chan, true);
+	}
+
+	~event_fd() {
+		// No notification is in flight once the watcher is unregistered under the channel lock.
+		if(is_send_) {
+			chan_->unwatch_send(*this);
+		} else {
+			chan_->unwatch_recv(*this);
+		}
+
+		::close(fd_);
+	}
+
+	/**
+	 * @return Nonblocking descriptor to be polled for readability.
+	 */
+	[[nodiscard]] int fd() const noexcept {
+		return fd_;
+	}
+
+	/**
+	 * @brief Clears the signal so the next readiness of the channel signals the descriptor again.
+	 *
+	 * It must be called before the channel is drained, not after, or a readiness in between is lost.
+	 */
+	void reset() noexcept {
+		std::uint64_t count = 0;
+		[[maybe_unused]] auto const n = ::read(fd_, &count, sizeof(count));
+
+		is_signaled_.store(false, std::memory_order_release);
+	}
+
+	void notify() override {
+		if(is_signaled_.exchange(true, std::memory_order_acq_rel)) {
+			return;
+		}
+
+		std::uint64_t const one = 1;
+		[[maybe_unused]] auto const n = ::write(fd_, &one, sizeof(one));
+	}
+
+   private:
+	event_fd(detail::chan_base& chan, bool is_send)
+	    : chan_(&chan)
+	    , is_send_(is_send) {
+		fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if(fd_ < 0) {
+			throw std::system_error(errno, std::generic_category(), "eventfd");
+		}
+
+		auto const is_ready = is_send_ ? chan_->watch_send(*this) : chan_->watch_recv(*this);
+		if(is_ready) {
+			notify();
+		}
+	}
+
+	detail::chan_base* chan_;
+	bool               is_send_;
+	int                fd_ = -1;
+
+	std::atomic<bool> is_signaled_ = false;
+};
+
+}  // namespace channel
+}  // namespace lesomnus
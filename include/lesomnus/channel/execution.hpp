@@ -0,0 +1,350 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <stop_token>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/detail/awaiter.hpp"
+#include "lesomnus/channel/error.hpp"
+#include "lesomnus/channel/executor.hpp"
+#include "lesomnus/channel/select.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Channel operations as senders of the sender/receiver model (P2300).
+ *
+ * The senders follow the member-function protocol of `std::execution`:
+ * a sender is connected to a receiver by `connect`, the operation state is started by `start`,
+ * and the receiver is completed by one of `set_value`, `set_error`, and `set_stopped`.
+ * The stop token is taken from the `get_stop_token` query of the receiver environment.
+ *
+ * The operation state embeds the waiter hanged on the channel so nothing is allocated.
+ * The receiver is completed inline in `start` if the operation is ready.
+ * Otherwise, it is completed on the executor given by the `get_scheduler` query of the receiver environment,
+ * or on the thread that settles the operation after the channel is unlocked if the environment has none.
+ */
+namespace execution {
+
+struct sender_t { };
+
+struct operation_state_t { };
+
+struct set_value_t { };
+
+struct set_error_t { };
+
+struct set_stopped_t { };
+
+template<typename... Sigs>
+struct completion_signatures { };
+
+struct empty_env { };
+
+/**
+ * @brief Query of the stop token of an environment.
+ *
+ * An environment without the query has a token that is never stopped.
+ */
+struct get_stop_token_t {
+	template<typename Env>
+	std::stop_token operator()(Env const& env) const noexcept {
+		if constexpr(requires { { env.query(*this) } -> std::convertible_to<std::stop_token>; }) {
+			return env.query(*this);
+		} else {
+			return {};
+		}
+	}
+};
+
+inline constexpr get_stop_token_t get_stop_token{};
+
+/**
+ * @brief Query of the executor where the receiver is completed.
+ *
+ * An environment without the query completes the receiver on the settling thread,
+ * such as the one driving the timer service for `after`.
+ */
+struct get_scheduler_t {
+	template<typename Env>
+	executor& operator()(Env const& env) const noexcept {
+		if constexpr(requires { { env.query(*this) } -> std::convertible_to<executor&>; }) {
+			return env.query(*this);
+		} else {
+			return inline_executor::instance();
+		}
+	}
+};
+
+inline constexpr get_scheduler_t get_scheduler{};
+
+/**
+ * @brief Returns the environment of the receiver, or an empty one if it has none.
+ */
+struct get_env_t {
+	template<typename R>
+	decltype(auto) operator()(R const& r) const noexcept {
+		if constexpr(requires { r.get_env(); }) {
+			return r.get_env();
+		} else {
+			return empty_env{};
+		}
+	}
+};
+
+inline constexpr get_env_t get_env{};
+
+namespace detail {
+
+/**
+ * @brief Operation state driving an awaiter of the channel without a coroutine.
+ *
+ * @tparam Derived Provides `get_awaiter_()` and `complete_()`.
+ */
+template<typename Derived>
+class operation_base {
+   public:
+	using operation_state_concept = operation_state_t;
+
+	operation_base() = default;
+
+	operation_base(operation_base const& other) = delete;
+	operation_base(operation_base&& other)      = delete;
+
+	operation_base& operator=(operation_base const& other) = delete;
+	operation_base& operator=(operation_base&& other)      = delete;
+
+	void start() & noexcept {
+		auto& self = static_cast<Derived&>(*this);
+		auto& a    = self.get_awaiter_();
+		if(a.await_ready() || !a.suspend(&on_settled_, this)) {
+			self.complete_();
+		}
+	}
+
+   private:
+	static void on_settled_(void* self) {
+		static_cast<Derived*>(static_cast<operation_base*>(self))->complete_();
+	}
+};
+
+template<typename T, typename R>
+class recv_operation final: public operation_base<recv_operation<T, R>> {
+   public:
+	template<typename U>
+	recv_operation(receiver<T>& chan, U&& rcvr)
+	    : rcvr_(std::forward<U>(rcvr))
+	    , awaiter_(chan, get_stop_token(get_env(rcvr_)), value_, ec_, get_scheduler(get_env(rcvr_))) { }
+
+   private:
+	friend class operation_base<recv_operation>;
+
+	channel::detail::recv_awaiter<T>& get_awaiter_() noexcept {
+		return awaiter_;
+	}
+
+	void complete_() noexcept {
+		if(awaiter_.await_resume()) {
+			std::move(rcvr_).set_value(std::move(value_));
+		} else if(ec_ == channel_errc::canceled) {
+			std::move(rcvr_).set_stopped();
+		} else {
+			std::move(rcvr_).set_error(ec_);
+		}
+	}
+
+	R rcvr_;
+
+	T                                value_{};
+	std::error_code                  ec_;
+	channel::detail::recv_awaiter<T> awaiter_;
+};
+
+template<typename T, typename R>
+class send_operation final: public operation_base<send_operation<T, R>> {
+   public:
+	template<typename U, typename V>
+	send_operation(sender<T>& chan, U&& value, V&& rcvr)
+	    : rcvr_(std::forward<V>(rcvr))
+	    , awaiter_(chan, get_stop_token(get_env(rcvr_)), std::forward<U>(value), ec_, get_scheduler(get_env(rcvr_))) { }
+
+   private:
+	friend class operation_base<send_operation>;
+
+	channel::detail::send_awaiter<T>& get_awaiter_() noexcept {
+		return awaiter_;
+	}
+
+	void complete_() noexcept {
+		if(awaiter_.await_resume()) {
+			std::move(rcvr_).set_value();
+		} else if(ec_ == channel_errc::canceled) {
+			std::move(rcvr_).set_stopped();
+		} else {
+			std::move(rcvr_).set_error(ec_);
+		}
+	}
+
+	R rcvr_;
+
+	std::error_code                  ec_;
+	channel::detail::send_awaiter<T> awaiter_;
+};
+
+template<typename R, typename... Ops>
+class when_any_operation final: public operation_base<when_any_operation<R, Ops...>> {
+   public:
+	template<typename U>
+	when_any_operation(std::tuple<Ops...>&& ops, U&& rcvr)
+	    : when_any_operation(std::move(ops), std::forward<U>(rcvr), std::index_sequence_for<Ops...>{}) { }
+
+   private:
+	friend class operation_base<when_any_operation>;
+
+	template<typename U, std::size_t... Is>
+	when_any_operation(std::tuple<Ops...>&& ops, U&& rcvr, std::index_sequence<Is...>)
+	    : rcvr_(std::forward<U>(rcvr))
+	    , awaiter_(get_stop_token(get_env(rcvr_)), get_scheduler(get_env(rcvr_)), std::get<Is>(std::move(ops))...) { }
+
+	channel::detail::select_awaiter<Ops...>& get_awaiter_() noexcept {
+		return awaiter_;
+	}
+
+	void complete_() noexcept {
+		// The callback of the completed operation is invoked here.
+		awaiter_.await_resume();
+		if(awaiter_.is_canceled()) {
+			std::move(rcvr_).set_stopped();
+		} else {
+			std::move(rcvr_).set_value();
+		}
+	}
+
+	R rcvr_;
+
+	channel::detail::select_awaiter<Ops...> awaiter_;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Sender made by \ref async_recv.
+ *
+ * It completes with `set_value(T)`, `set_error(std::error_code)` if the channel is closed,
+ * or `set_stopped()` if it is canceled.
+ */
+template<typename T>
+class recv_sender {
+   public:
+	using sender_concept        = sender_t;
+	using completion_signatures = execution::completion_signatures<set_value_t(T), set_error_t(std::error_code), set_stopped_t()>;
+
+	explicit recv_sender(receiver<T>& chan) noexcept
+	    : chan_(&chan) { }
+
+	template<typename R>
+	detail::recv_operation<T, std::decay_t<R>> connect(R&& rcvr) const {
+		return detail::recv_operation<T, std::decay_t<R>>(*chan_, std::forward<R>(rcvr));
+	}
+
+   private:
+	receiver<T>* chan_;
+};
+
+/**
+ * @brief Sender made by \ref async_send.
+ *
+ * It completes with `set_value()`, `set_error(std::error_code)` if the channel is closed,
+ * or `set_stopped()` if it is canceled.
+ */
+template<typename T>
+class send_sender {
+   public:
+	using sender_concept        = sender_t;
+	using completion_signatures = execution::completion_signatures<set_value_t(), set_error_t(std::error_code), set_stopped_t()>;
+
+	template<typename U>
+	send_sender(sender<T>& chan, U&& value)
+	    : chan_(&chan)
+	    , value_(std::forward<U>(value)) { }
+
+	template<typename R>
+	detail::send_operation<T, std::decay_t<R>> connect(R&& rcvr) && {
+		return detail::send_operation<T, std::decay_t<R>>(*chan_, std::move(value_), std::forward<R>(rcvr));
+	}
+
+	template<typename R>
+	detail::send_operation<T, std::decay_t<R>> connect(R&& rcvr) const& {
+		return detail::send_operation<T, std::decay_t<R>>(*chan_, value_, std::forward<R>(rcvr));
+	}
+
+   private:
+	sender<T>* chan_;
+	T          value_;
+};
+
+/**
+ * @brief Sender made by \ref when_any.
+ *
+ * It completes with `set_value()` after the callback of the completed operation is invoked,
+ * or `set_stopped()` if it is canceled before any operation completes.
+ */
+template<typename... Ops>
+class when_any_sender {
+   public:
+	using sender_concept        = sender_t;
+	using completion_signatures = execution::completion_signatures<set_value_t(), set_stopped_t()>;
+
+	template<typename... Args>
+	explicit when_any_sender(Args&&... ops)
+	    : ops_(std::forward<Args>(ops)...) { }
+
+	template<typename R>
+	detail::when_any_operation<std::decay_t<R>, Ops...> connect(R&& rcvr) && {
+		return detail::when_any_operation<std::decay_t<R>, Ops...>(std::move(ops_), std::forward<R>(rcvr));
+	}
+
+   private:
+	std::tuple<Ops...> ops_;
+};
+
+/**
+ * @brief Returns the sender that receives a value from the channel.
+ */
+template<typename T>
+recv_sender<T> async_recv(receiver<T>& chan) noexcept {
+	return recv_sender<T>(chan);
+}
+
+/**
+ * @brief Returns the sender that sends the value to the channel.
+ *
+ * The sender holds a copy of the value until it is connected.
+ */
+template<typename T, typename U>
+requires std::constructible_from<T, U&&>
+send_sender<T> async_send(sender<T>& chan, U&& value) {
+	return send_sender<T>(chan, std::forward<U>(value));
+}
+
+/**
+ * @brief Returns the sender that waits for the given channel operations like \ref select.
+ *
+ * @tparam Ops Operations.
+ * @param ops Operations to wait.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<channel::detail::op, std::remove_cvref_t<Ops>>...>
+when_any_sender<std::remove_cvref_t<Ops>...> when_any(Ops&&... ops) {
+	return when_any_sender<std::remove_cvref_t<Ops>...>(std::forward<Ops>(ops)...);
+}
+
+}  // namespace execution
+}  // namespace channel
+}  // namespace lesomnus
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace lesomnus {
+namespace channel {
+
+class executor;
+
+namespace detail {
+
+/**
+ * @brief Intrusive unit of work posted to an \ref executor.
+ *
+ * It is usually embedded in the object that needs to be run later,
+ * so posting does not allocate.
+ */
+class work {
+   public:
+	work() = default;
+
+	work(work const& other) = delete;
+	work(work&& other)      = delete;
+
+	work& operator=(work const& other) = delete;
+	work& operator=(work&& other)      = delete;
+
+	/**
+	 * @brief Runs the work.
+	 *
+	 * The work may be destroyed by itself.
+	 */
+	virtual void run() = 0;
+
+   protected:
+	~work() = default;
+
+   private:
+	friend class work_queue;
+
+	work* next_ = nullptr;
+};
+
+/**
+ * @brief Intrusive FIFO of the works.
+ */
+class work_queue {
+   public:
+	[[nodiscard]] bool empty() const noexcept {
+		return head_ == nullptr;
+	}
+
+	void push_back(work& w) noexcept {
+		w.next_ = nullptr;
+		if(tail_ == nullptr) {
+			head_ = &w;
+		} else {
+			tail_->next_ = &w;
+		}
+
+		tail_ = &w;
+	}
+
+	/**
+	 * @brief Removes the first work.
+	 *
+	 * @return The removed work or \a nullptr if it is empty.
+	 */
+	work* pop_front() noexcept {
+		work* const w = head_;
+		if(w != nullptr) {
+			head_ = w->next_;
+			if(head_ == nullptr) {
+				tail_ = nullptr;
+			}
+		}
+
+		return w;
+	}
+
+   private:
+	work* head_ = nullptr;
+	work* tail_ = nullptr;
+};
+
+/**
+ * @brief Work made from a function object.
+ *
+ * It deletes itself once it is run.
+ */
+template<typename F>
+class fn_work final: public work {
+   public:
+	template<typename U>
+	explicit fn_work(U&& f)
+	    : f_(std::forward<U>(f)) { }
+
+	void run() override {
+		f_();
+		delete this;
+	}
+
+   private:
+	F f_;
+};
+
+inline thread_local executor* current_executor = nullptr;
+
+/**
+ * @brief Marks the executor as the one running on the current thread.
+ */
+class executor_scope {
+   public:
+	explicit executor_scope(executor& ex) noexcept
+	    : prev_(current_executor) {
+		current_executor = &ex;
+	}
+
+	executor_scope(executor_scope const& other) = delete;
+
+	executor_scope& operator=(executor_scope const& other) = delete;
+
+	~executor_scope() {
+		current_executor = prev_;
+	}
+
+   private:
+	executor* prev_;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Where the continuations of the asynchronous operations are run.
+ */
+class executor {
+   public:
+	virtual ~executor() = default;
+
+	/**
+	 * @brief Runs the work later.
+	 *
+	 * @param w Work that must outlive its run.
+	 */
+	virtual void post(detail::work& w) = 0;
+
+	/**
+	 * @brief Runs the function later.
+	 *
+	 * Unlike posting a work, it allocates.
+	 */
+	template<typename F>
+	requires std::is_invocable_v<std::decay_t<F>&>
+	void post(F&& f) {
+		post(*new detail::fn_work<std::decay_t<F>>(std::forward<F>(f)));
+	}
+
+	/**
+	 * @brief Returns the executor running the current thread,
+	 *        or \ref inline_executor if there is no such executor.
+	 */
+	static executor& current() noexcept;
+};
+
+/**
+ * @brief Runs the works immediately on the posting thread.
+ */
+class inline_executor final: public executor {
+   public:
+	using executor::post;
+
+	static inline_executor& instance() noexcept {
+		static inline_executor ex;
+		return ex;
+	}
+
+	void post(detail::work& w) override {
+		w.run();
+	}
+};
+
+inline executor& executor::current() noexcept {
+	if(detail::current_executor != nullptr) {
+		return *detail::current_executor;
+	}
+
+	return inline_executor::instance();
+}
+
+/**
+ * @brief Runs the posted works on the threads calling \ref run.
+ */
+class run_loop final: public executor {
+   public:
+	using executor::post;
+
+	run_loop() = default;
+
+	run_loop(run_loop const& other) = delete;
+	run_loop(run_loop&& other)      = delete;
+
+	run_loop& operator=(run_loop const& other) = delete;
+	run_loop& operator=(run_loop&& other)      = delete;
+
+	void post(detail::work& w) override {
+		{
+			std::scoped_lock l(mutex_);
+			works_.push_back(w);
+		}
+
+		cv_.notify_one();
+	}
+
+	/**
+	 * @brief Runs the posted works until \ref finish is called and no work is left.
+	 */
+	void run() {
+		detail::executor_scope scope(*this);
+		while(auto* const w = pop_(true)) {
+			w->run();
+		}
+	}
+
+	/**
+	 * @brief Runs the posted works until no work is left without blocking.
+	 *
+	 * @return The number of the works run.
+	 */
+	std::size_t poll() {
+		detail::executor_scope scope(*this);
+
+		std::size_t n = 0;
+		while(auto* const w = pop_(false)) {
+			w->run();
+			++n;
+		}
+
+		return n;
+	}
+
+	/**
+	 * @brief Makes \ref run return once no work is left.
+	 */
+	void finish() {
+		{
+			std::scoped_lock l(mutex_);
+			is_finishing_ = true;
+		}
+
+		cv_.notify_all();
+	}
+
+   private:
+	detail::work* pop_(bool is_blocking) {
+		std::unique_lock l(mutex_);
+		if(is_blocking) {
+			cv_.wait(l, [this] { return is_finishing_ || !works_.empty(); });
+		}
+
+		return works_.pop_front();
+	}
+
+	std::mutex              mutex_;
+	std::condition_variable cv_;
+
+	detail::work_queue works_;
+	bool               is_finishing_ = false;
+};
+
+}  // namespace channel
+}  // namespace lesomnus
@@ -0,0 +1,528 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "lesomnus/channel/detail/parker.hpp"
+#include "lesomnus/channel/executor.hpp"
+#include "lesomnus/channel/thread_pool.hpp"
+
+#if defined(__SANITIZE_ADDRESS__)
+#define LESOMNUS_CHANNEL_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define LESOMNUS_CHANNEL_ASAN 1
+#endif
+#endif
+
+#if defined(__SANITIZE_THREAD__)
+#define LESOMNUS_CHANNEL_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define LESOMNUS_CHANNEL_TSAN 1
+#endif
+#endif
+
+// The switch saves only the callee-saved registers where it is written in assembly.
+// With shadow stacks, `swapcontext` is kept since it switches the shadow stack too.
+#if defined(__x86_64__) && defined(__GNUC__) && !(defined(__CET__) && (__CET__ & 2))
+#define LESOMNUS_CHANNEL_FIBER_SWITCH_X86_64 1
+#endif
+
+#if defined(LESOMNUS_CHANNEL_ASAN)
+#include <sanitizer/asan_interface.h>
+#endif
+#if defined(LESOMNUS_CHANNEL_TSAN)
+#include <sanitizer/tsan_interface.h>
+#endif
+
+#if !defined(LESOMNUS_CHANNEL_FIBER_SWITCH_X86_64)
+#include <ucontext.h>
+#endif
+
+namespace lesomnus {
+namespace channel {
+namespace detail {
+
+#if defined(LESOMNUS_CHANNEL_FIBER_SWITCH_X86_64)
+/**
+ * @brief Saves the callee-saved registers on the current stack into `*from` and restores them from `to`.
+ *
+ * It returns into where `to` was saved, or into the entry of a new stack with `arg` as its first argument.
+ */
+[[gnu::naked, gnu::noinline]] inline void switch_context(void** /* from */, void* /* to */, void* /* arg */) noexcept {
+	asm volatile(
+	    "pushq %rbp\n\t"
+	    "pushq %rbx\n\t"
+	    "pushq %r12\n\t"
+	    "pushq %r13\n\t"
+	    "pushq %r14\n\t"
+	    "pushq %r15\n\t"
+	    "subq $8, %rsp\n\t"
+	    "stmxcsr (%rsp)\n\t"
+	    "fnstcw 4(%rsp)\n\t"
+
+	    "movq %rsp, (%rdi)\n\t"
+	    "movq %rsi, %rsp\n\t"
+
+	    "ldmxcsr (%rsp)\n\t"
+	    "fldcw 4(%rsp)\n\t"
+	    "addq $8, %rsp\n\t"
+	    "popq %r15\n\t"
+	    "popq %r14\n\t"
+	    "popq %r13\n\t"
+	    "popq %r12\n\t"
+	    "popq %rbx\n\t"
+	    "popq %rbp\n\t"
+	    "movq %rdx, %rdi\n\t"
+	    "retq\n\t");
+}
+
+/**
+ * @brief Lays out a stack so the first \ref switch_context into it calls `entry`.
+ *
+ * @return Stack pointer to switch to.
+ */
+inline void* make_context(void* bottom, std::size_t size, void (*entry)(void*)) noexcept {
+	auto const top = (reinterpret_cast<std::uintptr_t>(bottom) + size) & ~std::uintptr_t(15);
+
+	// The control words, 6 registers, the entry, and a null return address of the entry.
+	// The entry sees the stack aligned as after a call.
+	auto* const sp = reinterpret_cast<std::uint64_t*>(top) - 9;
+
+	std::uint32_t const csr = 0x1F80;  // Default MXCSR.
+	std::uint16_t const cw  = 0x037F;  // Default x87 control word.
+	sp[0] = csr | (std::uint64_t(cw) << 32);
+	for(int i = 1; i < 7; ++i) {
+		sp[i] = 0;
+	}
+	sp[7] = reinterpret_cast<std::uintptr_t>(entry);
+	sp[8] = 0;
+
+	return sp;
+}
+#endif
+
+/**
+ * @brief Cache of the fiber stacks.
+ *
+ * Stacks are carved from slabs mapped at once, so a slab costs one memory mapping however many stacks it holds
+ * and the number of the fibers is not bound by `vm.max_map_count`.
+ * Such stacks are adjacent without a gap, so an overflow silently corrupts the stack below.
+ * A guarded stack is mapped on its own with an inaccessible guard page below it, so an overflow faults instead;
+ * the guard page splits the mapping, so each guarded stack costs two mappings.
+ *
+ * Released stacks are kept and reused by the fibers with the same stack size.
+ * Slabs are never unmapped until the pool is destroyed;
+ * the memory of the released stacks beyond the cache limit is returned to the system instead.
+ */
+class stack_pool {
+   public:
+	struct stack {
+		// Lowest address of the stack including the guard page.
+		void*       base    = nullptr;
+		std::size_t size    = 0;
+		bool        guarded = false;
+
+		[[nodiscard]] void* bottom() const noexcept {
+			return static_cast<std::byte*>(base) + guard_size_();
+		}
+
+		[[nodiscard]] std::size_t usable_size() const noexcept {
+			return size - guard_size_();
+		}
+
+	   private:
+		[[nodiscard]] std::size_t guard_size_() const noexcept {
+			return guarded ? page_size() : 0;
+		}
+	};
+
+	/**
+	 * @brief Size of the memory mapped at once for the unguarded stacks.
+	 *
+	 * A slab holds at least one stack.
+	 */
+	static constexpr std::size_t SlabSize = 4 * 1024 * 1024;
+
+	/**
+	 * @param max_cached Maximum number of the released stacks of a size kept with their memory.
+	 */
+	explicit stack_pool(std::size_t max_cached = 1024)
+	    : max_cached_(max_cached) { }
+
+	stack_pool(stack_pool const& other) = delete;
+	stack_pool(stack_pool&& other)      = delete;
+
+	stack_pool& operator=(stack_pool const& other) = delete;
+	stack_pool& operator=(stack_pool&& other)      = delete;
+
+	~stack_pool() {
+		for(auto const& [key, stacks]: free_) {
+			if(!key.second) {
+				continue;
+			}
+			for(auto const& s: stacks) {
+				::munmap(s.base, s.size);
+			}
+		}
+		for(auto const& [base, size]: slabs_) {
+			::munmap(base, size);
+		}
+	}
+
+	static stack_pool& global() {
+		// Never destroyed since the fibers left in the static executors are released at exit.
+		static stack_pool* const pool = new stack_pool();
+		return *pool;
+	}
+
+	static std::size_t page_size() noexcept {
+		static std::size_t const size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		return size;
+	}
+
+	/**
+	 * @param usable_size Size of the stack excluding the guard page; it is rounded up to the page size.
+	 * @param guarded Whether the stack has a guard page below it.
+	 *
+	 * @throws std::system_error If the stack cannot be mapped.
+	 */
+	stack allocate(std::size_t usable_size, bool guarded = false) {
+		auto const page = page_size();
+		auto const size = (usable_size + page - 1) / page * page + (guarded ? page : 0);
+
+		std::scoped_lock l(mutex_);
+
+		auto& stacks = free_[{size, guarded}];
+		if(!stacks.empty()) {
+			auto const s = stacks.back();
+			stacks.pop_back();
+			return s;
+		}
+
+		if(guarded) {
+			return map_guarded_(size);
+		}
+		return map_slab_(size, stacks);
+	}
+
+	void release(stack s) noexcept {
+		{
+			std::scoped_lock l(mutex_);
+
+			auto& stacks = free_[{s.size, s.guarded}];
+			if(!s.guarded || stacks.size() < max_cached_) {
+				if(stacks.size() >= max_cached_) {
+					// Keeps the address range so the slab is not split, but not its memory.
+					::madvise(s.base, s.size, MADV_DONTNEED);
+				}
+
+				stacks.push_back(s);
+				return;
+			}
+		}
+
+		::munmap(s.base, s.size);
+	}
+
+   private:
+	static stack map_guarded_(std::size_t size) {
+		void* const base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+		if(base == MAP_FAILED) {
+			throw std::system_error(errno, std::generic_category(), "mmap");
+		}
+		if(::mprotect(base, page_size(), PROT_NONE) != 0) {
+			auto const err = errno;
+			::munmap(base, size);
+			throw std::system_error(err, std::generic_category(), "mprotect");
+		}
+
+		return stack{base, size, true};
+	}
+
+	stack map_slab_(std::size_t size, std::vector<stack>& stacks) {
+		auto const n          = std::max<std::size_t>(1, SlabSize / size);
+		auto const slab_size  = n * size;
+		void* const slab_base = ::mmap(nullptr, slab_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+		if(slab_base == MAP_FAILED) {
+			throw std::system_error(errno, std::generic_category(), "mmap");
+		}
+
+		slabs_.emplace_back(slab_base, slab_size);
+
+		// The rest are pushed from the top so the lower ones are taken first.
+		auto* const base = static_cast<std::byte*>(slab_base);
+		for(auto i = n - 1; i > 0; --i) {
+			stacks.push_back(stack{base + i * size, size, false});
+		}
+
+		return stack{slab_base, size, false};
+	}
+
+	std::size_t max_cached_;
+
+	std::mutex mutex_;
+
+	// Keyed by the size of the stack and whether it is guarded.
+	std::map<std::pair<std::size_t, bool>, std::vector<stack>> free_;
+	std::vector<std::pair<void*, std::size_t>>                 slabs_;
+};
+
+/**
+ * @brief Stackful user-space thread run by an \ref executor.
+ *
+ * Each run on the executor switches into the fiber until it suspends itself or finishes,
+ * so the fiber may migrate to another thread of the executor whenever it is resumed.
+ * It deletes itself once it finishes.
+ *
+ * On x86-64 a switch saves and restores only the callee-saved registers in user space, without a syscall.
+ * Elsewhere, or with shadow stacks enabled, it falls back to POSIX `swapcontext`,
+ * which saves and restores the signal mask with an `rt_sigprocmask` syscall,
+ * so each park and resume costs two syscalls on top of the executor.
+ */
+class fiber: public suspendable, public work {
+   public:
+	fiber(fiber const& other) = delete;
+	fiber(fiber&& other)      = delete;
+
+	fiber& operator=(fiber const& other) = delete;
+	fiber& operator=(fiber&& other)      = delete;
+
+	/**
+	 * @brief Switches into the fiber.
+	 */
+	void run() override {
+		auto* const prev    = current_suspendable;
+		current_suspendable = this;
+		switch_in_();
+		current_suspendable = prev;
+
+		// The fiber may be resumed on another thread as soon as `after` is invoked,
+		// so nothing of it may be touched after that.
+		if(is_done_) {
+			delete this;
+			return;
+		}
+
+		auto* const after = std::exchange(after_, nullptr);
+		if(after != nullptr) {
+			after(after_arg_);
+		}
+	}
+
+	void suspend(void (*after)(void*), void* arg) override {
+		after_     = after;
+		after_arg_ = arg;
+		switch_out_();
+	}
+
+	void resume() override {
+		ex_->post(*this);
+	}
+
+   protected:
+	fiber(executor& ex, std::size_t stack_size, bool guarded)
+	    : ex_(&ex)
+	    , stack_(stack_pool::global().allocate(stack_size, guarded)) {
+#if defined(LESOMNUS_CHANNEL_FIBER_SWITCH_X86_64)
+		sp_ = make_context(stack_.bottom(), stack_.usable_size(), &entry_);
+#else
+		::getcontext(&ctx_);
+		ctx_.uc_stack.ss_sp   = stack_.bottom();
+		ctx_.uc_stack.ss_size = stack_.usable_size();
+		ctx_.uc_link          = nullptr;
+
+		// `makecontext` passes only `int`s. Split in 64 bits so the shift is defined for 32-bit pointers too.
+		auto const p = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(this));
+		::makecontext(&ctx_, reinterpret_cast<void (*)()>(&entry_), 2, static_cast<int>(p >> 32), static_cast<int>(p & 0xFFFFFFFF));
+#endif
+
+#if defined(LESOMNUS_CHANNEL_TSAN)
+		tsan_fiber_ = __tsan_create_fiber(0);
+#endif
+	}
+
+	virtual ~fiber() {
+#if defined(LESOMNUS_CHANNEL_TSAN)
+		__tsan_destroy_fiber(tsan_fiber_);
+#endif
+		stack_pool::global().release(stack_);
+	}
+
+	virtual void invoke_() = 0;
+
+   private:
+#if defined(LESOMNUS_CHANNEL_FIBER_SWITCH_X86_64)
+	static void entry_(void* arg) noexcept {
+		run_(static_cast<fiber*>(arg));
+	}
+#else
+	static void entry_(int hi, int lo) noexcept {
+		auto const p = (static_cast<std::uint64_t>(static_cast<unsigned>(hi)) << 32) | static_cast<unsigned>(lo);
+		run_(reinterpret_cast<fiber*>(static_cast<std::uintptr_t>(p)));
+	}
+#endif
+
+	[[noreturn]] static void run_(fiber* self) noexcept {
+		self->on_switched_in_(true);
+
+		try {
+			self->invoke_();
+		} catch(...) {
+			std::terminate();
+		}
+
+		self->is_done_ = true;
+		self->switch_out_();
+
+		// A finished fiber is never resumed.
+		std::terminate();
+	}
+
+	void switch_in_() {
+#if defined(LESOMNUS_CHANNEL_ASAN)
+		void* fake_stack = nullptr;
+		__sanitizer_start_switch_fiber(&fake_stack, stack_.bottom(), stack_.usable_size());
+#endif
+#if defined(LESOMNUS_CHANNEL_TSAN)
+		caller_tsan_fiber_ = __tsan_get_current_fiber();
+		__tsan_switch_to_fiber(tsan_fiber_, 0);
+#endif
+
+#if defined(LESOMNUS_CHANNEL_FIBER_SWITCH_X86_64)
+		switch_context(&caller_sp_, sp_, this);
+#else
+		::swapcontext(&caller_, &ctx_);
+#endif
+
+#if defined(LESOMNUS_CHANNEL_ASAN)
+		__sanitizer_finish_switch_fiber(fake_stack, nullptr, nullptr);
+#endif
+	}
+
+	void switch_out_() {
+#if defined(LESOMNUS_CHANNEL_ASAN)
+		// The fake stack of a finished fiber is freed.
+		__sanitizer_start_switch_fiber(is_done_ ? nullptr : &asan_fake_stack_, asan_caller_bottom_, asan_caller_size_);
+#endif
+#if defined(LESOMNUS_CHANNEL_TSAN)
+		__tsan_switch_to_fiber(caller_tsan_fiber_, 0);
+#endif
+
+#if defined(LESOMNUS_CHANNEL_FIBER_SWITCH_X86_64)
+		switch_context(&sp_, caller_sp_, nullptr);
+#else
+		::swapcontext(&ctx_, &caller_);
+#endif
+		on_switched_in_(false);
+	}
+
+	void on_switched_in_([[maybe_unused]] bool is_first) noexcept {
+#if defined(LESOMNUS_CHANNEL_ASAN)
+		// The caller is the thread running the fiber this time.
+		__sanitizer_finish_switch_fiber(is_first ? nullptr : asan_fake_stack_, &asan_caller_bottom_, &asan_caller_size_);
+#endif
+	}
+
+	executor*         ex_;
+	stack_pool::stack stack_;
+
+#if defined(LESOMNUS_CHANNEL_FIBER_SWITCH_X86_64)
+	void* sp_        = nullptr;
+	void* caller_sp_ = nullptr;
+#else
+	ucontext_t ctx_;
+	ucontext_t caller_;
+#endif
+
+	void (*after_)(void*) = nullptr;
+	void* after_arg_      = nullptr;
+	bool  is_done_        = false;
+
+#if defined(LESOMNUS_CHANNEL_ASAN)
+	void*       asan_fake_stack_    = nullptr;
+	void const* asan_caller_bottom_ = nullptr;
+	std::size_t asan_caller_size_   = 0;
+#endif
+#if defined(LESOMNUS_CHANNEL_TSAN)
+	void* tsan_fiber_        = nullptr;
+	void* caller_tsan_fiber_ = nullptr;
+#endif
+};
+
+template<typename F>
+class fn_fiber final: public fiber {
+   public:
+	template<typename U>
+	fn_fiber(executor& ex, std::size_t stack_size, bool guarded, U&& f)
+	    : fiber(ex, stack_size, guarded)
+	    , f_(std::forward<U>(f)) { }
+
+   protected:
+	void invoke_() override {
+		f_();
+	}
+
+   private:
+	F f_;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Default size of the fiber stacks.
+ */
+inline constexpr std::size_t DefaultFiberStackSize = 64 * 1024;
+
+/**
+ * @brief Runs the function in a new fiber on the executor.
+ *
+ * The blocking operations of the channels called in the fiber, such as `recv`, `send`, `select`,
+ * and the reads and writes of \ref basic_byte_channel, suspend the fiber instead of blocking the thread so the thread runs the other fibers in the meantime.
+ * Other blocking calls, including \ref wait_set, still block the thread.
+ *
+ * A fiber may be resumed on another thread of the executor,
+ * so the addresses of the `thread_local` variables may change across the blocking operations.
+ *
+ * @param ex Executor running the fiber. It must not run the works inline, such as \ref inline_executor.
+ * @param f Function to run.
+ * @param stack_size Size of the stack of the fiber. It is not grown.
+ * @param guarded Whether the stack has a guard page so overflowing it faults instead of corrupting another stack.
+ *                A guarded stack costs two memory mappings, so the number of such fibers is bound by `vm.max_map_count`.
+ */
+template<typename F>
+requires std::is_invocable_v<std::decay_t<F>&>
+void spawn_fiber(executor& ex, F&& f, std::size_t stack_size = DefaultFiberStackSize, bool guarded = false) {
+	ex.post(*new detail::fn_fiber<std::decay_t<F>>(ex, stack_size, guarded, std::forward<F>(f)));
+}
+
+/**
+ * @brief Runs the function in a new fiber.
+ *
+ * It runs on the executor running the current thread, or on \ref thread_pool::global if there is no such executor.
+ */
+template<typename F>
+requires std::is_invocable_v<std::decay_t<F>&>
+void spawn_fiber(F&& f, std::size_t stack_size = DefaultFiberStackSize, bool guarded = false) {
+	if(detail::current_executor != nullptr) {
+		spawn_fiber(*detail::current_executor, std::forward<F>(f), stack_size, guarded);
+	} else {
+		spawn_fiber(thread_pool::global(), std::forward<F>(f), stack_size, guarded);
+	}
+}
+
+}  // namespace channel
+}  // namespace lesomnus
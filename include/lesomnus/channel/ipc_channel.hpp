@@ -0,0 +1,525 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/channel.hpp"
+#include "lesomnus/channel/detail/cache_line.hpp"
+#include "lesomnus/channel/detail/futex.hpp"
+#include "lesomnus/channel/error.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+namespace detail {
+
+/**
+ * @brief Number of the times a waiter retries before it sleeps on the futex.
+ */
+inline constexpr int IpcSpinCount = 128;
+
+/**
+ * @brief How long an open waits for the creator to finish initializing the segment.
+ */
+inline constexpr std::chrono::seconds IpcOpenTimeout(1);
+
+/**
+ * @brief Futex word bumped whenever the waiters on it may proceed.
+ */
+struct alignas(CacheLineSize) ipc_event {
+	std::atomic<std::uint32_t> seq         = 0;
+	std::atomic<std::uint32_t> num_waiters = 0;
+
+	void notify() noexcept {
+		seq.fetch_add(1);
+		if(num_waiters.load() > 0) {
+			futex_wake_all(seq);
+		}
+	}
+};
+
+/**
+ * @brief FNV-1a hash of the name of \p T as the compiler spells it.
+ */
+template<typename T>
+consteval std::uint64_t type_hash() {
+	std::string_view const name = __PRETTY_FUNCTION__;
+
+	std::uint64_t h = 0xcbf29ce484222325;
+	for(char const c: name) {
+		h ^= static_cast<unsigned char>(c);
+		h *= 0x100000001b3;
+	}
+	return h;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Identifies the type of the values of an \ref ipc_channel, so a segment is not opened with another type of the same size.
+ *
+ * It is a hash of the type name as the compiler spells it;
+ * specialize it if the processes are built by different compilers.
+ */
+template<typename T>
+inline constexpr std::uint64_t ipc_type_id = detail::type_hash<T>();
+
+namespace detail {
+
+/**
+ * @brief Layout of the shared memory of an \ref ipc_channel.
+ *
+ * The ring is the bounded MPMC queue by Dmitry Vyukov: each slot has a sequence number
+ * that tells whether it is ready to be written or read at the position, so senders and receivers
+ * only contend on \ref tail and \ref head respectively.
+ */
+template<typename T, std::size_t Cap>
+struct ipc_segment {
+	static constexpr std::uint64_t Magic = 0x6c65736f6d6e7573;  // "lesomnus"
+
+	struct slot {
+		std::atomic<std::uint64_t> seq;
+		T                          value;
+	};
+
+	ipc_segment() {
+		for(std::size_t i = 0; i < Cap; ++i) {
+			slots[i].seq.store(i, std::memory_order_relaxed);
+		}
+
+		// Published last so the other processes see the initialized segment.
+		magic.store(Magic, std::memory_order_release);
+	}
+
+	/**
+	 * @return True if the segment is initialized for the same type of the values and capacity.
+	 */
+	bool is_compatible() const noexcept {
+		return magic.load(std::memory_order_acquire) == Magic
+		       && size == sizeof(ipc_segment)
+		       && value_size == sizeof(T)
+		       && value_align == alignof(T)
+		       && capacity == Cap
+		       && type_id == ipc_type_id<T>;
+	}
+
+	std::atomic<std::uint64_t> magic       = 0;
+	std::uint64_t              size        = sizeof(ipc_segment);
+	std::uint64_t              value_size  = sizeof(T);
+	std::uint64_t              value_align = alignof(T);
+	std::uint64_t              capacity    = Cap;
+	std::uint64_t              type_id     = ipc_type_id<T>;
+	std::atomic<std::uint32_t> is_closed   = 0;
+
+	alignas(CacheLineSize) std::atomic<std::uint64_t> head = 0;
+	alignas(CacheLineSize) std::atomic<std::uint64_t> tail = 0;
+
+	ipc_event readable;
+	ipc_event writable;
+
+	slot slots[Cap];
+};
+
+}  // namespace detail
+
+/**
+ * @brief Bounded channel between processes over shared memory (Linux only).
+ *
+ * The values are copied into a lock-free ring in a `shm_open` or `memfd` segment,
+ * and the waiting processes sleep on futexes in the segment, which are woken up only if someone sleeps.
+ * A waiter spins for a short while before it sleeps, so a busy peer hands a value over without a syscall.
+ * The operations follow the contract of \ref bounded_channel, including that closing it discards the buffered values.
+ * A process that dies while it is copying a value leaves the slot unfinished, which blocks the slots after it.
+ *
+ * @tparam T Trivially copyable type of the values, which are copied between the address spaces.
+ * @tparam Cap Capacity of the ring; it must not be 0.
+ */
+template<typename T, std::size_t Cap>
+requires std::is_trivially_copyable_v<T> && (Cap > 0) && (Cap != unbounded_capacity)
+class ipc_channel {
+	using segment = detail::ipc_segment<T, Cap>;
+
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+	static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+   public:
+	/**
+	 * @brief Creates a channel in a new named segment that other processes can \ref open.
+	 *
+	 * @param name Name passed to `shm_open`, such as "/my-channel".
+	 * @throws std::system_error If the segment exists or cannot be mapped.
+	 */
+	static ipc_channel create(std::string const& name) {
+		int const fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if(fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "shm_open");
+		}
+
+		try {
+			return ipc_channel(fd, true);
+		} catch(...) {
+			::shm_unlink(name.c_str());
+			throw;
+		}
+	}
+
+	/**
+	 * @brief Opens the channel made by \ref create.
+	 *
+	 * It may run while \ref create is still initializing the segment; it then waits up to \ref detail::IpcOpenTimeout
+	 * for the segment to be initialized.
+	 *
+	 * @throws std::system_error If the segment does not exist or is not a channel of the same type and capacity,
+	 * which is told by \ref ipc_type_id, or with `ETIMEDOUT` if the segment is not initialized in time.
+	 */
+	static ipc_channel open(std::string const& name) {
+		int const fd = ::shm_open(name.c_str(), O_RDWR, 0);
+		if(fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "shm_open");
+		}
+
+		return ipc_channel(fd, false);
+	}
+
+	/**
+	 * @brief Removes the name of the segment; the mapped channels stay usable.
+	 */
+	static void unlink(std::string const& name) noexcept {
+		::shm_unlink(name.c_str());
+	}
+
+	/**
+	 * @brief Creates a channel in an anonymous `memfd` segment.
+	 *
+	 * It is shared with the child processes made by `fork`, or with other processes by passing \ref fd.
+	 *
+	 * @throws std::system_error If the segment cannot be mapped.
+	 */
+	static ipc_channel create_anonymous() {
+		int const fd = ::memfd_create("lesomnus-ipc-channel", MFD_CLOEXEC);
+		if(fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "memfd_create");
+		}
+
+		return ipc_channel(fd, true);
+	}
+
+	/**
+	 * @brief Opens the channel of the segment \p fd made by \ref create_anonymous in another process.
+	 *
+	 * @param fd File descriptor that the channel takes the ownership of.
+	 */
+	static ipc_channel open_fd(int fd) {
+		return ipc_channel(fd, false);
+	}
+
+	ipc_channel(ipc_channel const& other) = delete;
+
+	ipc_channel(ipc_channel&& other) noexcept
+	    : fd_(std::exchange(other.fd_, -1))
+	    , seg_(std::exchange(other.seg_, nullptr)) { }
+
+	ipc_channel& operator=(ipc_channel const& other) = delete;
+
+	ipc_channel& operator=(ipc_channel&& other) noexcept {
+		std::swap(fd_, other.fd_);
+		std::swap(seg_, other.seg_);
+		return *this;
+	}
+
+	~ipc_channel() {
+		if(seg_ != nullptr) {
+			::munmap(seg_, sizeof(segment));
+		}
+		if(fd_ >= 0) {
+			::close(fd_);
+		}
+	}
+
+	/**
+	 * @return File descriptor of the segment.
+	 */
+	[[nodiscard]] int fd() const noexcept {
+		return fd_;
+	}
+
+	[[nodiscard]] constexpr std::size_t capacity() const noexcept {
+		return Cap;
+	}
+
+	/**
+	 * @brief Returns the approximate number of the buffered values.
+	 */
+	[[nodiscard]] std::size_t size() const noexcept {
+		auto const head = seg_->head.load(std::memory_order_relaxed);
+		auto const tail = seg_->tail.load(std::memory_order_relaxed);
+		return tail > head ? static_cast<std::size_t>(tail - head) : 0;
+	}
+
+	/**
+	 * @brief Closes the channel for all the processes and releases their waiting operations.
+	 */
+	void close() noexcept {
+		seg_->is_closed.store(1);
+		seg_->readable.notify();
+		seg_->writable.notify();
+	}
+
+	void try_send(T const& value, std::error_code& ec) noexcept {
+		ec = try_send_(value);
+	}
+
+	bool try_send(T const& value) noexcept {
+		return try_send_(value) == channel_errc::ok;
+	}
+
+	void send(std::stop_token token, T const& value, std::error_code& ec) {
+		send_until(std::move(token), std::chrono::steady_clock::time_point::max(), value, ec);
+	}
+
+	bool send(std::stop_token token, T const& value) {
+		std::error_code ec;
+		send(std::move(token), value, ec);
+		return ec == channel_errc::ok;
+	}
+
+	bool send(T const& value) {
+		return send(std::stop_token{}, value);
+	}
+
+	void send_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T const& value, std::error_code& ec) {
+		ec = wait_(seg_->writable, token, deadline, [&] { return try_send_(value); });
+	}
+
+	template<typename Rep, typename Period>
+	void send_for(std::chrono::duration<Rep, Period> const& timeout, T const& value, std::error_code& ec) {
+		send_until(std::stop_token{}, detail::to_deadline(timeout), value, ec);
+	}
+
+	void try_recv(T& value, std::error_code& ec) noexcept {
+		ec = try_recv_(value);
+	}
+
+	bool try_recv(T& value) noexcept {
+		return try_recv_(value) == channel_errc::ok;
+	}
+
+	void recv(std::stop_token token, T& value, std::error_code& ec) {
+		recv_until(std::move(token), std::chrono::steady_clock::time_point::max(), value, ec);
+	}
+
+	bool recv(std::stop_token token, T& value) {
+		std::error_code ec;
+		recv(std::move(token), value, ec);
+		return ec == channel_errc::ok;
+	}
+
+	bool recv(T& value) {
+		return recv(std::stop_token{}, value);
+	}
+
+	void recv_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T& value, std::error_code& ec) {
+		ec = wait_(seg_->readable, token, deadline, [&] { return try_recv_(value); });
+	}
+
+	template<typename Rep, typename Period>
+	void recv_for(std::chrono::duration<Rep, Period> const& timeout, T& value, std::error_code& ec) {
+		recv_until(std::stop_token{}, detail::to_deadline(timeout), value, ec);
+	}
+
+   private:
+	/**
+	 * @param fd File descriptor of the segment that the channel takes the ownership of.
+	 * @param init True if the segment is new and must be initialized.
+	 */
+	ipc_channel(int fd, bool init)
+	    : fd_(fd) {
+		if(init && ::ftruncate(fd_, sizeof(segment)) != 0) {
+			fail_("ftruncate");
+		}
+
+		// A segment being created is empty until it is truncated, and its magic is 0 until it is initialized.
+		auto const deadline = std::chrono::steady_clock::now() + detail::IpcOpenTimeout;
+
+		struct stat st{};
+		while(true) {
+			if(::fstat(fd_, &st) != 0) {
+				fail_("fstat");
+			}
+			if(init || st.st_size != 0) {
+				break;
+			}
+			if(!wait_for_creator_(deadline)) {
+				errno = ETIMEDOUT;
+				fail_("ipc_channel");
+			}
+		}
+		if(static_cast<std::size_t>(st.st_size) != sizeof(segment)) {
+			errno = EINVAL;
+			fail_("ipc_channel");
+		}
+
+		void* const p = ::mmap(nullptr, sizeof(segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+		if(p == MAP_FAILED) {
+			fail_("mmap");
+		}
+
+		if(init) {
+			seg_ = ::new(p) segment();
+		} else {
+			seg_ = static_cast<segment*>(p);
+			while(seg_->magic.load(std::memory_order_acquire) == 0) {
+				if(!wait_for_creator_(deadline)) {
+					errno = ETIMEDOUT;
+					fail_("ipc_channel");
+				}
+			}
+			if(!seg_->is_compatible()) {
+				errno = EINVAL;
+				fail_("ipc_channel");
+			}
+		}
+	}
+
+	/**
+	 * @return False if \p deadline is exceeded.
+	 */
+	static bool wait_for_creator_(std::chrono::steady_clock::time_point deadline) {
+		if(std::chrono::steady_clock::now() >= deadline) {
+			return false;
+		}
+
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+		return true;
+	}
+
+	[[noreturn]] void fail_(char const* what) {
+		auto const err = errno;
+		if(seg_ != nullptr) {
+			::munmap(seg_, sizeof(segment));
+		}
+		::close(fd_);
+		throw std::system_error(err, std::generic_category(), what);
+	}
+
+	std::error_code try_send_(T const& value) noexcept {
+		if(seg_->is_closed.load(std::memory_order_acquire) != 0) [[unlikely]] {
+			return channel_errc::closed;
+		}
+
+		auto pos = seg_->tail.load(std::memory_order_relaxed);
+		while(true) {
+			auto&      s    = seg_->slots[pos % Cap];
+			auto const seq  = s.seq.load(std::memory_order_acquire);
+			auto const diff = static_cast<std::int64_t>(seq - pos);
+			if(diff == 0) {
+				if(seg_->tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					s.value = value;
+					s.seq.store(pos + 1, std::memory_order_release);
+					seg_->readable.notify();
+					return channel_errc::ok;
+				}
+			} else if(diff < 0) {
+				// The slot is not read yet since the previous lap.
+				return channel_errc::exhausted;
+			} else {
+				pos = seg_->tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	std::error_code try_recv_(T& value) noexcept {
+		if(seg_->is_closed.load(std::memory_order_acquire) != 0) [[unlikely]] {
+			return channel_errc::closed;
+		}
+
+		auto pos = seg_->head.load(std::memory_order_relaxed);
+		while(true) {
+			auto&      s    = seg_->slots[pos % Cap];
+			auto const seq  = s.seq.load(std::memory_order_acquire);
+			auto const diff = static_cast<std::int64_t>(seq - (pos + 1));
+			if(diff == 0) {
+				if(seg_->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					value = s.value;
+					s.seq.store(pos + Cap, std::memory_order_release);
+					seg_->writable.notify();
+					return channel_errc::ok;
+				}
+			} else if(diff < 0) {
+				// The slot is not written yet.
+				return channel_errc::exhausted;
+			} else {
+				pos = seg_->head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * @brief Retries \p op until it is not exhausted, sleeping on \p ev between the attempts.
+	 *
+	 * The sequence of \p ev is read before each attempt, so a peer that makes progress after the attempt
+	 * changes it and the futex does not sleep.
+	 */
+	template<typename F>
+	static std::error_code wait_(detail::ipc_event& ev, std::stop_token const& token, std::chrono::steady_clock::time_point deadline, F&& op) {
+		for(int i = 0;; ++i) {
+			if(token.stop_requested()) [[unlikely]] {
+				return channel_errc::canceled;
+			}
+
+			auto const seq = ev.seq.load();
+
+			auto const ec = op();
+			if(ec != channel_errc::exhausted) {
+				return ec;
+			}
+
+			if(i < detail::IpcSpinCount) {
+				detail::cpu_relax();
+				continue;
+			}
+
+			bool is_timed_out = false;
+
+			ev.num_waiters.fetch_add(1);
+			{
+				// Wakes up every waiter on the event; the others go back to sleep.
+				std::stop_callback on_cancel(token, [&ev] {
+					ev.seq.fetch_add(1);
+					detail::futex_wake_all(ev.seq);
+				});
+
+				is_timed_out = !detail::futex_wait(ev.seq, seq, deadline);
+			}
+			ev.num_waiters.fetch_sub(1);
+
+			if(is_timed_out) {
+				auto const ec = op();
+				return ec == channel_errc::exhausted ? make_error_code(channel_errc::timeout) : ec;
+			}
+		}
+	}
+
+	int      fd_  = -1;
+	segment* seg_ = nullptr;
+};
+
+}  // namespace channel
+}  // namespace lesomnus
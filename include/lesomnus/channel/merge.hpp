@@ -0,0 +1,125 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <stop_token>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/error.hpp"
+#include "lesomnus/channel/wait_set.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+namespace detail {
+
+/**
+ * @brief Number of the values taken from an input at once by \ref merge.
+ */
+inline constexpr std::size_t MergeBatchSize = 64;
+
+/**
+ * @brief Sends all the values, locking the output once while it has room.
+ */
+template<typename T>
+bool forward_all(std::stop_token const& token, sender<T>& output, std::span<T> values, std::error_code& ec) {
+	std::size_t sent = 0;
+	while(sent < values.size()) {
+		sent += output.try_send_many(values.subspan(sent), ec);
+		if(ec == channel_errc::closed) {
+			return false;
+		}
+		if(sent == values.size()) {
+			break;
+		}
+
+		// The output is full, so it waits for the room for the next one.
+		output.send(token, std::move(values[sent]), ec);
+		if(ec != channel_errc::ok) {
+			return false;
+		}
+		++sent;
+	}
+
+	return true;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Forwards the values from all the inputs to the output until all the inputs are closed.
+ *
+ * It runs on the calling thread. The inputs are registered once on a \ref wait_set,
+ * so waiting costs nothing per value. The ready inputs are drained in batches,
+ * and each batch is sent to the output with a single lock while the output has room.
+ * The values from an input keep their order, but the values from different inputs interleave.
+ *
+ * @param token Interrupt register.
+ * @param inputs Pointers to the input channels that outlive the call.
+ * @param output Channel where the values are sent.
+ * @param[out] ec \a ok if all the inputs are closed, \a closed if the output is closed, or \a canceled.
+ */
+template<typename T, std::ranges::input_range R>
+requires std::convertible_to<std::ranges::range_reference_t<R>, receiver<T>*>
+void merge(std::stop_token token, R&& inputs, sender<T>& output, std::error_code& ec) {
+	wait_set ws;
+
+	std::vector<receiver<T>*> chans;
+	for(receiver<T>* const chan: inputs) {
+		auto const key = ws.watch_recv(*chan);
+		if(chans.size() <= key) {
+			chans.resize(key + 1);
+		}
+
+		chans[key] = chan;
+	}
+
+	std::size_t num_open = chans.size();
+
+	std::vector<wait_set::key_type> keys(chans.size());
+	std::vector<T>                  values(detail::MergeBatchSize);
+	while(num_open > 0) {
+		auto const n = ws.wait(token, keys);
+		if(n == 0) {
+			ec = channel_errc::canceled;
+			return;
+		}
+
+		for(std::size_t i = 0; i < n; ++i) {
+			auto const m = chans[keys[i]]->try_recv_many(values, ec);
+			if(ec == channel_errc::closed) {
+				ws.unwatch(keys[i]);
+				--num_open;
+			}
+
+			if(!detail::forward_all(token, output, std::span<T>(values).first(m), ec)) {
+				return;
+			}
+		}
+	}
+
+	ec = channel_errc::ok;
+}
+
+/**
+ * @brief Forwards the values from all the inputs to the output until all the inputs are closed.
+ *
+ * @param inputs Pointers to the input channels that outlive the call.
+ * @param output Channel where the values are sent.
+ * @return False if the output is closed.
+ */
+template<typename T, std::ranges::input_range R>
+requires std::convertible_to<std::ranges::range_reference_t<R>, receiver<T>*>
+bool merge(R&& inputs, sender<T>& output) {
+	std::error_code ec;
+	merge(std::stop_token{}, std::forward<R>(inputs), output, ec);
+	return ec == channel_errc::ok;
+}
+
+}  // namespace channel
+}  // namespace lesomnus
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <numeric>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "lesomnus/channel/byte_channel.hpp"
+#include "lesomnus/channel/channel.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Ring memory mapped twice back-to-back (Linux only).
+ *
+ * The same `memfd` is mapped at `data()` and at `data() + size()`,
+ * so any window `[pos, pos + len)` with `pos < size()` and `len <= size()` is contiguous.
+ */
+class mirrored_ring {
+   public:
+	static constexpr bool is_mirrored = true;
+
+	/**
+	 * @param min_size Minimum size in bytes; it is rounded up to a multiple of the page size and of \p unit.
+	 * @param unit Size of an element so the ring holds a whole number of them.
+	 *
+	 * @throws std::system_error If the memory cannot be mapped.
+	 */
+	explicit mirrored_ring(std::size_t min_size, std::size_t unit = 1) {
+		auto const granule = std::lcm(page_size(), unit);
+
+		size_ = (std::max<std::size_t>(1, min_size) + granule - 1) / granule * granule;
+
+		int const fd = ::memfd_create("lesomnus-channel-ring", MFD_CLOEXEC);
+		if(fd < 0) {
+			throw std::system_error(errno, std::generic_category(), "memfd_create");
+		}
+		if(::ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+			auto const err = errno;
+			::close(fd);
+			throw std::system_error(err, std::generic_category(), "ftruncate");
+		}
+
+		// Reserves the address range for both of the views first so they are adjacent.
+		void* const base = ::mmap(nullptr, 2 * size_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(base == MAP_FAILED) {
+			auto const err = errno;
+			::close(fd);
+			throw std::system_error(err, std::generic_category(), "mmap");
+		}
+
+		data_ = static_cast<std::byte*>(base);
+		for(std::byte* const view: {data_, data_ + size_}) {
+			if(::mmap(view, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+				auto const err = errno;
+				::close(fd);
+				::munmap(base, 2 * size_);
+				throw std::system_error(err, std::generic_category(), "mmap");
+			}
+		}
+
+		// The mappings keep the file alive.
+		::close(fd);
+	}
+
+	mirrored_ring(mirrored_ring const& other) = delete;
+
+	mirrored_ring(mirrored_ring&& other) noexcept
+	    : data_(std::exchange(other.data_, nullptr))
+	    , size_(std::exchange(other.size_, 0)) { }
+
+	mirrored_ring& operator=(mirrored_ring const& other) = delete;
+
+	mirrored_ring& operator=(mirrored_ring&& other) noexcept {
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		return *this;
+	}
+
+	~mirrored_ring() {
+		if(data_ != nullptr) {
+			::munmap(data_, 2 * size_);
+		}
+	}
+
+	/**
+	 * @return Start of the first view; the second view follows right after it.
+	 */
+	[[nodiscard]] std::byte* data() const noexcept {
+		return data_;
+	}
+
+	/**
+	 * @return Size of a view in bytes.
+	 */
+	[[nodiscard]] std::size_t size() const noexcept {
+		return size_;
+	}
+
+	static std::size_t page_size() noexcept {
+		static std::size_t const size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		return size;
+	}
+
+   private:
+	std::byte*  data_ = nullptr;
+	std::size_t size_ = 0;
+};
+
+/**
+ * @brief Fixed size queue of trivially copyable values in a \ref mirrored_ring.
+ *
+ * It can be the buffer of a \ref bounded_channel, and its values are always contiguous from the front.
+ */
+template<typename T, std::size_t Cap>
+requires std::is_trivially_copyable_v<T> && (Cap > 0) && (Cap != unbounded_capacity)
+class mirrored_queue {
+   public:
+	mirrored_queue()
+	    : ring_(Cap * sizeof(T), sizeof(T))
+	    , capacity_(ring_.size() / sizeof(T)) { }
+
+	[[nodiscard]] bool empty() const noexcept {
+		return size_ == 0;
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return size_;
+	}
+
+	[[nodiscard]] T& front() noexcept {
+		assert(!empty());
+		return data_()[head_];
+	}
+
+	void pop() noexcept {
+		assert(!empty());
+		head_ = (head_ + 1) % capacity_;
+		--size_;
+	}
+
+	template<typename... Args>
+	void emplace(Args&&... args) {
+		assert(size_ < capacity_);
+		::new(static_cast<void*>(data_() + (head_ + size_) % capacity_)) T(std::forward<Args>(args)...);
+		++size_;
+	}
+
+	/**
+	 * @return The values from the front, contiguous even if they wrap around the end of the ring.
+	 */
+	[[nodiscard]] std::span<T> values() noexcept {
+		return {data_() + head_, size_};
+	}
+
+   private:
+	[[nodiscard]] T* data_() const noexcept {
+		return reinterpret_cast<T*>(ring_.data());
+	}
+
+	mirrored_ring ring_;
+	std::size_t   capacity_;
+	std::size_t   head_ = 0;
+	std::size_t   size_ = 0;
+};
+
+/**
+ * @brief \ref byte_channel whose regions never wrap around.
+ */
+using mirrored_byte_channel = basic_byte_channel<mirrored_ring>;
+
+/**
+ * @brief \ref bounded_channel whose values are kept in a \ref mirrored_queue.
+ *
+ * \ref bounded_channel::recv_region returns all the buffered values in place without a wraparound,
+ * and \ref bounded_channel::try_recv_many moves them out in one step.
+ */
+template<typename T, std::size_t Cap>
+using mirrored_channel = bounded_channel<T, Cap, mirrored_queue<T, Cap>>;
+
+}  // namespace channel
+}  // namespace lesomnus
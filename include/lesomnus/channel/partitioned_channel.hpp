@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <stop_token>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/channel.hpp"
+#include "lesomnus/channel/error.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Channel split into partitions by the key of the values.
+ *
+ * The values with the same key are always sent to the same partition,
+ * and each partition is received by its own consumer, so the values of a key are received in order
+ * while the different keys are consumed in parallel.
+ * Each partition has its own lock, so a sender locks only the partition of its value.
+ *
+ * @tparam KeyFn `Key(T const&)`; the key must be hashable by `std::hash`.
+ * @tparam Cap Capacity of each partition.
+ */
+template<typename T, typename KeyFn, std::size_t Cap = 0>
+requires std::is_invocable_v<KeyFn const&, T const&>
+class partitioned_channel {
+   public:
+	using key_type = std::remove_cvref_t<std::invoke_result_t<KeyFn const&, T const&>>;
+
+	/**
+	 * @param num_partitions Number of the partitions.
+	 * @throws std::invalid_argument If \p num_partitions is 0.
+	 */
+	explicit partitioned_channel(std::size_t num_partitions, KeyFn key_fn = KeyFn())
+	    : key_fn_(std::move(key_fn)) {
+		if(num_partitions == 0) {
+			throw std::invalid_argument("partitioned_channel needs at least one partition");
+		}
+
+		partitions_.reserve(num_partitions);
+		for(std::size_t i = 0; i < num_partitions; ++i) {
+			partitions_.push_back(std::make_unique<bounded_channel<T, Cap>>());
+		}
+	}
+
+	[[nodiscard]] std::size_t num_partitions() const noexcept {
+		return partitions_.size();
+	}
+
+	/**
+	 * @return Index of the partition the value is sent to.
+	 */
+	[[nodiscard]] std::size_t partition_of(T const& value) const {
+		return std::hash<key_type>{}(std::invoke(key_fn_, value)) % partitions_.size();
+	}
+
+	/**
+	 * @return Receiving end of the \p i th partition that is owned by a single consumer.
+	 */
+	[[nodiscard]] receiver<T>& partition(std::size_t i) noexcept {
+		assert(i < partitions_.size());
+		return *partitions_[i];
+	}
+
+	/**
+	 * @return Sending end of the partition the value belongs to.
+	 */
+	[[nodiscard]] sender<T>& route(T const& value) {
+		return *partitions_[partition_of(value)];
+	}
+
+	/**
+	 * @brief Sends the value to its partition without waiting.
+	 *
+	 * @see sender::try_send
+	 */
+	template<typename U>
+	requires std::convertible_to<U, T>
+	void try_send(U&& value, std::error_code& ec) {
+		routed_(std::forward<U>(value), [&](sender<T>& s, auto&& v) { s.try_send(std::forward<decltype(v)>(v), ec); });
+	}
+
+	template<typename U>
+	requires std::convertible_to<U, T>
+	bool try_send(U&& value) {
+		return routed_(std::forward<U>(value), [](sender<T>& s, auto&& v) { return s.try_send(std::forward<decltype(v)>(v)); });
+	}
+
+	/**
+	 * @brief Sends the value to its partition.
+	 *
+	 * @see sender::send
+	 */
+	template<typename U>
+	requires std::convertible_to<U, T>
+	void send(std::stop_token token, U&& value, std::error_code& ec) {
+		routed_(std::forward<U>(value), [&](sender<T>& s, auto&& v) { s.send(std::move(token), std::forward<decltype(v)>(v), ec); });
+	}
+
+	template<typename U>
+	requires std::convertible_to<U, T>
+	bool send(std::stop_token token, U&& value) {
+		return routed_(std::forward<U>(value), [&](sender<T>& s, auto&& v) { return s.send(std::move(token), std::forward<decltype(v)>(v)); });
+	}
+
+	template<typename U>
+	requires std::convertible_to<U, T>
+	bool send(U&& value) {
+		return routed_(std::forward<U>(value), [](sender<T>& s, auto&& v) { return s.send(std::forward<decltype(v)>(v)); });
+	}
+
+	/**
+	 * @return Sum of the sizes of the partitions.
+	 */
+	[[nodiscard]] std::intmax_t size() const {
+		std::intmax_t n = 0;
+		for(auto const& p: partitions_) {
+			n += p->size();
+		}
+
+		return n;
+	}
+
+	/**
+	 * @brief Closes all the partitions.
+	 */
+	void close() {
+		for(auto& p: partitions_) {
+			p->close();
+		}
+	}
+
+   private:
+	/**
+	 * @brief Invokes \p f with the partition of the value and the value.
+	 *
+	 * A value of another type is converted once, and its key is computed from the converted value that is sent.
+	 */
+	template<typename U, typename F>
+	decltype(auto) routed_(U&& value, F&& f) {
+		if constexpr(std::same_as<std::remove_cvref_t<U>, T>) {
+			return f(route(value), std::forward<U>(value));
+		} else {
+			T v(std::forward<U>(value));
+			return f(route(v), std::move(v));
+		}
+	}
+
+	[[no_unique_address]] KeyFn key_fn_;
+
+	std::vector<std::unique_ptr<bounded_channel<T, Cap>>> partitions_;
+};
+
+}  // namespace channel
+}  // namespace lesomnus
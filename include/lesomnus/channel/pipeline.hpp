@@ -0,0 +1,665 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/channel.hpp"
+#include "lesomnus/channel/error.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Statistics of a stage of a \ref pipeline.
+ */
+struct stage_stats {
+	std::size_t num_workers = 0;
+
+	// Number of the values the stage took from its input.
+	std::uint64_t num_processed = 0;
+
+	// Processed values per second since the pipeline started.
+	double throughput = 0;
+
+	// Number of the values waiting in the input of the stage.
+	std::ptrdiff_t queue_depth = 0;
+};
+
+namespace detail {
+
+/**
+ * @brief Number of the values a worker of a pipeline takes at once if they are available.
+ */
+inline constexpr std::size_t PipelineBatchSize = 32;
+
+template<typename R>
+struct stage_result {
+	using type = R;
+
+	static constexpr bool is_optional = false;
+};
+
+template<typename R>
+struct stage_result<std::optional<R>> {
+	using type = R;
+
+	static constexpr bool is_optional = true;
+};
+
+/**
+ * @brief Input of a stage connected to its upstream.
+ *
+ * Closing a channel discards its buffered values, so the stages do not close the channels between them.
+ * Instead, the upstream requests \ref done once it sends the last value,
+ * and the downstream stops once it drains the channel after that.
+ */
+template<typename T>
+struct pipeline_link {
+	std::shared_ptr<receiver<T>> chan;
+	std::stop_source             done;
+};
+
+/**
+ * @brief Restores the order of the results computed out of order.
+ *
+ * The values are numbered in the order they are taken, and their results are emitted in that order.
+ * The numbers are given only within the window from the head-of-line,
+ * so a slow head-of-line result holds back the workers from taking more values.
+ */
+template<typename T>
+class reorder_window {
+   public:
+	explicit reorder_window(std::size_t size)
+	    : slots_(size) { }
+
+	/**
+	 * @brief Waits until the window has room for the next value.
+	 *
+	 * @return Number of the values that can be numbered, or 0 if \p token is stop requested.
+	 */
+	std::size_t wait_room(std::stop_token const& token) {
+		std::unique_lock l(mutex_);
+		if(!cv_.wait(l, token, [this] { return next_ < head_ + slots_.size(); })) {
+			return 0;
+		}
+
+		return static_cast<std::size_t>(head_ + slots_.size() - next_);
+	}
+
+	/**
+	 * @return The number of the first value.
+	 */
+	std::uint64_t reserve(std::size_t n) {
+		std::scoped_lock l(mutex_);
+		return std::exchange(next_, next_ + n);
+	}
+
+	/**
+	 * @brief Puts the result of the value numbered \p seq.
+	 *
+	 * If no other thread is emitting, it emits the results from the head-of-line in order
+	 * until it meets the one not put yet. Empty results are skipped.
+	 *
+	 * @param emit `bool(T&&)`; it is invoked without the lock and returns false to stop emitting.
+	 * @return False if \p emit fails.
+	 */
+	template<typename F>
+	bool put(std::uint64_t seq, std::optional<T> result, F&& emit) {
+		std::unique_lock l(mutex_);
+
+		auto& s     = slots_[seq % slots_.size()];
+		s.result    = std::move(result);
+		s.is_filled = true;
+		if(is_emitting_) {
+			return true;
+		}
+
+		is_emitting_ = true;
+		bool ok      = true;
+		while(ok) {
+			auto& head = slots_[head_ % slots_.size()];
+			if(!head.is_filled) {
+				break;
+			}
+
+			auto r         = std::move(head.result);
+			head.result    = std::nullopt;
+			head.is_filled = false;
+			++head_;
+			cv_.notify_all();
+
+			if(r) {
+				l.unlock();
+				ok = emit(std::move(*r));
+				l.lock();
+			}
+		}
+
+		is_emitting_ = false;
+		return ok;
+	}
+
+   private:
+	struct slot {
+		std::optional<T> result;
+		bool             is_filled = false;
+	};
+
+	std::mutex                  mutex_;
+	std::condition_variable_any cv_;
+
+	std::vector<slot> slots_;
+	std::uint64_t     head_ = 0;
+	std::uint64_t     next_ = 0;
+
+	bool is_emitting_ = false;
+};
+
+class pipeline_stage {
+   public:
+	virtual ~pipeline_stage() = default;
+
+	virtual void start(std::chrono::steady_clock::time_point started_at) = 0;
+
+	/**
+	 * @brief Makes the workers return as soon as possible.
+	 */
+	virtual void stop() = 0;
+
+	virtual void join() = 0;
+
+	[[nodiscard]] virtual stage_stats stats() const = 0;
+};
+
+/**
+ * @brief Stage run by the worker threads.
+ *
+ * @tparam In Type of the input values; `void` if the stage generates the values.
+ * @tparam Out Type of the output values; `void` if the stage is a sink.
+ */
+template<typename In, typename Out, typename F, std::size_t Cap>
+class pipeline_runner final: public pipeline_stage {
+   public:
+	/**
+	 * @param window Size of the reorder window; 0 if the order need not be preserved.
+	 */
+	pipeline_runner(pipeline_link<In> in, F fn, std::size_t num_workers, std::size_t window = 0)
+	requires(!std::is_void_v<In>)
+	    : in_(std::move(in))
+	    , fn_(std::move(fn))
+	    , num_workers_(num_workers) {
+		if constexpr(!std::is_void_v<Out>) {
+			if(window > 0) {
+				window_ = std::make_unique<reorder_window<Out>>(window);
+			}
+		}
+	}
+
+	pipeline_runner(F fn)
+	requires std::is_void_v<In>
+	    : fn_(std::move(fn))
+	    , num_workers_(1) { }
+
+	~pipeline_runner() override {
+		stop();
+		join();
+	}
+
+	pipeline_link<Out> output() const
+	requires(!std::is_void_v<Out>)
+	{
+		return pipeline_link<Out>{out_, out_done_};
+	}
+
+	void start(std::chrono::steady_clock::time_point started_at) override {
+		started_at_ = started_at;
+		num_running_.store(num_workers_, std::memory_order_relaxed);
+		for(std::size_t i = 0; i < num_workers_; ++i) {
+			workers_.emplace_back([this](std::stop_token token) { run_(token); });
+		}
+	}
+
+	void stop() override {
+		for(auto& w: workers_) {
+			w.request_stop();
+		}
+		if constexpr(!std::is_void_v<In>) {
+			// Wakes up the workers waiting for the input.
+			in_.done.request_stop();
+		}
+	}
+
+	void join() override {
+		for(auto& w: workers_) {
+			if(w.joinable()) {
+				w.join();
+			}
+		}
+	}
+
+	[[nodiscard]] stage_stats stats() const override {
+		stage_stats s;
+		s.num_workers   = num_workers_;
+		s.num_processed = num_processed_.load(std::memory_order_relaxed);
+
+		std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - started_at_;
+		if(elapsed.count() > 0) {
+			s.throughput = static_cast<double>(s.num_processed) / elapsed.count();
+		}
+		if constexpr(!std::is_void_v<In>) {
+			s.queue_depth = std::max<std::ptrdiff_t>(0, in_.chan->size());
+		}
+
+		return s;
+	}
+
+   private:
+	struct empty { };
+
+	using buffer = std::conditional_t<std::is_void_v<Out>, empty, std::vector<Out>>;
+
+	void run_(std::stop_token token) {
+		if constexpr(std::is_void_v<In>) {
+			generate_(token);
+		} else {
+			consume_(token);
+		}
+
+		if(num_running_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			out_done_.request_stop();
+		}
+	}
+
+	void generate_(std::stop_token const& token) {
+		std::error_code ec;
+		while(!token.stop_requested()) {
+			std::optional<Out> v = fn_();
+			if(!v) {
+				return;
+			}
+
+			num_processed_.fetch_add(1, std::memory_order_relaxed);
+			out_->send(token, std::move(*v), ec);
+			if(ec != channel_errc::ok) {
+				return;
+			}
+		}
+	}
+
+	void consume_(std::stop_token const& token) {
+		std::vector<In> values(PipelineBatchSize);
+
+		[[maybe_unused]] buffer results;
+		while(!token.stop_requested()) {
+			std::uint64_t first = 0;
+
+			auto const n = take_(token, values, first);
+			if(n == 0) {
+				return;
+			}
+
+			num_processed_.fetch_add(n, std::memory_order_relaxed);
+			if constexpr(std::is_void_v<Out>) {
+				for(std::size_t i = 0; i < n; ++i) {
+					std::invoke(fn_, std::move(values[i]));
+				}
+			} else if(window_) {
+				auto const emit = [&](Out&& v) {
+					std::error_code ec;
+					out_->send(token, std::move(v), ec);
+					return ec == channel_errc::ok;
+				};
+				for(std::size_t i = 0; i < n; ++i) {
+					if(!window_->put(first + i, std::optional<Out>(std::invoke(fn_, std::move(values[i]))), emit)) {
+						return;
+					}
+				}
+			} else {
+				for(std::size_t i = 0; i < n; ++i) {
+					auto r = std::invoke(fn_, std::move(values[i]));
+					if constexpr(stage_result<decltype(r)>::is_optional) {
+						if(r) {
+							results.push_back(std::move(*r));
+						}
+					} else {
+						results.push_back(std::move(r));
+					}
+				}
+
+				if(!flush_(token, results)) {
+					return;
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Takes the available values from the input, or waits for one.
+	 *
+	 * If the order is preserved, the values are taken one worker at a time
+	 * so they are numbered in the order they are received.
+	 *
+	 * @param[out] first Number of the first value taken if the order is preserved.
+	 * @return The number of the values taken, or 0 if the worker must return.
+	 */
+	std::size_t take_(std::stop_token const& token, std::span<In> values, std::uint64_t& first) {
+		std::unique_lock<std::mutex> l;
+		if constexpr(!std::is_void_v<Out>) {
+			if(window_) {
+				l = std::unique_lock(take_mutex_);
+
+				auto const room = window_->wait_room(token);
+				if(room == 0) {
+					return 0;
+				}
+
+				values = values.first(std::min(room, values.size()));
+			}
+		}
+
+		std::error_code ec;
+		while(!token.stop_requested()) {
+			// Checked before the channel is drained, since no value is sent after it is requested.
+			bool const is_done = in_.done.stop_requested();
+
+			auto n = in_.chan->try_recv_many(values, ec);
+			if(n == 0) {
+				if(is_done || ec == channel_errc::closed) {
+					return 0;
+				}
+
+				in_.chan->recv(in_.done.get_token(), values[0], ec);
+				if(ec == channel_errc::canceled) {
+					continue;
+				}
+				if(ec != channel_errc::ok) {
+					return 0;
+				}
+
+				n = 1;
+			}
+
+			if constexpr(!std::is_void_v<Out>) {
+				if(window_) {
+					first = window_->reserve(n);
+				}
+			}
+
+			return n;
+		}
+
+		return 0;
+	}
+
+	bool flush_(std::stop_token const& token, buffer& results)
+	requires(!std::is_void_v<Out>)
+	{
+		std::error_code ec;
+
+		auto i = out_->try_send_many(results, ec);
+		for(; i < results.size(); ++i) {
+			out_->send(token, std::move(results[i]), ec);
+			if(ec != channel_errc::ok) {
+				return false;
+			}
+		}
+
+		results.clear();
+		return true;
+	}
+
+	[[no_unique_address]] std::conditional_t<std::is_void_v<In>, empty, pipeline_link<In>> in_;
+	[[no_unique_address]] std::conditional_t<std::is_void_v<Out>, empty, std::shared_ptr<chan<Out>>> out_ = make_output_();
+
+	// Requested once the last value is sent.
+	std::stop_source out_done_;
+
+	// Set if the order is preserved.
+	[[no_unique_address]] std::conditional_t<std::is_void_v<Out>, empty, std::unique_ptr<reorder_window<Out>>> window_;
+
+	std::mutex take_mutex_;
+
+	F           fn_;
+	std::size_t num_workers_;
+
+	std::vector<std::jthread> workers_;
+	std::atomic<std::size_t>  num_running_ = 0;
+
+	std::atomic<std::uint64_t>            num_processed_ = 0;
+	std::chrono::steady_clock::time_point started_at_;
+
+	static auto make_output_() {
+		if constexpr(std::is_void_v<Out>) {
+			return empty{};
+		} else {
+			return std::shared_ptr<chan<Out>>(std::make_shared<bounded_channel<Out, Cap>>());
+		}
+	}
+};
+
+template<typename F, std::size_t Cap>
+struct stage_spec {
+	F           fn;
+	std::size_t num_workers;
+	std::size_t window = 0;
+};
+
+template<typename F>
+struct sink_spec {
+	F           fn;
+	std::size_t num_workers;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Running chain of the stages connected by the channels.
+ *
+ * It is made by connecting a \ref source, \ref stage "stages", and a \ref sink with `|`.
+ * The values flow through the stages until the source ends, then the end is propagated
+ * to the downstream stages once each of them processes all the values from its upstream.
+ * Destroying it stops the workers without waiting for the values left.
+ */
+class pipeline {
+   public:
+	explicit pipeline(std::vector<std::unique_ptr<detail::pipeline_stage>> stages)
+	    : stages_(std::move(stages)) {
+		auto const now = std::chrono::steady_clock::now();
+		for(auto& s: stages_) {
+			s->start(now);
+		}
+	}
+
+	pipeline(pipeline const& other) = delete;
+	pipeline(pipeline&& other)      = default;
+
+	pipeline& operator=(pipeline const& other) = delete;
+	pipeline& operator=(pipeline&& other)      = default;
+
+	~pipeline() {
+		stop();
+	}
+
+	/**
+	 * @brief Waits until the sink processes the last value.
+	 */
+	void wait() {
+		for(auto& s: stages_) {
+			s->join();
+		}
+	}
+
+	/**
+	 * @brief Stops the workers of all the stages without waiting for the values left.
+	 */
+	void stop() {
+		for(auto& s: stages_) {
+			s->stop();
+		}
+		wait();
+	}
+
+	/**
+	 * @return Statistics of the stages from the source to the sink.
+	 */
+	[[nodiscard]] std::vector<stage_stats> stats() const {
+		std::vector<stage_stats> ss;
+		ss.reserve(stages_.size());
+		for(auto const& s: stages_) {
+			ss.push_back(s->stats());
+		}
+
+		return ss;
+	}
+
+   private:
+	std::vector<std::unique_ptr<detail::pipeline_stage>> stages_;
+};
+
+/**
+ * @brief Incomplete \ref pipeline whose last stage outputs \p T.
+ *
+ * Nothing runs until it is completed by a \ref sink.
+ */
+template<typename T>
+class pipeline_builder {
+   public:
+	explicit pipeline_builder(detail::pipeline_link<T> out, std::vector<std::unique_ptr<detail::pipeline_stage>> stages = {})
+	    : out_(std::move(out))
+	    , stages_(std::move(stages)) { }
+
+	/**
+	 * @brief Starts from the channel.
+	 *
+	 * The stop source of the link is made in place, since GCC 12 reports the one in a temporary link
+	 * as maybe uninitialized.
+	 */
+	explicit pipeline_builder(std::shared_ptr<receiver<T>> chan) {
+		out_.chan = std::move(chan);
+	}
+
+	template<typename F, std::size_t Cap>
+	requires std::is_invocable_v<F&, T&&>
+	friend auto operator|(pipeline_builder&& b, detail::stage_spec<F, Cap> spec) {
+		using U = typename detail::stage_result<std::invoke_result_t<F&, T&&>>::type;
+
+		auto r = std::make_unique<detail::pipeline_runner<T, U, F, Cap>>(std::move(b.out_), std::move(spec.fn), spec.num_workers, spec.window);
+
+		auto out = r->output();
+		b.stages_.push_back(std::move(r));
+		return pipeline_builder<U>(std::move(out), std::move(b.stages_));
+	}
+
+	template<typename F>
+	requires std::is_invocable_v<F&, T&&>
+	friend pipeline operator|(pipeline_builder&& b, detail::sink_spec<F> spec) {
+		b.stages_.push_back(std::make_unique<detail::pipeline_runner<T, void, F, 0>>(std::move(b.out_), std::move(spec.fn), spec.num_workers));
+		return pipeline(std::move(b.stages_));
+	}
+
+   private:
+	detail::pipeline_link<T> out_;
+
+	std::vector<std::unique_ptr<detail::pipeline_stage>> stages_;
+};
+
+/**
+ * @brief Starts a pipeline from the channel.
+ *
+ * The pipeline ends once the channel is closed.
+ * Since closing a channel discards its buffered values, close it after the values are received
+ * or use the generator overload.
+ */
+template<typename T>
+pipeline_builder<T> source(std::shared_ptr<receiver<T>> chan) {
+	return pipeline_builder<T>(std::move(chan));
+}
+
+/**
+ * @brief Same as above but the channel must outlive the pipeline.
+ */
+template<typename T>
+pipeline_builder<T> source(receiver<T>& chan) {
+	return source(std::shared_ptr<receiver<T>>(std::shared_ptr<void>(), &chan));
+}
+
+/**
+ * @brief Starts a pipeline from the values generated by \p fn on its own thread.
+ *
+ * @tparam Cap Capacity of the channel to the next stage.
+ * @param fn Returns the next value, or `std::nullopt` to end the pipeline.
+ */
+template<std::size_t Cap = detail::PipelineBatchSize, typename F>
+requires std::is_invocable_v<F&> && detail::stage_result<std::invoke_result_t<F&>>::is_optional
+auto source(F fn) {
+	using T = typename detail::stage_result<std::invoke_result_t<F&>>::type;
+
+	auto r   = std::make_unique<detail::pipeline_runner<void, T, F, Cap>>(std::move(fn));
+	auto out = r->output();
+
+	std::vector<std::unique_ptr<detail::pipeline_stage>> stages;
+	stages.push_back(std::move(r));
+	return pipeline_builder<T>(std::move(out), std::move(stages));
+}
+
+/**
+ * @brief Stage that transforms the values on \p num_workers threads.
+ *
+ * If \p fn returns `std::optional`, empty results are dropped.
+ * The workers take the available values in batches and send the results in batches,
+ * so the results of a worker are in order but the results of different workers interleave.
+ *
+ * @tparam Cap Capacity of the channel to the next stage.
+ * @param fn Transforms a value.
+ * @param num_workers Number of the worker threads; 0 is taken as 1.
+ */
+template<std::size_t Cap = detail::PipelineBatchSize, typename F>
+detail::stage_spec<F, Cap> stage(F fn, std::size_t num_workers = 1) {
+	return detail::stage_spec<F, Cap>{std::move(fn), std::max<std::size_t>(1, num_workers)};
+}
+
+/**
+ * @brief Same as \ref stage but the results are sent in the order of the values.
+ *
+ * The results that are done ahead of the head-of-line are held in the reorder window.
+ * Once the window is full, the workers stop taking values until the head-of-line is done,
+ * so a slow value holds back the stage instead of growing the window.
+ *
+ * @tparam Cap Capacity of the channel to the next stage.
+ * @param fn Transforms a value.
+ * @param num_workers Number of the worker threads; 0 is taken as 1.
+ * @param window Maximum number of the values in flight; it must not be 0.
+ */
+template<std::size_t Cap = detail::PipelineBatchSize, typename F>
+detail::stage_spec<F, Cap> ordered_stage(F fn, std::size_t num_workers, std::size_t window = 4 * detail::PipelineBatchSize) {
+	return detail::stage_spec<F, Cap>{std::move(fn), std::max<std::size_t>(1, num_workers), std::max<std::size_t>(1, window)};
+}
+
+/**
+ * @brief Last stage that consumes the values on \p num_workers threads.
+ *
+ * @param num_workers Number of the worker threads; 0 is taken as 1.
+ */
+template<typename F>
+detail::sink_spec<F> sink(F fn, std::size_t num_workers = 1) {
+	return detail::sink_spec<F>{std::move(fn), std::max<std::size_t>(1, num_workers)};
+}
+
+}  // namespace channel
+}  // namespace lesomnus
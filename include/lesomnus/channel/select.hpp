@@ -1,205 +1,755 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
 #include <functional>
-#include <memory>
 #include <mutex>
+#include <optional>
+#include <span>
 #include <stop_token>
-#include <string>
 #include <system_error>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/detail/awaiter.hpp"
+#include "lesomnus/channel/detail/parker.hpp"
+#include "lesomnus/channel/detail/random.hpp"
+#include "lesomnus/channel/executor.hpp"
+#include "lesomnus/channel/ticker.hpp"
+#include "lesomnus/channel/timer.hpp"
 
 namespace lesomnus {
 namespace channel {
 
 namespace detail {
 
-class op {
+/**
+ * @brief State of a pending select shared by its operations.
+ *
+ * It lives on the stack of the selecting thread or in the frame of the awaiting coroutine.
+ */
+class select_context {
    public:
-	virtual bool try_execute() = 0;
+	select_context() = default;
+
+	/**
+	 * @param r Resumer of the coroutine awaiting the select instead of blocking a thread.
+	 */
+	explicit select_context(resumer& r) noexcept
+	    : resumer_(&r) { }
+
+	/**
+	 * @brief Takes the right to complete the select on behalf of \p by.
+	 *
+	 * @return False if it is already taken.
+	 */
+	bool claim(void const* by) noexcept {
+		void const* expected = nullptr;
+		return winner_.compare_exchange_strong(expected, by, std::memory_order_acq_rel, std::memory_order_acquire);
+	}
+
+	[[nodiscard]] void const* winner() const noexcept {
+		return winner_.load(std::memory_order_acquire);
+	}
 
-	virtual void schedule(std::function<bool()> need_abort) = 0;
+	/**
+	 * @brief Wakes up the select.
+	 */
+	void settle() {
+		if(resumer_ != nullptr) {
+			resumer_->resume();
+			return;
+		}
+
+		is_settled_.release();
+	}
+
+	void wait() {
+		is_settled_.acquire();
+	}
+
+	/**
+	 * @brief Makes it possible to be claimed again.
+	 *
+	 * None of the operations may be hanged on the channels.
+	 */
+	void reset() noexcept {
+		winner_.store(nullptr, std::memory_order_relaxed);
+		is_settled_.try_acquire();
+	}
+
+   private:
+	std::atomic<void const*> winner_ = nullptr;
+	park_semaphore           is_settled_;
+
+	resumer* resumer_ = nullptr;
 };
 
-namespace {
+/**
+ * @brief Task that a select operation hangs on the channel.
+ *
+ * It is owned by the operation so nothing is allocated.
+ */
+template<typename T>
+class select_waiter final: public waiter<T> {
+   public:
+	explicit select_waiter(T* elem) noexcept
+	    : waiter<T>(elem) { }
+
+	void bind(select_context& ctx) noexcept {
+		ctx_ = &ctx;
+	}
+
+	[[nodiscard]] bool is_selected() const noexcept {
+		return ctx_ != nullptr && ctx_->winner() == this;
+	}
+
+   protected:
+	bool is_abandoned_() override {
+		auto const winner = ctx_->winner();
+		return winner != nullptr && winner != this;
+	}
 
-struct sched_context {
-	std::mutex mutex;
-	bool       is_done = false;
+	bool claim_() override {
+		return ctx_->claim(this);
+	}
+
+	void settle_(bool) override {
+		ctx_->settle();
+	}
+
+   private:
+	select_context* ctx_ = nullptr;
 };
 
-}  // namespace
+/**
+ * @brief Base of the select operations.
+ *
+ * It has no virtual functions; \ref select invokes the following functions
+ * of the concrete operations directly:
+ * - `chan_base* chan()`: Channel to lock, or \a nullptr if it does not need one.
+ * - `bool try_execute()`: Completes the operation if it is ready. The peer is settled later by \a finish.
+ * - `void enqueue(select_context&)`: Hangs the operation.
+ * - `void dequeue()`: Unhangs the operation. Once it returns, nobody settles the operation.
+ * - `void finish()`: Settles the peer and invokes the callback if the operation is completed.
+ *
+ * All but \a finish are invoked with the channels locked.
+ * An operation that waits for something other than a channel may also have the following,
+ * which are invoked with the channels unlocked so that it never locks them in the other order:
+ * - `void arm()`: Starts waiting once all the operations are hanged.
+ * - `void disarm()`: Stops waiting once the operations are unhanged.
+ */
+class op { };
+
+template<typename Op>
+void arm_(Op& op) {
+	if constexpr(requires { op.arm(); }) {
+		op.arm();
+	}
+}
+
+template<typename Op>
+void disarm_(Op& op) {
+	if constexpr(requires { op.disarm(); }) {
+		op.disarm();
+	}
+}
+
+struct ignore {
+	template<typename... Args>
+	void operator()(Args&&...) const noexcept { }
+};
 
 }  // namespace detail
 
-template<typename T>
+template<typename T, typename F = detail::ignore>
 class recv: public detail::op {
    public:
 	/**
 	 * @brief Extracts the first element from the buffer. 
 	 * 
-	 * Callback function is called if the value is received or the channel is closed.
+	 * Callback function is called on the selecting thread if the value is received or the channel is closed.
 	 * The first argument of the callback function is \a true if the value is received,
 	 * or \a false if the channel is closed.
 	 * 
 	 * @param chan 
-	 * @param on_settle 
+	 * @param on_settle `void(bool, T&&)`.
 	 */
-	template<typename F = std::function<void(bool, T&&)>>
-	recv(
-	    receiver<T>& chan, F&& on_settle = [](bool, T&&) {})
+	recv(receiver<T>& chan, F on_settle = F{})
 	    : chan_(chan)
-	    , on_settle_(std::forward<F>(on_settle)) { }
+	    , on_settle_(std::move(on_settle)) { }
 
-	bool try_execute() override {
-		T value;
+	recv(recv&& other)
+	    : chan_(other.chan_)
+	    , on_settle_(std::move(other.on_settle_)) { }
 
+	[[nodiscard]] detail::chan_base* chan() const noexcept {
+		return &chan_;
+	}
+
+	bool try_execute() {
 		std::error_code ec;
-		chan_.try_recv(value, ec);
+		chan_.try_recv_locked(value_, ec, batch_);
 
 		if(ec == channel_errc::exhausted) {
 			return false;
 		}
 
-		on_settle_(ec == channel_errc::ok, std::move(value));
-
+		is_done_ = true;
+		ok_      = ec == channel_errc::ok;
 		return true;
 	}
 
-	void schedule(std::function<bool()> need_abort) override {
-		chan_.recv_sched(std::move(need_abort), std::move(on_settle_));
+	void enqueue(detail::select_context& ctx) {
+		waiter_.bind(ctx);
+		chan_.recv_enqueue_locked(waiter_);
+	}
+
+	void dequeue() {
+		chan_.recv_dequeue_locked(waiter_);
+		if(waiter_.is_selected()) {
+			is_done_ = true;
+			ok_      = waiter_.ok();
+		}
+	}
+
+	void finish() {
+		batch_.settle();
+		if(is_done_) {
+			on_settle_(ok_, std::move(value_));
+		}
 	}
 
    private:
 	receiver<T>& chan_;
 
-	std::function<void(bool, T&&)> on_settle_;
+	F on_settle_;
+
+	T                        value_{};
+	detail::select_waiter<T> waiter_{&value_};
+	detail::settle_batch<T>  batch_;
+
+	bool is_done_ = false;
+	bool ok_      = false;
 };
 
-template<typename T, typename I>
+template<typename T, typename F = detail::ignore>
 class send: public detail::op {
    public:
 	/**
 	 * @brief Appends the first element from the buffer. 
 	 * 
-	 * Callback function is called if the value is sent or the channel is closed.
+	 * Callback function is called on the selecting thread if the value is sent or the channel is closed.
 	 * The first argument of the callback function is \a true if the value is sent,
 	 * or \a false if the channel is closed.
 	 * 
 	 * @param chan 
-	 * @param on_settle 
+	 * @param value 
+	 * @param on_settle `void(bool)`.
 	 */
-	send(
-	    sender<T>& chan, I&& value, std::function<void(bool)> on_settle = [](bool) {})
+	template<typename U>
+	requires std::constructible_from<T, U&&>
+	send(sender<T>& chan, U&& value, F on_settle = F{})
 	    : chan_(chan)
-	    , value_(std::forward<I>(value))
-	    , on_settle_(std::move(on_settle)) { }
+	    , on_settle_(std::move(on_settle))
+	    , value_(std::forward<U>(value)) { }
+
+	send(send&& other)
+	    : chan_(other.chan_)
+	    , on_settle_(std::move(other.on_settle_))
+	    , value_(std::move(other.value_)) { }
 
-	bool try_execute() override {
+	[[nodiscard]] detail::chan_base* chan() const noexcept {
+		return &chan_;
+	}
+
+	bool try_execute() {
 		std::error_code ec;
-		chan_.try_send(std::forward<I>(value_), ec);
+		chan_.try_send_locked(std::move(value_), ec, batch_);
 
 		if(ec == channel_errc::exhausted) {
 			return false;
 		}
 
-		on_settle_(ec == channel_errc::ok);
-
+		is_done_ = true;
+		ok_      = ec == channel_errc::ok;
 		return true;
 	}
 
-	void schedule(std::function<bool()> need_abort) override {
-		chan_.send_sched(std::forward<I>(value_), std::move(need_abort), std::move(on_settle_));
+	void enqueue(detail::select_context& ctx) {
+		waiter_.bind(ctx);
+		chan_.send_enqueue_locked(waiter_);
+	}
+
+	void dequeue() {
+		chan_.send_dequeue_locked(waiter_);
+		if(waiter_.is_selected()) {
+			is_done_ = true;
+			ok_      = waiter_.ok();
+		}
+	}
+
+	void finish() {
+		batch_.settle();
+		if(is_done_) {
+			on_settle_(ok_);
+		}
 	}
 
    private:
 	sender<T>& chan_;
-	I          value_;
 
-	std::function<void(bool)> on_settle_;
+	F on_settle_;
+
+	T                        value_;
+	detail::select_waiter<T> waiter_{&value_};
+	detail::settle_batch<T>  batch_;
+
+	bool is_done_ = false;
+	bool ok_      = false;
 };
 
-template<class T>
-send(sender<T>& chan, char const* value, std::function<void(bool)> const& on_settle) -> send<T, std::string>;
+template<typename F = detail::ignore>
+class after: public detail::op {
+   public:
+	using clock = timer_service::clock;
+
+	/**
+	 * @brief Expires when the given time is elapsed.
+	 * 
+	 * Callback function is called on the selecting thread if the timeout is selected.
+	 * It is backed by \p service so no thread is spawned for the timeout.
+	 * 
+	 * @param timeout 
+	 * @param on_expired `void()`.
+	 * @param service 
+	 */
+	template<typename Rep, typename Period>
+	after(std::chrono::duration<Rep, Period> timeout, F on_expired = F{}, timer_service& service = timer_service::global())
+	    : after(detail::to_deadline(timeout), std::move(on_expired), service) { }
+
+	/**
+	 * @brief Expires when the given deadline is exceeded.
+	 * 
+	 * Callback function is called on the selecting thread if the timeout is selected.
+	 * It is backed by \p service so no thread is spawned for the timeout.
+	 * 
+	 * @param deadline 
+	 * @param on_expired `void()`.
+	 * @param service 
+	 */
+	after(clock::time_point deadline, F on_expired = F{}, timer_service& service = timer_service::global())
+	    : deadline_(deadline)
+	    , on_expired_(std::move(on_expired))
+	    , service_(service)
+	    , timer_(expirer{this}) { }
+
+	after(after&& other)
+	    : deadline_(other.deadline_)
+	    , on_expired_(std::move(other.on_expired_))
+	    , service_(other.service_)
+	    , timer_(expirer{this}) { }
+
+	[[nodiscard]] detail::chan_base* chan() const noexcept {
+		return nullptr;
+	}
+
+	bool try_execute() {
+		is_done_ = deadline_ <= clock::now();
+		return is_done_;
+	}
+
+	void enqueue(detail::select_context& ctx) {
+		ctx_ = &ctx;
+	}
+
+	void dequeue() {
+		is_done_ = ctx_->winner() == this;
+	}
+
+	void arm() {
+		// The timer service fires the tickers that lock the channels, so it is not armed while they are locked.
+		if(ctx_->winner() == nullptr) {
+			service_.arm(timer_, deadline_);
+		}
+	}
+
+	void disarm() {
+		timer_.cancel();
+	}
+
+	void finish() {
+		if(is_done_) {
+			on_expired_();
+		}
+	}
+
+   private:
+	struct expirer {
+		after* self;
+
+		void operator()() const {
+			auto* const ctx = self->ctx_;
+			if(ctx->claim(self)) {
+				ctx->settle();
+			}
+		}
+	};
+
+	clock::time_point deadline_;
+	F                 on_expired_;
+
+	timer_service&          service_;
+	detail::select_context* ctx_ = nullptr;
+
+	timer<expirer> timer_;
+
+	bool is_done_ = false;
+};
+
+template<typename F = detail::ignore>
+class tick: public detail::op {
+   public:
+	using clock = ticker::clock;
+
+	/**
+	 * @brief Receives the tick from the ticker.
+	 * 
+	 * Callback function is called on the selecting thread with the time of the tick
+	 * if the tick is selected.
+	 * Unlike \ref after, the ticker outlives the select so the ticks keep their pace
+	 * even if the other operations are selected.
+	 * 
+	 * @param t 
+	 * @param on_tick `void(clock::time_point)`.
+	 */
+	tick(ticker& t, F on_tick = F{})
+	    : chan_(t.chan())
+	    , on_tick_(std::move(on_tick)) { }
+
+	tick(tick&& other)
+	    : chan_(other.chan_)
+	    , on_tick_(std::move(other.on_tick_)) { }
+
+	[[nodiscard]] detail::chan_base* chan() const noexcept {
+		return &chan_;
+	}
+
+	bool try_execute() {
+		std::error_code ec;
+		chan_.try_recv_locked(time_, ec, batch_);
+
+		is_done_ = ec == channel_errc::ok;
+		return is_done_;
+	}
+
+	void enqueue(detail::select_context& ctx) {
+		waiter_.bind(ctx);
+		chan_.recv_enqueue_locked(waiter_);
+	}
+
+	void dequeue() {
+		chan_.recv_dequeue_locked(waiter_);
+		is_done_ = waiter_.is_selected() && waiter_.ok();
+	}
+
+	void finish() {
+		batch_.settle();
+		if(is_done_) {
+			on_tick_(time_);
+		}
+	}
+
+   private:
+	receiver<clock::time_point>& chan_;
+
+	F on_tick_;
+
+	clock::time_point                        time_;
+	detail::select_waiter<clock::time_point> waiter_{&time_};
+	detail::settle_batch<clock::time_point>  batch_;
+
+	bool is_done_ = false;
+};
+
+namespace detail {
 
 /**
- * @brief Waits for the given channel operations and cancels the other when one completes.
- * 
- * \ref fallback will be called if all operations are not ready or all the operations are canceled.
- * If \ref fallback is \a nullptr, it is blocked until one of channel operation is completes.
- * 
- * @tparam Ops Operations.
- * @param token Interrupt register.
- * @param ops Operations to wait.
- * @param fallback Fallback function.
+ * @brief Fills \p order with a uniformly random permutation of its indices, like Go's `pollorder`,
+ * so the first ready operation in it is uniformly distributed among the ready ones.
  */
-template<typename... Ops>
-requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
-void select(std::stop_token token, Ops... ops, std::function<void()> const& fallback) {
-	{
-		bool is_executed = false;
-		([&] {
-			if(is_executed) {
-				return;
+inline void shuffle_order_(std::span<std::size_t> order) noexcept {
+	for(std::size_t i = 0; i < order.size(); ++i) {
+		// Inside-out Fisher-Yates shuffle.
+		std::size_t const j = fast_range(i + 1);
+
+		order[i] = order[j];
+		order[j] = i;
+	}
+}
+
+/**
+ * @brief Returns the order in which \p N operations are polled.
+ *
+ * Unless it is biased, the order is shuffled by \ref shuffle_order_.
+ */
+template<bool IsBiased, std::size_t N>
+std::array<std::size_t, N> poll_order_() noexcept {
+	std::array<std::size_t, N> order{};
+	if constexpr(IsBiased || N == 1) {
+		for(std::size_t i = 0; i < N; ++i) {
+			order[i] = i;
+		}
+	} else {
+		shuffle_order_(order);
+	}
+
+	return order;
+}
+
+/**
+ * @brief Tries the operations in the given order until one of them completes.
+ */
+template<std::size_t... Is, typename... Ops>
+bool try_execute_in_(std::array<std::size_t, sizeof...(Ops)> const& order, std::index_sequence<Is...>, Ops&... ops) {
+	for(auto const i: order) {
+		if(((Is == i && ops.try_execute()) || ...)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Channels of the operations locked together in order of the address,
+ *        so the selects sharing the channels do not deadlock.
+ */
+template<std::size_t N>
+class chan_locks {
+   public:
+	explicit chan_locks(std::array<chan_base*, N> chans) noexcept
+	    : chans_(chans) {
+		std::sort(chans_.begin(), chans_.end(), std::less<>{});
+	}
+
+	void lock() {
+		chan_base* prev = nullptr;
+		for(auto* const chan: chans_) {
+			if(chan == nullptr || chan == prev) {
+				continue;
 			}
 
-			detail::op& op = ops;
-			is_executed    = op.try_execute();
-		}(),
-		 ...);
+			chan->lock();
+			prev = chan;
+		}
+	}
 
-		if(is_executed) {
-			return;
+	void unlock() {
+		chan_base* prev = nullptr;
+		for(auto it = chans_.rbegin(); it != chans_.rend(); ++it) {
+			if(*it == nullptr || *it == prev) {
+				continue;
+			}
+
+			(*it)->unlock();
+			prev = *it;
 		}
 	}
 
+   private:
+	std::array<chan_base*, N> chans_;
+};
+
+/**
+ * @brief Selects one of the operations like Go's `selectgo`.
+ *
+ * With all the channels locked, it completes a ready operation or hangs all of them,
+ * so an operation is never hanged while another one is ready.
+ *
+ * @tparam IsBiased If true, the operations are polled in the given order,
+ *         otherwise, in a random order so that each of the ready ones is chosen with the same probability.
+ */
+template<bool IsBiased, typename... Ops>
+void select_(std::stop_token const& token, std::function<void()> const& fallback, Ops&... ops) {
+	constexpr auto Indices = std::index_sequence_for<Ops...>{};
+
+	auto const order = poll_order_<IsBiased, sizeof...(Ops)>();
+
+	chan_locks<sizeof...(Ops)> locks({ops.chan()...});
+
+	locks.lock();
+	if(try_execute_in_(order, Indices, ops...)) {
+		locks.unlock();
+		(ops.finish(), ...);
+		return;
+	}
+
 	if(fallback) {
+		locks.unlock();
 		fallback();
 		return;
 	}
 
-	auto ctx = std::make_shared<detail::sched_context>();
-	ctx->mutex.lock();
+	if(token.stop_requested()) {
+		locks.unlock();
+		return;
+	}
 
-	std::mutex done;
-	done.lock();
+	select_context ctx;
+	(ops.enqueue(ctx), ...);
+	locks.unlock();
+	(arm_(ops), ...);
 
-	auto const cancel = [&ctx, &done] {
-		ctx->is_done = true;
-		done.unlock();
-	};
+	{
+		std::stop_callback on_cancel(token, [&ctx] {
+			if(ctx.claim(&ctx)) {
+				ctx.settle();
+			}
+		});
 
-	// TODO: merge with need_abort?
-	std::stop_callback on_cancel(token, [ctx, &cancel] {
-		std::scoped_lock l(ctx->mutex);
-		if(ctx->is_done) {
-			return;
-		}
+		ctx.wait();
+	}
 
-		cancel();
-	});
+	locks.lock();
+	(ops.dequeue(), ...);
+	locks.unlock();
+	(disarm_(ops), ...);
 
-	std::function<bool()> const need_abort = [ctx, &cancel]() {
-		std::scoped_lock l(ctx->mutex);
-		if(ctx->is_done) {
+	(ops.finish(), ...);
+}
+
+/**
+ * @brief Awaitable made by \ref async_select.
+ *
+ * It follows the same protocol as \ref select_ but suspends the coroutine instead of blocking.
+ * The operations are held in the coroutine frame so nothing is allocated.
+ */
+template<typename... Ops>
+class select_awaiter {
+   public:
+	template<typename... Args>
+	select_awaiter(std::stop_token token, executor& ex, Args&&... ops)
+	    : token_(std::move(token))
+	    , ops_(std::forward<Args>(ops)...)
+	    , locks_(std::apply([](auto&... ops) { return std::array<chan_base*, sizeof...(Ops)>{ops.chan()...}; }, ops_))
+	    , resumer_(ex)
+	    , ctx_(resumer_) { }
+
+	select_awaiter(select_awaiter const& other) = delete;
+	select_awaiter(select_awaiter&& other)      = delete;
+
+	select_awaiter& operator=(select_awaiter const& other) = delete;
+	select_awaiter& operator=(select_awaiter&& other)      = delete;
+
+	bool await_ready() {
+		auto const order = poll_order_<false, sizeof...(Ops)>();
+
+		// The channels stay locked until the operations are hanged by `await_suspend`.
+		locks_.lock();
+		is_done_ = std::apply([&order](auto&... ops) { return try_execute_in_(order, std::index_sequence_for<Ops...>{}, ops...); }, ops_);
+		if(is_done_ || token_.stop_requested()) {
+			locks_.unlock();
+			is_canceled_ = !is_done_;
+			is_done_     = true;
 			return true;
 		}
 
-		cancel();
-
 		return false;
+	}
+
+	bool await_suspend(std::coroutine_handle<> h) {
+		return suspend([](void* p) { std::coroutine_handle<>::from_address(p).resume(); }, h.address());
+	}
+
+	/**
+	 * @brief Hangs the operations and invokes \p on_settled with \p arg once one of them completes or it is canceled.
+	 *
+	 * @return False if it is settled in the meantime so \p on_settled is not invoked.
+	 */
+	bool suspend(void (*on_settled)(void*), void* arg) {
+		return resumer_.suspend(on_settled, arg, [this] {
+			std::apply([this](auto&... ops) { (ops.enqueue(ctx_), ...); }, ops_);
+			locks_.unlock();
+			std::apply([](auto&... ops) { (arm_(ops), ...); }, ops_);
+
+			if(token_.stop_possible()) {
+				on_cancel_.emplace(token_, canceler{&ctx_});
+			}
+		});
+	}
+
+	void await_resume() {
+		on_cancel_.reset();
+		if(!is_done_) {
+			locks_.lock();
+			std::apply([](auto&... ops) { (ops.dequeue(), ...); }, ops_);
+			locks_.unlock();
+			std::apply([](auto&... ops) { (disarm_(ops), ...); }, ops_);
+		}
+
+		std::apply([](auto&... ops) { (ops.finish(), ...); }, ops_);
+	}
+
+	/**
+	 * @return True if it is canceled by the token before any operation completes.
+	 */
+	[[nodiscard]] bool is_canceled() const noexcept {
+		return is_canceled_ || ctx_.winner() == &ctx_;
+	}
+
+   private:
+	struct canceler {
+		select_context* ctx;
+
+		void operator()() const {
+			if(ctx->claim(ctx)) {
+				ctx->settle();
+			}
+		}
 	};
 
-	([&] {
-		detail::op& op = ops;
+	std::stop_token    token_;
+	std::tuple<Ops...> ops_;
 
-		op.schedule(need_abort);
-	}(),
-	 ...);
+	chan_locks<sizeof...(Ops)> locks_;
 
-	ctx->mutex.unlock();
-	std::scoped_lock wait(done);
+	resumer        resumer_;
+	select_context ctx_;
+
+	std::optional<std::stop_callback<canceler>> on_cancel_;
+
+	bool is_done_     = false;
+	bool is_canceled_ = false;
+};
+
+}  // namespace detail
+
+/**
+ * @brief Waits for the given channel operations and cancels the other when one completes.
+ * 
+ * \ref fallback will be called if all operations are not ready or all the operations are canceled.
+ * If \ref fallback is \a nullptr, it is blocked until one of channel operation is completes.
+ * 
+ * The operations are dispatched statically and hanged on the channels without allocation.
+ * If several operations are ready, one of them is chosen uniformly at random like Go's `select`.
+ * 
+ * @tparam Ops Operations.
+ * @param token Interrupt register.
+ * @param ops Operations to wait.
+ * @param fallback Fallback function.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
+void select(std::stop_token token, Ops... ops, std::function<void()> const& fallback) {
+	detail::select_<false>(token, fallback, ops...);
 }
 
 /**
@@ -211,7 +761,7 @@ void select(std::stop_token token, Ops... ops, std::function<void()> const& fall
 template<typename... Ops>
 requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
 void select(Ops&&... ops) {
-	select<Ops...>(std::stop_token{}, std::forward<Ops>(ops)..., nullptr);
+	detail::select_<false>(std::stop_token{}, nullptr, ops...);
 }
 
 /**
@@ -224,7 +774,7 @@ void select(Ops&&... ops) {
 template<typename... Ops>
 requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
 void select(std::stop_token token, Ops&&... ops) {
-	select<Ops...>(token, std::forward<Ops>(ops)..., nullptr);
+	detail::select_<false>(token, nullptr, ops...);
 }
 
 /**
@@ -240,7 +790,105 @@ void select(std::stop_token token, Ops&&... ops) {
 template<typename... Ops>
 requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
 void select(Ops&&... ops, std::function<void()> const& fallback) {
-	select<Ops...>(std::stop_token{}, std::forward<Ops>(ops)..., fallback);
+	detail::select_<false>(std::stop_token{}, fallback, ops...);
+}
+
+/**
+ * @brief Same as \ref select but prefers the former operation if several operations are ready.
+ * 
+ * @tparam Ops Operations.
+ * @param token Interrupt register.
+ * @param ops Operations to wait.
+ * @param fallback Fallback function.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
+void biased_select(std::stop_token token, Ops... ops, std::function<void()> const& fallback) {
+	detail::select_<true>(token, fallback, ops...);
+}
+
+/**
+ * @brief Same as \ref select but prefers the former operation if several operations are ready.
+ * 
+ * @tparam Ops Operations.
+ * @param ops Operations to wait.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
+void biased_select(Ops&&... ops) {
+	detail::select_<true>(std::stop_token{}, nullptr, ops...);
+}
+
+/**
+ * @brief Same as \ref select but prefers the former operation if several operations are ready.
+ * 
+ * @tparam Ops Operations.
+ * @param token Interrupt register.
+ * @param ops Operations to wait.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
+void biased_select(std::stop_token token, Ops&&... ops) {
+	detail::select_<true>(token, nullptr, ops...);
+}
+
+/**
+ * @brief Same as \ref select but prefers the former operation if several operations are ready.
+ * 
+ * @tparam Ops Operations.
+ * @param ops Operations to wait.
+ * @param fallback Fallback function.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<detail::op, Ops>...>
+void biased_select(Ops&&... ops, std::function<void()> const& fallback) {
+	detail::select_<true>(std::stop_token{}, fallback, ops...);
+}
+
+/**
+ * @brief Returns the awaitable that waits for the given channel operations like \ref select.
+ * 
+ * The coroutine is suspended without blocking the thread and resumed on \p ex once one of the operations completes.
+ * The callback of the completed operation is invoked on the resumed coroutine.
+ * 
+ * @tparam Ops Operations.
+ * @param ex Executor where the coroutine is resumed.
+ * @param token Interrupt register.
+ * @param ops Operations to wait.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<detail::op, std::remove_cvref_t<Ops>>...>
+detail::select_awaiter<std::remove_cvref_t<Ops>...> async_select(executor& ex, std::stop_token token, Ops&&... ops) {
+	return detail::select_awaiter<std::remove_cvref_t<Ops>...>(std::move(token), ex, std::forward<Ops>(ops)...);
+}
+
+/**
+ * @brief Returns the awaitable that waits for the given channel operations like \ref select.
+ * 
+ * The coroutine is resumed on the executor running it.
+ * 
+ * @tparam Ops Operations.
+ * @param token Interrupt register.
+ * @param ops Operations to wait.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<detail::op, std::remove_cvref_t<Ops>>...>
+detail::select_awaiter<std::remove_cvref_t<Ops>...> async_select(std::stop_token token, Ops&&... ops) {
+	return detail::select_awaiter<std::remove_cvref_t<Ops>...>(std::move(token), executor::current(), std::forward<Ops>(ops)...);
+}
+
+/**
+ * @brief Returns the awaitable that waits for the given channel operations like \ref select.
+ * 
+ * The coroutine is resumed on the executor running it.
+ * 
+ * @tparam Ops Operations.
+ * @param ops Operations to wait.
+ */
+template<typename... Ops>
+requires std::conjunction_v<std::is_base_of<detail::op, std::remove_cvref_t<Ops>>...>
+detail::select_awaiter<std::remove_cvref_t<Ops>...> async_select(Ops&&... ops) {
+	return detail::select_awaiter<std::remove_cvref_t<Ops>...>(std::stop_token{}, executor::current(), std::forward<Ops>(ops)...);
 }
 
 }  // namespace channel
@@ -0,0 +1,636 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/channel.hpp"
+#include "lesomnus/channel/detail/cache_line.hpp"
+#include "lesomnus/channel/detail/parker.hpp"
+#include "lesomnus/channel/detail/waiter.hpp"
+#include "lesomnus/channel/detail/watcher.hpp"
+#include "lesomnus/channel/error.hpp"
+#include "lesomnus/channel/executor.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+namespace detail {
+
+/**
+ * @brief Index that is distinct for each thread, used to pick the shard of the thread.
+ */
+inline std::size_t this_thread_shard_hint() noexcept {
+	static std::atomic<std::size_t> next = 0;
+
+	thread_local std::size_t const hint = next.fetch_add(1, std::memory_order_relaxed);
+	return hint;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Unbounded channel whose buffer is split into shards to reduce the contention.
+ *
+ * A sender pushes to the shard of its thread, and a receiver pops from the shard of its thread first
+ * and then steals from the others, so the threads mostly lock different shards.
+ * The values sent by a thread are received in order when they are taken from the same shard,
+ * but there is no order across the shards.
+ *
+ * The channel lock is taken only if a receiver may be waiting, i.e. while there are hanging receivers
+ * or watchers, or while the channel is locked by someone.
+ * Closing it discards the buffered values as \ref bounded_channel does.
+ */
+template<typename T>
+class sharded_channel: public chan<T> {
+   public:
+	using chan<T>::try_recv;
+	using chan<T>::recv;
+	using chan<T>::recv_until;
+	using chan<T>::recv_sched;
+	using chan<T>::try_send;
+	using chan<T>::send;
+	using chan<T>::send_until;
+	using chan<T>::send_sched;
+
+	/**
+	 * @param num_shards Number of the shards.
+	 * @throws std::invalid_argument If \p num_shards is 0.
+	 */
+	explicit sharded_channel(std::size_t num_shards = std::max(1u, std::thread::hardware_concurrency()))
+	    : shards_(std::make_unique<shard[]>(num_shards))
+	    , num_shards_(num_shards) {
+		if(num_shards == 0) {
+			throw std::invalid_argument("sharded_channel needs at least one shard");
+		}
+	}
+
+	~sharded_channel() {
+		hanged_recv_tasks.clear();
+		hanged_send_tasks.clear();
+	}
+
+	[[nodiscard]] std::size_t num_shards() const noexcept {
+		return num_shards_;
+	}
+
+	std::intmax_t size() const override {
+		std::scoped_lock l(mutex_);
+
+		hanged_recv_tasks.prune();
+
+		auto n = -static_cast<std::intmax_t>(hanged_recv_tasks.size());
+		for(std::size_t i = 0; i < num_shards_; ++i) {
+			std::scoped_lock sl(shards_[i].mutex);
+			n += static_cast<std::intmax_t>(shards_[i].buffer.size());
+		}
+
+		return n;
+	}
+
+	constexpr std::size_t capacity() const noexcept override {
+		return unbounded_capacity;
+	}
+
+	void close() override {
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(mutex_);
+		is_closed_.store(true, std::memory_order_release);
+
+		recv_watchers_.notify_all();
+		send_watchers_.notify_all();
+
+		batch.close(hanged_recv_tasks);
+		batch.close(hanged_send_tasks);
+		update_interest_();
+
+		for(std::size_t i = 0; i < num_shards_; ++i) {
+			std::scoped_lock sl(shards_[i].mutex);
+			shards_[i].buffer.clear();
+		}
+	}
+
+	void try_recv(T& value, std::error_code& ec) override {
+		if(is_closed_.load(std::memory_order_acquire)) [[unlikely]] {
+			ec = channel_errc::closed;
+		} else if(try_pop_(value)) {
+			ec = channel_errc::ok;
+		} else {
+			ec = channel_errc::exhausted;
+		}
+	}
+
+	void try_recv_locked(T& value, std::error_code& ec, detail::settle_batch<T>& batch) override {
+		(void)batch;
+		try_recv(value, ec);
+	}
+
+	void recv(std::stop_token token, T& value, std::error_code& ec) override {
+		recv_(token, std::chrono::steady_clock::time_point::max(), value, ec);
+	}
+
+	void recv_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T& value, std::error_code& ec) override {
+		recv_(token, deadline, value, ec);
+	}
+
+	void recv_sched(
+	    std::function<bool()>          need_abort,
+	    std::function<void(bool, T&&)> on_settled,
+	    executor&                      ex) override {
+		std::unique_lock l(*this);
+
+		T value;
+
+		if(is_closed_.load(std::memory_order_relaxed)) [[unlikely]] {
+			if(!need_abort()) {
+				l.unlock();
+				on_settled(false, std::move(value));
+			}
+			return;
+		}
+
+		if(need_abort()) {
+			return;
+		}
+
+		// Settled by the caller itself, so it is run inline rather than posted.
+		if(try_pop_(value)) {
+			l.unlock();
+			on_settled(true, std::move(value));
+			return;
+		}
+
+		hang_recv_(*new detail::sched_waiter<T, std::function<void(bool, T&&)>>(
+		    std::move(need_abort),
+		    std::move(on_settled),
+		    ex));
+	}
+
+	bool recv_enqueue(detail::waiter<T>& task) override {
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(*this);
+
+		if(is_closed_.load(std::memory_order_relaxed)) [[unlikely]] {
+			settle_or_drop_(task, false, batch);
+			return true;
+		}
+
+		if(!try_pop_to_(task, batch)) {
+			hang_recv_(task);
+		}
+
+		return true;
+	}
+
+	void recv_dequeue(detail::waiter<T>& task) override {
+		std::scoped_lock l(mutex_);
+		recv_dequeue_locked(task);
+	}
+
+	void recv_enqueue_locked(detail::waiter<T>& task) override {
+		assert(not is_closed_.load(std::memory_order_relaxed));
+		hang_recv_(task);
+	}
+
+	void recv_dequeue_locked(detail::waiter<T>& task) override {
+		hanged_recv_tasks.erase(task);
+		update_interest_();
+	}
+
+	void try_send(T const& value, std::error_code& ec) override {
+		send_(value, ec);
+	}
+
+	void try_send(T&& value, std::error_code& ec) override {
+		send_(std::move(value), ec);
+	}
+
+	void send(std::stop_token token, T const& value, std::error_code& ec) override {
+		send_until(token, std::chrono::steady_clock::time_point::max(), value, ec);
+	}
+
+	void send(std::stop_token token, T&& value, std::error_code& ec) override {
+		send_until(token, std::chrono::steady_clock::time_point::max(), std::move(value), ec);
+	}
+
+	void send_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T const& value, std::error_code& ec) override {
+		(void)deadline;
+		if(token.stop_requested()) [[unlikely]] {
+			ec = channel_errc::canceled;
+			return;
+		}
+
+		// It never waits since the buffer is unbounded.
+		send_(value, ec);
+	}
+
+	void send_until(std::stop_token token, std::chrono::steady_clock::time_point deadline, T&& value, std::error_code& ec) override {
+		(void)deadline;
+		if(token.stop_requested()) [[unlikely]] {
+			ec = channel_errc::canceled;
+			return;
+		}
+
+		send_(std::move(value), ec);
+	}
+
+	void send_sched(
+	    T const&                  value,
+	    std::function<bool()>     need_abort,
+	    std::function<void(bool)> on_settled,
+	    executor&                 ex) override {
+		send_sched_(value, std::move(need_abort), std::move(on_settled), ex);
+	}
+
+	void send_sched(
+	    T&&                       value,
+	    std::function<bool()>     need_abort,
+	    std::function<void(bool)> on_settled,
+	    executor&                 ex) override {
+		send_sched_(std::move(value), std::move(need_abort), std::move(on_settled), ex);
+	}
+
+	bool send_enqueue(detail::waiter<T>& task) override {
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(*this);
+
+		if(is_closed_.load(std::memory_order_relaxed)) [[unlikely]] {
+			settle_or_drop_(task, false, batch);
+			return true;
+		}
+
+		if(!task.claim()) {
+			task.drop();
+			return true;
+		}
+
+		std::error_code ec;
+		try_send_locked(std::move(*task.elem()), ec, batch);
+		batch.push_back(task, true);
+		return true;
+	}
+
+	void send_dequeue(detail::waiter<T>& task) override {
+		std::scoped_lock l(mutex_);
+		send_dequeue_locked(task);
+	}
+
+	void try_send_locked(T&& value, std::error_code& ec, detail::settle_batch<T>& batch) override {
+		if(is_closed_.load(std::memory_order_relaxed)) [[unlikely]] {
+			ec = channel_errc::closed;
+			return;
+		}
+
+		if(auto* const task = hanged_recv_tasks.claim_front()) {
+			// Hand over directly to the receiver's destination.
+			*task->elem() = std::move(value);
+			batch.push_back(*task, true);
+			update_interest_();
+		} else {
+			push_(std::move(value));
+			recv_watchers_.notify_all();
+		}
+
+		ec = channel_errc::ok;
+	}
+
+	void send_enqueue_locked(detail::waiter<T>& task) override {
+		// Not reached by `select` since sending never blocks, but the task is kept until it is closed
+		// as \ref unbounded_channel does.
+		assert(not is_closed_.load(std::memory_order_relaxed));
+		hanged_send_tasks.push_back(task);
+	}
+
+	void send_dequeue_locked(detail::waiter<T>& task) override {
+		hanged_send_tasks.erase(task);
+	}
+
+	/**
+	 * @brief Locks the channel and makes the senders take the lock until it is unlocked.
+	 */
+	void lock() override {
+		interest_.fetch_add(1);
+		mutex_.lock();
+	}
+
+	void unlock() override {
+		mutex_.unlock();
+		interest_.fetch_sub(1);
+	}
+
+	bool watch_recv(detail::watcher& w) override {
+		std::scoped_lock l(*this);
+		if(!recv_watchers_.contains(w)) {
+			recv_watchers_.push_back(w);
+			update_interest_();
+		}
+
+		return is_closed_.load(std::memory_order_relaxed) || has_value_();
+	}
+
+	void unwatch_recv(detail::watcher& w) override {
+		std::scoped_lock l(mutex_);
+		recv_watchers_.erase(w);
+		update_interest_();
+	}
+
+	bool watch_send(detail::watcher& w) override {
+		std::scoped_lock l(mutex_);
+		if(!send_watchers_.contains(w)) {
+			send_watchers_.push_back(w);
+		}
+
+		return true;
+	}
+
+	void unwatch_send(detail::watcher& w) override {
+		std::scoped_lock l(mutex_);
+		send_watchers_.erase(w);
+	}
+
+   private:
+	struct alignas(detail::CacheLineSize) shard {
+		std::mutex    mutex;
+		std::deque<T> buffer;
+	};
+
+	static void settle_or_drop_(detail::waiter<T>& task, bool ok, detail::settle_batch<T>& batch) {
+		if(task.claim()) {
+			batch.push_back(task, ok);
+		} else {
+			task.drop();
+		}
+	}
+
+	/**
+	 * @brief Sends the value without the channel lock unless a receiver may be waiting.
+	 *
+	 * A receiver raises \ref interest_ before it looks into the shards, and a sender checks it
+	 * after it pushes to a shard. Since both go through the lock of the shard, either the receiver
+	 * finds the value or the sender sees the interest and hands the value over.
+	 */
+	template<typename U>
+	requires std::same_as<std::remove_cvref_t<U>, T>
+	void send_(U&& value, std::error_code& ec) {
+		if(interest_.load() != 0) {
+			detail::settle_batch<T> batch;
+			std::scoped_lock        l(*this);
+
+			T v = std::forward<U>(value);
+			try_send_locked(std::move(v), ec, batch);
+			return;
+		}
+
+		if(is_closed_.load(std::memory_order_acquire)) [[unlikely]] {
+			ec = channel_errc::closed;
+			return;
+		}
+
+		push_(std::forward<U>(value));
+		ec = channel_errc::ok;
+
+		if(interest_.load() != 0) {
+			wake_();
+		}
+	}
+
+	/**
+	 * @brief Hands the buffered values over to the hanging receivers and notifies the watchers.
+	 */
+	void wake_() {
+		detail::settle_batch<T> batch;
+		std::scoped_lock        l(mutex_);
+		if(is_closed_.load(std::memory_order_relaxed)) {
+			return;
+		}
+
+		auto const hint = detail::this_thread_shard_hint();
+		for(std::size_t i = 0; i < num_shards_ && !hanged_recv_tasks.empty(); ++i) {
+			auto&            s = shards_[(hint + i) % num_shards_];
+			std::scoped_lock sl(s.mutex);
+			while(!s.buffer.empty()) {
+				auto* const task = hanged_recv_tasks.claim_front();
+				if(task == nullptr) {
+					break;
+				}
+
+				*task->elem() = std::move(s.buffer.front());
+				s.buffer.pop_front();
+				batch.push_back(*task, true);
+			}
+		}
+
+		update_interest_();
+		recv_watchers_.notify_all();
+	}
+
+	void recv_(std::stop_token token, std::chrono::steady_clock::time_point deadline, T& value, std::error_code& ec) {
+		if(token.stop_requested()) [[unlikely]] {
+			ec = channel_errc::canceled;
+			return;
+		}
+
+		try_recv(value, ec);
+		if(ec != channel_errc::exhausted) {
+			return;
+		}
+
+		std::unique_lock l(*this);
+
+		// Looks again since a sender may have missed the interest raised by the lock.
+		try_recv(value, ec);
+		if(ec != channel_errc::exhausted) {
+			return;
+		}
+
+		// The sender moves its value directly into `value`.
+		detail::parker    parker;
+		detail::waiter<T> task(&value, &parker);
+		hang_recv_(task);
+
+		l.unlock();
+		ec = wait_(token, deadline, parker, task);
+	}
+
+	std::error_code wait_(
+	    std::stop_token                       token,
+	    std::chrono::steady_clock::time_point deadline,
+	    detail::parker&                       parker,
+	    detail::waiter<T>&                    task) {
+		{
+			std::stop_callback on_cancel(token, [&parker] {
+				if(parker.cancel()) {
+					parker.unpark();
+				}
+			});
+
+			parker.park_until(deadline);
+		}
+
+		if(parker.is_claimed_by(&task)) [[likely]] {
+			return task.ok() ? channel_errc::ok : channel_errc::closed;
+		}
+
+		// Nobody can claim the task anymore, but it may still be queued.
+		std::scoped_lock l(mutex_);
+		hanged_recv_tasks.erase(task);
+		update_interest_();
+
+		if(parker.is_timed_out()) {
+			return channel_errc::timeout;
+		}
+
+		return channel_errc::canceled;
+	}
+
+	template<typename U>
+	requires std::same_as<std::remove_cvref_t<U>, T>
+	void send_sched_(
+	    U&&                       value,
+	    std::function<bool()>     need_abort,
+	    std::function<void(bool)> on_settled,
+	    executor&                 ex) {
+		(void)ex;
+
+		std::error_code ec;
+		{
+			detail::settle_batch<T> batch;
+			std::unique_lock        l(*this);
+			if(need_abort()) {
+				return;
+			}
+
+			T v = std::forward<U>(value);
+			try_send_locked(std::move(v), ec, batch);
+		}
+
+		// Settled by the caller itself, so it is run inline rather than posted.
+		on_settled(ec == channel_errc::ok);
+	}
+
+	void push_(T&& value) {
+		auto&            s = shards_[detail::this_thread_shard_hint() % num_shards_];
+		std::scoped_lock l(s.mutex);
+		s.buffer.push_back(std::move(value));
+	}
+
+	void push_(T const& value) {
+		auto&            s = shards_[detail::this_thread_shard_hint() % num_shards_];
+		std::scoped_lock l(s.mutex);
+		s.buffer.push_back(value);
+	}
+
+	/**
+	 * @brief Pops from the shard of this thread, or steals from the others.
+	 */
+	bool try_pop_(T& value) {
+		auto const hint = detail::this_thread_shard_hint();
+		for(std::size_t i = 0; i < num_shards_; ++i) {
+			auto&            s = shards_[(hint + i) % num_shards_];
+			std::scoped_lock l(s.mutex);
+			if(!s.buffer.empty()) {
+				value = std::move(s.buffer.front());
+				s.buffer.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Same as \ref try_pop_ but the task is claimed only if a value is found.
+	 */
+	bool try_pop_to_(detail::waiter<T>& task, detail::settle_batch<T>& batch) {
+		auto const hint = detail::this_thread_shard_hint();
+		for(std::size_t i = 0; i < num_shards_; ++i) {
+			auto&            s = shards_[(hint + i) % num_shards_];
+			std::scoped_lock l(s.mutex);
+			if(s.buffer.empty()) {
+				continue;
+			}
+
+			if(!task.claim()) {
+				task.drop();
+				return true;
+			}
+
+			*task.elem() = std::move(s.buffer.front());
+			s.buffer.pop_front();
+			batch.push_back(task, true);
+			return true;
+		}
+
+		return false;
+	}
+
+	bool has_value_() const {
+		for(std::size_t i = 0; i < num_shards_; ++i) {
+			std::scoped_lock l(shards_[i].mutex);
+			if(!shards_[i].buffer.empty()) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void hang_recv_(detail::waiter<T>& task) {
+		hanged_recv_tasks.push_back(task);
+		update_interest_();
+	}
+
+	/**
+	 * @brief Keeps \ref interest_ raised while there are hanging receivers or watchers.
+	 *
+	 * It must be called with the lock held.
+	 */
+	void update_interest_() {
+		bool const is_interested = !hanged_recv_tasks.empty() || !recv_watchers_.empty();
+		if(is_interested == is_interested_) {
+			return;
+		}
+
+		is_interested_ = is_interested;
+		if(is_interested) {
+			interest_.fetch_add(1);
+		} else {
+			interest_.fetch_sub(1);
+		}
+	}
+
+	std::unique_ptr<shard[]> shards_;
+	std::size_t              num_shards_;
+
+	mutable std::mutex mutex_;
+
+	std::atomic<bool> is_closed_ = false;
+
+	// Number of the lock holders, plus 1 while there are hanging receivers or watchers.
+	std::atomic<std::size_t> interest_      = 0;
+	bool                     is_interested_ = false;
+
+	mutable detail::waiter_queue<T> hanged_recv_tasks;
+	mutable detail::waiter_queue<T> hanged_send_tasks;
+
+	detail::watcher_list recv_watchers_;
+	detail::watcher_list send_watchers_;
+};
+
+}  // namespace channel
+}  // namespace lesomnus
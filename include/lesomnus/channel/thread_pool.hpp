@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lesomnus/channel/detail/random.hpp"
+#include "lesomnus/channel/detail/work_deque.hpp"
+#include "lesomnus/channel/executor.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Work-stealing thread pool.
+ *
+ * Each worker has its own deque; works posted by a worker, such as the coroutines
+ * resumed by a channel operation on the worker, are pushed to its deque and run next
+ * while their data is still in the cache.
+ * Works posted by the other threads go to the shared queue.
+ * Idle workers steal from the others before they sleep.
+ */
+class thread_pool final: public executor {
+   public:
+	using executor::post;
+
+	/**
+	 * @param num_workers Number of the worker threads.
+	 */
+	explicit thread_pool(std::size_t num_workers = std::max(1u, std::thread::hardware_concurrency()))
+	    : workers_(num_workers) {
+		for(auto& w: workers_) {
+			w.pool = this;
+		}
+		for(auto& w: workers_) {
+			w.thread = std::thread([this, &w] { run_(w); });
+		}
+	}
+
+	thread_pool(thread_pool const& other) = delete;
+	thread_pool(thread_pool&& other)      = delete;
+
+	thread_pool& operator=(thread_pool const& other) = delete;
+	thread_pool& operator=(thread_pool&& other)      = delete;
+
+	/**
+	 * @brief Runs the works left and joins the workers.
+	 */
+	~thread_pool() {
+		is_stopping_.store(true, std::memory_order_relaxed);
+		epoch_.fetch_add(1, std::memory_order_seq_cst);
+		epoch_.notify_all();
+
+		for(auto& w: workers_) {
+			w.thread.join();
+		}
+	}
+
+	/**
+	 * @brief Pool shared by \ref go.
+	 */
+	static thread_pool& global() {
+		static thread_pool pool;
+		return pool;
+	}
+
+	[[nodiscard]] std::size_t size() const noexcept {
+		return workers_.size();
+	}
+
+	void post(detail::work& w) override {
+		if(current_ != nullptr && current_->pool == this) {
+			current_->works.push(w);
+		} else {
+			std::scoped_lock l(mutex_);
+			injected_.push_back(w);
+			num_injected_.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		signal_();
+	}
+
+   private:
+	struct worker {
+		thread_pool*       pool = nullptr;
+		detail::work_deque works;
+		std::thread        thread;
+	};
+
+	void signal_() {
+		epoch_.fetch_add(1, std::memory_order_seq_cst);
+		if(num_sleeping_.load(std::memory_order_seq_cst) > 0) {
+			epoch_.notify_one();
+		}
+	}
+
+	detail::work* pop_injected_() {
+		if(num_injected_.load(std::memory_order_relaxed) == 0) {
+			return nullptr;
+		}
+
+		std::scoped_lock l(mutex_);
+		auto* const w = injected_.pop_front();
+		if(w != nullptr) {
+			num_injected_.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		return w;
+	}
+
+	detail::work* steal_(worker const& self) {
+		auto const n     = workers_.size();
+		auto const first = detail::fast_range(n);
+		for(std::size_t k = 0; k < n; ++k) {
+			auto& victim = workers_[(first + k) % n];
+			if(&victim == &self) {
+				continue;
+			}
+
+			if(auto* const w = victim.works.steal()) {
+				return w;
+			}
+		}
+
+		return nullptr;
+	}
+
+	detail::work* find_(worker& self) {
+		if(auto* const w = self.works.pop()) {
+			return w;
+		}
+		if(auto* const w = pop_injected_()) {
+			return w;
+		}
+
+		return steal_(self);
+	}
+
+	void run_(worker& self) {
+		current_ = &self;
+		detail::executor_scope scope(*this);
+
+		while(true) {
+			auto const epoch = epoch_.load(std::memory_order_seq_cst);
+			if(auto* const w = find_(self)) {
+				w->run();
+				continue;
+			}
+
+			if(is_stopping_.load(std::memory_order_relaxed)) {
+				break;
+			}
+
+			// Nothing is found since the epoch, so any later post changes the epoch.
+			num_sleeping_.fetch_add(1, std::memory_order_seq_cst);
+			epoch_.wait(epoch, std::memory_order_seq_cst);
+			num_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		current_ = nullptr;
+	}
+
+	static inline thread_local worker* current_ = nullptr;
+
+	std::vector<worker> workers_;
+
+	std::mutex               mutex_;
+	detail::work_queue       injected_;
+	std::atomic<std::size_t> num_injected_ = 0;
+
+	std::atomic<std::uint64_t> epoch_        = 0;
+	std::atomic<std::size_t>   num_sleeping_ = 0;
+	std::atomic<bool>          is_stopping_  = false;
+};
+
+/**
+ * @brief Return type of the coroutines spawned by \ref go.
+ *
+ * It does not start until it is spawned and nobody awaits it.
+ */
+class routine {
+   public:
+	class promise_type final: public detail::work {
+	   public:
+		routine get_return_object() noexcept {
+			return routine(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		std::suspend_always initial_suspend() noexcept {
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+
+		void return_void() noexcept { }
+
+		void unhandled_exception() noexcept {
+			std::terminate();
+		}
+
+		void run() override {
+			std::coroutine_handle<promise_type>::from_promise(*this).resume();
+		}
+
+		~promise_type() {
+			if(owner_ != nullptr) {
+				release_(owner_);
+			}
+		}
+
+	   private:
+		friend class routine;
+
+		// Callable that made the coroutine; its captures live as long as the coroutine.
+		void* owner_ = nullptr;
+		void (*release_)(void*) = nullptr;
+	};
+
+	routine(routine const& other) = delete;
+
+	routine(routine&& other) noexcept
+	    : h_(std::exchange(other.h_, nullptr)) { }
+
+	routine& operator=(routine const& other) = delete;
+	routine& operator=(routine&& other)      = delete;
+
+	~routine() {
+		if(h_) {
+			h_.destroy();
+		}
+	}
+
+	/**
+	 * @brief Makes \p owner live as long as the coroutine.
+	 */
+	template<typename F>
+	void keep_alive(std::unique_ptr<F> owner) noexcept {
+		auto& p    = h_.promise();
+		p.owner_   = owner.release();
+		p.release_ = [](void* o) { delete static_cast<F*>(o); };
+	}
+
+	/**
+	 * @brief Starts the coroutine on \p ex.
+	 *
+	 * The coroutine is detached.
+	 */
+	void start(executor& ex) && {
+		ex.post(std::exchange(h_, nullptr).promise());
+	}
+
+   private:
+	explicit routine(std::coroutine_handle<promise_type> h) noexcept
+	    : h_(h) { }
+
+	std::coroutine_handle<promise_type> h_;
+};
+
+/**
+ * @brief Runs the function on the executor like Go's `go` statement.
+ *
+ * If \p f is a coroutine returning \ref routine, \p f is kept alive until the coroutine finishes
+ * so that the coroutine can access its captures.
+ *
+ * @param ex Executor where the function runs.
+ * @param f Function to run.
+ */
+template<typename F>
+requires std::is_invocable_v<std::decay_t<F>&>
+void go(executor& ex, F&& f) {
+	using Fn = std::decay_t<F>;
+	if constexpr(std::is_same_v<std::invoke_result_t<Fn&>, routine>) {
+		auto owner = std::make_unique<Fn>(std::forward<F>(f));
+
+		routine r = (*owner)();
+		r.keep_alive(std::move(owner));
+		std::move(r).start(ex);
+	} else {
+		ex.post(std::forward<F>(f));
+	}
+}
+
+/**
+ * @brief Runs the function like Go's `go` statement.
+ *
+ * It runs on the executor running the current thread so the spawned function stays close to the spawner,
+ * or on \ref thread_pool::global if there is no such executor.
+ *
+ * @param f Function to run.
+ */
+template<typename F>
+requires std::is_invocable_v<std::decay_t<F>&>
+void go(F&& f) {
+	if(detail::current_executor != nullptr) {
+		go(*detail::current_executor, std::forward<F>(f));
+	} else {
+		go(thread_pool::global(), std::forward<F>(f));
+	}
+}
+
+}  // namespace channel
+}  // namespace lesomnus
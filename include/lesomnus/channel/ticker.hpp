@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <stdexcept>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/channel.hpp"
+#include "lesomnus/channel/timer.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Delivers the time to its channel at intervals.
+ *
+ * Like Go's `time.Ticker`, the channel holds at most one tick,
+ * so ticks are dropped for slow receivers.
+ * The ticks are sent on the thread that drives the \ref timer_service.
+ */
+class ticker {
+   public:
+	using clock = timer_service::clock;
+
+	/**
+	 * @param interval Interval of the ticks; an interval past the range of the clock never ticks.
+	 * @throws std::invalid_argument If \p interval is not positive.
+	 */
+	template<typename Rep, typename Period>
+	explicit ticker(std::chrono::duration<Rep, Period> interval, timer_service& service = timer_service::global())
+	    : service_(service)
+	    , timer_(expirer{this}) {
+		reset(interval);
+	}
+
+	/**
+	 * @brief Stops the ticker.
+	 *
+	 * The channel is not closed so the pending receivers keep waiting.
+	 */
+	void stop() {
+		timer_.cancel();
+	}
+
+	/**
+	 * @brief Stops the ticker and restarts it with the given interval.
+	 *
+	 * @throws std::invalid_argument If \p interval is not positive.
+	 */
+	template<typename Rep, typename Period>
+	void reset(std::chrono::duration<Rep, Period> interval) {
+		if(interval <= interval.zero()) {
+			throw std::invalid_argument("ticker needs a positive interval");
+		}
+
+		auto const now      = clock::now();
+		auto const deadline = detail::saturating_add(now, interval);
+
+		// Saturated at the end of the clock, it never ticks, so it is not repeated past the end.
+		auto const period = deadline == clock::time_point::max() ? clock::duration::zero() : deadline - now;
+		service_.arm(timer_, deadline, period);
+	}
+
+	/**
+	 * @brief Returns the channel on which the ticks are delivered.
+	 */
+	[[nodiscard]] receiver<clock::time_point>& chan() noexcept {
+		return chan_;
+	}
+
+   private:
+	struct expirer {
+		ticker* self;
+
+		void operator()() const {
+			self->chan_.try_send(clock::now());
+		}
+	};
+
+	timer_service& service_;
+
+	bounded_channel<clock::time_point, 1> chan_;
+
+	timer<expirer> timer_;
+};
+
+}  // namespace channel
+}  // namespace lesomnus
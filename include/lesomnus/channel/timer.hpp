@@ -0,0 +1,474 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+namespace lesomnus {
+namespace channel {
+
+class timer_service;
+
+namespace detail {
+
+/**
+ * @brief Intrusive entry of the \ref timer_service.
+ */
+class timer_node {
+   public:
+	timer_node(timer_node const& other) = delete;
+	timer_node(timer_node&& other)      = delete;
+
+	timer_node& operator=(timer_node const& other) = delete;
+	timer_node& operator=(timer_node&& other)      = delete;
+
+   protected:
+	explicit timer_node(void (*expire)(timer_node&)) noexcept
+	    : expire_(expire) { }
+
+	~timer_node() = default;
+
+	timer_service* service_ = nullptr;
+
+   private:
+	friend class lesomnus::channel::timer_service;
+
+	timer_node* prev_   = nullptr;
+	timer_node* next_   = nullptr;
+	bool        linked_ = false;
+
+	std::uint8_t level_ = 0;
+	std::uint8_t slot_  = 0;
+
+	std::uint64_t expiry_ = 0;
+	std::uint64_t period_ = 0;
+
+	void (*expire_)(timer_node&);
+};
+
+}  // namespace detail
+
+/**
+ * @brief Hierarchical timing wheel shared by the timed operations.
+ *
+ * Arming and canceling a timer is O(1) regardless of the number of armed timers.
+ * The wheel is driven either by the caller through \ref advance,
+ * or by a thread running \ref run.
+ *
+ * Expired timers are fired one by one with the service unlocked,
+ * so the callbacks may arm and cancel the timers, including their own, or settle the operations
+ * that do so, but must not advance the service.
+ * They should be short since the other timers wait for them.
+ */
+class timer_service {
+   public:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr std::size_t NumLevels = 6;
+	static constexpr std::size_t SlotBits  = 6;
+	static constexpr std::size_t NumSlots  = std::size_t(1) << SlotBits;
+
+	/**
+	 * @param resolution Length of a tick. Timers never fire before their deadline
+	 *                   but can be late up to one tick.
+	 */
+	explicit timer_service(clock::duration resolution = std::chrono::milliseconds(1))
+	    : resolution_(resolution)
+	    , origin_(clock::now()) { }
+
+	timer_service(timer_service const& other) = delete;
+	timer_service(timer_service&& other)      = delete;
+
+	timer_service& operator=(timer_service const& other) = delete;
+	timer_service& operator=(timer_service&& other)      = delete;
+
+	/**
+	 * @brief Returns the service driven by a library-owned thread.
+	 *
+	 * The thread is started on the first call.
+	 */
+	static timer_service& global() {
+		static timer_service service;
+		static std::jthread  driver([](std::stop_token token) { service.run(token); });
+
+		return service;
+	}
+
+	/**
+	 * @brief Arms the timer to be fired at \p deadline.
+	 *
+	 * If the timer is already armed, it is rearmed.
+	 *
+	 * @param t Timer to arm.
+	 * @param deadline Time point the timer is fired.
+	 * @param period If not zero, the timer is fired repeatedly with the given interval.
+	 */
+	void arm(detail::timer_node& t, clock::time_point deadline, clock::duration period = clock::duration::zero()) {
+		std::scoped_lock l(mutex_);
+
+		if(t.linked_) {
+			unlink_(t);
+		}
+
+		t.service_ = this;
+		t.expiry_  = std::max(to_tick_(deadline), current_ + 1);
+		t.period_  = 0;
+		if(period > clock::duration::zero()) {
+			t.period_ = std::max<std::uint64_t>(1, (period + resolution_ - clock::duration(1)) / resolution_);
+		}
+
+		insert_(t);
+
+		if(t.expiry_ < wake_) {
+			wake_ = t.expiry_;
+			cv_.notify_one();
+		}
+	}
+
+	/**
+	 * @brief Disarms the timer.
+	 *
+	 * If the timer is being fired on another thread, it waits until the callback returns.
+	 * Canceled by its own callback, it returns immediately.
+	 *
+	 * @return False if the timer was not armed.
+	 */
+	bool cancel(detail::timer_node& t) {
+		std::unique_lock l(mutex_);
+		while(firing_ == &t && firing_thread_ != std::this_thread::get_id()) {
+			is_fire_waited_ = true;
+			fired_.wait(l);
+		}
+
+		if(!t.linked_) {
+			return false;
+		}
+
+		unlink_(t);
+		return true;
+	}
+
+	/**
+	 * @brief Fires all the timers whose deadline is before \p now.
+	 *
+	 * @return The number of fired timers.
+	 */
+	std::size_t advance(clock::time_point now = clock::now()) {
+		std::unique_lock l(mutex_);
+		return step_(l, to_tick_floor_(now));
+	}
+
+	/**
+	 * @brief Returns the time point the service needs to be advanced next.
+	 *
+	 * It can be earlier than the nearest deadline but never later.
+	 */
+	[[nodiscard]] clock::time_point next_expiry() const {
+		std::scoped_lock l(mutex_);
+		return to_time_point_(next_tick_());
+	}
+
+	/**
+	 * @brief Returns the number of armed timers.
+	 */
+	[[nodiscard]] std::size_t size() const {
+		std::scoped_lock l(mutex_);
+		return size_;
+	}
+
+	/**
+	 * @brief Drives the service on the current thread until \p token is stop requested.
+	 */
+	void run(std::stop_token token) {
+		std::unique_lock l(mutex_);
+		while(!token.stop_requested()) {
+			step_(l, to_tick_floor_(clock::now()));
+
+			auto const next = next_tick_();
+
+			wake_ = next;
+			if(next == NoTick) {
+				cv_.wait(l, token, [this, next] { return wake_ < next; });
+			} else {
+				cv_.wait_until(l, token, to_time_point_(next), [this, next] { return wake_ < next; });
+			}
+		}
+	}
+
+   private:
+	static constexpr std::uint64_t NoTick   = std::numeric_limits<std::uint64_t>::max();
+	static constexpr std::uint64_t MaxDelta = (std::uint64_t(1) << (SlotBits * NumLevels)) - 1;
+
+	std::uint64_t to_tick_(clock::time_point deadline) const {
+		if(deadline <= origin_) {
+			return 0;
+		}
+
+		auto const elapsed = deadline - origin_;
+		return elapsed / resolution_ + (elapsed % resolution_ != clock::duration::zero() ? 1 : 0);
+	}
+
+	std::uint64_t to_tick_floor_(clock::time_point now) const {
+		if(now <= origin_) {
+			return 0;
+		}
+
+		return (now - origin_) / resolution_;
+	}
+
+	clock::time_point to_time_point_(std::uint64_t tick) const {
+		if(tick == NoTick) {
+			return clock::time_point::max();
+		}
+
+		return origin_ + tick * resolution_;
+	}
+
+	void insert_(detail::timer_node& t) {
+		std::uint64_t expiry = std::max(t.expiry_, current_);
+		std::uint64_t delta  = expiry - current_;
+		if(delta > MaxDelta) {
+			// It will be reinserted when it reaches the furthest slot.
+			delta  = MaxDelta;
+			expiry = current_ + delta;
+		}
+
+		std::size_t const level = delta < NumSlots ? 0 : (std::bit_width(delta) - 1) / SlotBits;
+		std::size_t const slot  = (expiry >> (SlotBits * level)) & (NumSlots - 1);
+
+		auto& head = wheel_[level][slot];
+
+		t.prev_   = nullptr;
+		t.next_   = head;
+		t.linked_ = true;
+		t.level_  = static_cast<std::uint8_t>(level);
+		t.slot_   = static_cast<std::uint8_t>(slot);
+		if(head != nullptr) {
+			head->prev_ = &t;
+		}
+
+		head = &t;
+		occupied_[level] |= std::uint64_t(1) << slot;
+		++size_;
+	}
+
+	void unlink_(detail::timer_node& t) {
+		auto& head = wheel_[t.level_][t.slot_];
+		if(t.prev_ == nullptr) {
+			head = t.next_;
+		} else {
+			t.prev_->next_ = t.next_;
+		}
+		if(t.next_ != nullptr) {
+			t.next_->prev_ = t.prev_;
+		}
+		if(head == nullptr) {
+			occupied_[t.level_] &= ~(std::uint64_t(1) << t.slot_);
+		}
+
+		t.prev_   = nullptr;
+		t.next_   = nullptr;
+		t.linked_ = false;
+		--size_;
+	}
+
+	detail::timer_node* detach_(std::size_t level, std::size_t slot) {
+		auto* const head = std::exchange(wheel_[level][slot], nullptr);
+		occupied_[level] &= ~(std::uint64_t(1) << slot);
+
+		std::size_t n = 0;
+		for(auto* t = head; t != nullptr; t = t->next_) {
+			t->linked_ = false;
+			++n;
+		}
+
+		size_ -= n;
+		return head;
+	}
+
+	std::uint64_t next_tick_() const {
+		if(size_ == 0) {
+			return NoTick;
+		}
+
+		// Timers in the upper levels are moved down when their slot is reached.
+		std::uint64_t next = NoTick;
+		for(std::size_t level = 0; level < NumLevels; ++level) {
+			if(occupied_[level] == 0) {
+				continue;
+			}
+
+			auto const shift   = SlotBits * level;
+			auto const base    = current_ >> shift;
+			auto const rotated = std::rotr(occupied_[level], static_cast<int>((base + 1) & (NumSlots - 1)));
+
+			next = std::min(next, (base + std::countr_zero(rotated) + 1) << shift);
+		}
+
+		return next;
+	}
+
+	std::size_t step_(std::unique_lock<std::mutex>& l, std::uint64_t target) {
+		// The service is unlocked while the callbacks run, so only one thread steps at a time.
+		while(is_stepping_) {
+			is_fire_waited_ = true;
+			fired_.wait(l);
+		}
+		is_stepping_ = true;
+
+		target_ = target;
+
+		std::size_t fired = 0;
+		while(current_ < target) {
+			auto const next = next_tick_();
+			if(next > target) {
+				current_ = target;
+				break;
+			}
+
+			current_ = next;
+			cascade_();
+			fired += fire_(l);
+		}
+
+		is_stepping_ = false;
+		notify_fired_();
+		return fired;
+	}
+
+	void cascade_() {
+		std::size_t top = 0;
+		while(top + 1 < NumLevels) {
+			std::uint64_t const mask = (std::uint64_t(1) << (SlotBits * (top + 1))) - 1;
+			if((current_ & mask) != 0) {
+				break;
+			}
+
+			++top;
+		}
+
+		for(std::size_t level = top; level > 0; --level) {
+			std::size_t const slot = (current_ >> (SlotBits * level)) & (NumSlots - 1);
+
+			auto* t = detach_(level, slot);
+			while(t != nullptr) {
+				auto* const next = t->next_;
+				insert_(*t);
+				t = next;
+			}
+		}
+	}
+
+	std::size_t fire_(std::unique_lock<std::mutex>& l) {
+		std::size_t fired = 0;
+
+		// Timers are taken one at a time since the others can be canceled while a callback runs.
+		// Nothing armed in the meantime is placed in this slot, as it is at least one tick later.
+		auto& head = wheel_[0][current_ & (NumSlots - 1)];
+		while(auto* const t = head) {
+			unlink_(*t);
+			if(t->expiry_ > current_) {
+				// Deadline was too far to be placed at once.
+				insert_(*t);
+				continue;
+			}
+
+			if(t->period_ != 0) {
+				// Ticks missed until the target are dropped.
+				t->expiry_ += ((target_ - t->expiry_) / t->period_ + 1) * t->period_;
+				insert_(*t);
+			}
+
+			firing_        = t;
+			firing_thread_ = std::this_thread::get_id();
+
+			// The timer may be destroyed by its callback, so it is not touched after that.
+			l.unlock();
+			t->expire_(*t);
+			l.lock();
+
+			firing_ = nullptr;
+			notify_fired_();
+			++fired;
+		}
+
+		return fired;
+	}
+
+	void notify_fired_() {
+		if(std::exchange(is_fire_waited_, false)) {
+			fired_.notify_all();
+		}
+	}
+
+	clock::duration   resolution_;
+	clock::time_point origin_;
+
+	mutable std::mutex          mutex_;
+	std::condition_variable_any cv_;
+
+	// Notified when a callback returns or the stepping thread finishes.
+	std::condition_variable_any fired_;
+	bool                        is_fire_waited_ = false;
+
+	detail::timer_node* firing_ = nullptr;
+	std::thread::id     firing_thread_;
+	bool                is_stepping_ = false;
+
+	std::uint64_t current_ = 0;
+	std::uint64_t target_  = 0;
+	std::uint64_t wake_    = NoTick;
+	std::size_t   size_    = 0;
+
+	std::array<std::array<detail::timer_node*, NumSlots>, NumLevels> wheel_{};
+	std::array<std::uint64_t, NumLevels>                             occupied_{};
+};
+
+/**
+ * @brief Timer that invokes the callback when it is expired.
+ *
+ * The callback is invoked on the thread that drives the \ref timer_service,
+ * with the service unlocked.
+ * It is canceled when destroyed.
+ *
+ * @tparam F `void()`.
+ */
+template<typename F>
+class timer: public detail::timer_node {
+   public:
+	explicit timer(F on_expired)
+	    : detail::timer_node([](detail::timer_node& self) { static_cast<timer&>(self).on_expired_(); })
+	    , on_expired_(std::move(on_expired)) { }
+
+	~timer() {
+		cancel();
+	}
+
+	/**
+	 * @brief Disarms the timer.
+	 *
+	 * @return False if the timer was not armed.
+	 */
+	bool cancel() {
+		if(service_ == nullptr) {
+			return false;
+		}
+
+		return service_->cancel(*this);
+	}
+
+   private:
+	F on_expired_;
+};
+
+}  // namespace channel
+}  // namespace lesomnus
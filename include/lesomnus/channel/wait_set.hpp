@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+#include "lesomnus/channel/chan.hpp"
+#include "lesomnus/channel/detail/watcher.hpp"
+
+namespace lesomnus {
+namespace channel {
+
+/**
+ * @brief Set of channels waited on together, like `epoll`.
+ *
+ * Channels are registered once and they push themselves into the ready list of the set,
+ * so waiting does not register anything on the channels.
+ * It is level-triggered; a channel stays in the ready list until it is found not ready.
+ *
+ * The channels must outlive their registration.
+ * Only one thread may wait on the set or change the registrations at a time.
+ */
+class wait_set {
+   public:
+	using key_type = std::size_t;
+
+	wait_set() = default;
+
+	wait_set(wait_set const& other) = delete;
+	wait_set(wait_set&& other)      = delete;
+
+	wait_set& operator=(wait_set const& other) = delete;
+	wait_set& operator=(wait_set&& other)      = delete;
+
+	~wait_set() {
+		for(auto const& e: entries_) {
+			if(e->chan != nullptr) {
+				unwatch_(*e);
+			}
+		}
+	}
+
+	/**
+	 * @brief Watches for the channel on which a receive does not block.
+	 *
+	 * @return Key that identifies the registration.
+	 */
+	template<typename T>
+	key_type watch_recv(receiver<T>& chan) {
+		return watch_(chan, false);
+	}
+
+	/**
+	 * @brief Watches for the channel on which a send does not block.
+	 *
+	 * @return Key that identifies the registration.
+	 */
+	template<typename T>
+	key_type watch_send(sender<T>& chan) {
+		return watch_(chan, true);
+	}
+
+	/**
+	 * @brief Removes the registration.
+	 *
+	 * Its key can be reused by the later registration.
+	 * It does nothing if the key is already unwatched.
+	 */
+	void unwatch(key_type key) {
+		assert(key < entries_.size());
+
+		auto& e = *entries_[key];
+		if(e.chan == nullptr) {
+			return;
+		}
+
+		unwatch_(e);
+
+		std::scoped_lock l(mutex_);
+		if(e.is_ready) {
+			std::erase(ready_, &e);
+			e.is_ready = false;
+		}
+
+		e.chan = nullptr;
+		free_.push_back(key);
+	}
+
+	/**
+	 * @brief Blocks until any of the channels is ready.
+	 *
+	 * A reported channel may not be ready anymore if the other threads access it.
+	 *
+	 * @param[in]  token Interrupt register.
+	 * @param[out] keys Where the keys of the ready channels are stored. If it is empty, 0 is returned at once.
+	 * @return The number of the stored keys. It is 0 only if \p token is stop requested.
+	 */
+	std::size_t wait(std::stop_token token, std::span<key_type> keys) {
+		return wait_(token, std::chrono::steady_clock::time_point::max(), keys);
+	}
+
+	/**
+	 * @brief Blocks until any of the channels is ready.
+	 *
+	 * @param[out] keys Where the keys of the ready channels are stored. If it is empty, 0 is returned at once.
+	 * @return The number of the stored keys.
+	 */
+	std::size_t wait(std::span<key_type> keys) {
+		return wait_(std::stop_token{}, std::chrono::steady_clock::time_point::max(), keys);
+	}
+
+	/**
+	 * @brief Blocks until any of the channels is ready or \p timeout is elapsed.
+	 *
+	 * @param[in]  timeout Duration to give up.
+	 * @param[out] keys Where the keys of the ready channels are stored. If it is empty, 0 is returned at once.
+	 * @return The number of the stored keys. It is 0 if the timeout is elapsed.
+	 */
+	template<typename Rep, typename Period>
+	std::size_t wait_for(std::chrono::duration<Rep, Period> const& timeout, std::span<key_type> keys) {
+		return wait_(std::stop_token{}, detail::to_deadline(timeout), keys);
+	}
+
+	/**
+	 * @brief Returns the keys of the ready channels without blocking.
+	 *
+	 * @param[out] keys Where the keys of the ready channels are stored. If it is empty, 0 is returned at once.
+	 * @return The number of the stored keys.
+	 */
+	std::size_t try_wait(std::span<key_type> keys) {
+		return wait_(std::stop_token{}, std::chrono::steady_clock::time_point::min(), keys);
+	}
+
+   private:
+	struct entry final: detail::watcher {
+		wait_set*          set;
+		key_type           key;
+		detail::chan_base* chan    = nullptr;
+		bool               is_send = false;
+
+		// Guarded by `mutex_` of the set.
+		bool is_ready = false;
+
+		entry(wait_set* set, key_type key)
+		    : set(set)
+		    , key(key) { }
+
+		void notify() override {
+			set->notify_(*this);
+		}
+	};
+
+	key_type watch_(detail::chan_base& chan, bool is_send) {
+		key_type key = entries_.size();
+		if(free_.empty()) {
+			entries_.emplace_back(std::make_unique<entry>(this, key));
+			ready_.reserve(entries_.size());
+			polled_.reserve(entries_.size());
+		} else {
+			key = free_.back();
+			free_.pop_back();
+		}
+
+		auto& e   = *entries_[key];
+		e.chan    = &chan;
+		e.is_send = is_send;
+		if(poll_(e)) {
+			notify_(e);
+		}
+
+		return key;
+	}
+
+	static bool poll_(entry& e) {
+		if(e.is_send) {
+			return e.chan->watch_send(e);
+		} else {
+			return e.chan->watch_recv(e);
+		}
+	}
+
+	static void unwatch_(entry& e) {
+		if(e.is_send) {
+			e.chan->unwatch_send(e);
+		} else {
+			e.chan->unwatch_recv(e);
+		}
+	}
+
+	void notify_(entry& e) {
+		std::scoped_lock l(mutex_);
+		if(e.is_ready) {
+			return;
+		}
+
+		e.is_ready = true;
+		ready_.push_back(&e);
+		cv_.notify_one();
+	}
+
+	std::size_t wait_(std::stop_token token, std::chrono::steady_clock::time_point deadline, std::span<key_type> keys) {
+		if(keys.empty()) [[unlikely]] {
+			// Nothing could be reported, so it would never return.
+			return 0;
+		}
+
+		while(true) {
+			{
+				std::unique_lock l(mutex_);
+				auto const is_ready = [this] { return !ready_.empty(); };
+				if(deadline == std::chrono::steady_clock::time_point::max()) {
+					cv_.wait(l, token, is_ready);
+				} else {
+					cv_.wait_until(l, token, deadline, is_ready);
+				}
+
+				// Marked not ready before polling so the notification in the meantime is not lost.
+				auto const n = std::min(keys.size(), ready_.size());
+				for(std::size_t i = 0; i < n; ++i) {
+					ready_[i]->is_ready = false;
+				}
+
+				polled_.assign(ready_.begin(), ready_.begin() + n);
+				ready_.erase(ready_.begin(), ready_.begin() + n);
+			}
+
+			std::size_t n = 0;
+			for(auto* const e: polled_) {
+				if(poll_(*e)) {
+					keys[n++] = e->key;
+					notify_(*e);
+				}
+			}
+
+			if(n > 0 || token.stop_requested() || std::chrono::steady_clock::now() >= deadline) {
+				return n;
+			}
+		}
+	}
+
+	std::mutex                  mutex_;
+	std::condition_variable_any cv_;
+
+	std::vector<std::unique_ptr<entry>> entries_;
+	std::vector<key_type>               free_;
+
+	std::vector<entry*> ready_;
+
+	// Entries being polled by the waiting thread.
+	std::vector<entry*> polled_;
+};
+
+}  // namespace channel
+}  // namespace lesomnus
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+
+namespace testing {
+
+/**
+ * @brief Coroutine that starts eagerly and nobody awaits.
+ */
+struct detached {
+	struct promise_type {
+		detached get_return_object() noexcept {
+			return {};
+		}
+
+		std::suspend_never initial_suspend() noexcept {
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+
+		void return_void() noexcept { }
+
+		void unhandled_exception() noexcept {
+			std::terminate();
+		}
+	};
+};
+
+}  // namespace testing
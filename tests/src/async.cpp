@@ -0,0 +1,248 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/executor.hpp>
+#include <lesomnus/channel/select.hpp>
+
+#include "testing/constants.hpp"
+#include "testing/coro.hpp"
+
+namespace {
+
+using namespace lesomnus::channel;
+
+testing::detached consume(receiver<int>& chan, int& sum, run_loop& loop) {
+	int v = 0;
+	while(co_await chan.async_recv(v)) {
+		sum += v;
+	}
+
+	loop.finish();
+}
+
+testing::detached produce(sender<int>& chan, int n, std::atomic<int>& num_done) {
+	for(int i = 1; i <= n; ++i) {
+		co_await chan.async_send(i);
+	}
+
+	++num_done;
+}
+
+testing::detached expire(receiver<int>& chan, std::promise<void> done) {
+	co_await async_select(recv(chan), after(std::chrono::milliseconds(10)));
+	done.set_value();
+}
+
+}  // namespace
+
+TEST_CASE("async_recv") {
+	run_loop loop;
+
+	auto chan = bounded_channel<int, 0>();
+
+	SECTION("suspends until the value is sent") {
+		int        sum    = 0;
+		auto const sender = std::jthread([&] {
+			for(int i = 1; i <= 100; ++i) {
+				chan.send(i);
+			}
+			chan.close();
+		});
+
+		loop.post([&] { consume(chan, sum, loop); });
+		loop.run();
+
+		REQUIRE(5050 == sum);
+	}
+
+	SECTION("is resumed on the given executor") {
+		std::thread::id resumed_on;
+		bool            ok = false;
+
+		auto const f = [&]() -> testing::detached {
+			int v = 0;
+			ok         = co_await chan.async_recv(v, loop);
+			resumed_on = std::this_thread::get_id();
+			loop.finish();
+		};
+		f();
+
+		auto const sender = std::jthread([&] { chan.send(42); });
+		loop.run();
+
+		REQUIRE(ok);
+		REQUIRE(std::this_thread::get_id() == resumed_on);
+	}
+
+	SECTION("results in false if the channel is closed") {
+		bool ok = true;
+
+		auto const f = [&]() -> testing::detached {
+			int v = 0;
+			ok    = co_await chan.async_recv(v);
+			loop.finish();
+		};
+		loop.post([&] { f(); });
+
+		auto const closer = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			chan.close();
+		});
+		loop.run();
+
+		REQUIRE_FALSE(ok);
+	}
+
+	SECTION("can be canceled") {
+		std::stop_source stop_source;
+		std::error_code  ec;
+
+		auto const f = [&]() -> testing::detached {
+			int v = 0;
+			co_await chan.async_recv(stop_source.get_token(), v, ec);
+			loop.finish();
+		};
+		loop.post([&] { f(); });
+
+		auto const canceler = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			stop_source.request_stop();
+		});
+		loop.run();
+
+		REQUIRE(channel_errc::canceled == ec);
+		REQUIRE(0 == chan.size());
+	}
+}
+
+TEST_CASE("async_send and async_recv between many coroutines on a thread") {
+	constexpr int NumProducers = 1'000;
+	constexpr int NumValues    = 100;
+
+	run_loop loop;
+
+	auto chan = bounded_channel<int, 0>();
+
+	int              sum      = 0;
+	std::atomic<int> num_done = 0;
+
+	loop.post([&] {
+		for(int i = 0; i < NumProducers; ++i) {
+			produce(chan, NumValues, num_done);
+		}
+
+		consume(chan, sum, loop);
+	});
+
+	// Closes the channel once all the producers are done.
+	auto const closer = std::jthread([&] {
+		while(num_done < NumProducers) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		chan.close();
+	});
+
+	loop.run();
+
+	REQUIRE(NumProducers * (NumValues * (NumValues + 1) / 2) == sum);
+}
+
+TEST_CASE("async_select") {
+	run_loop loop;
+
+	auto chan1 = bounded_channel<int, 0>();
+	auto chan2 = bounded_channel<int, 0>();
+
+	SECTION("completes one of the operations") {
+		int received = 0;
+
+		auto const f = [&]() -> testing::detached {
+			co_await async_select(
+			    recv(chan1, [&](bool, int&& v) { received = -v; }),
+			    recv(chan2, [&](bool, int&& v) { received = v; }));
+			loop.finish();
+		};
+		loop.post([&] { f(); });
+
+		auto const sender = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			chan2.send(42);
+		});
+		loop.run();
+
+		REQUIRE(42 == received);
+		REQUIRE(0 == chan1.size());
+	}
+
+	SECTION("completes the ready operation without suspension") {
+		auto buffered = bounded_channel<int, 1>();
+		buffered.send(42);
+
+		int received = 0;
+
+		auto const f = [&]() -> testing::detached {
+			co_await async_select(
+			    recv(chan1, [&](bool, int&& v) { received = -v; }),
+			    recv(buffered, [&](bool, int&& v) { received = v; }));
+		};
+		f();
+
+		REQUIRE(42 == received);
+	}
+
+	SECTION("expires") {
+		bool is_expired = false;
+
+		auto const f = [&]() -> testing::detached {
+			co_await async_select(
+			    recv(chan1),
+			    after(testing::ReasonableWaitingTime, [&] { is_expired = true; }));
+			loop.finish();
+		};
+		loop.post([&] { f(); });
+		loop.run();
+
+		REQUIRE(is_expired);
+		REQUIRE(0 == chan1.size());
+	}
+
+	SECTION("expires on the default executor") {
+		std::promise<void> done;
+		auto               is_done = done.get_future();
+
+		// Resumed inline on the thread driving the timer service.
+		expire(chan1, std::move(done));
+		REQUIRE(std::future_status::ready == is_done.wait_for(10 * testing::ReasonableWaitingTime));
+		REQUIRE(0 == chan1.size());
+	}
+
+	SECTION("can be canceled") {
+		std::stop_source stop_source;
+
+		bool is_resumed = false;
+
+		auto const f = [&]() -> testing::detached {
+			co_await async_select(stop_source.get_token(), recv(chan1), send(chan2, 42));
+			is_resumed = true;
+			loop.finish();
+		};
+		loop.post([&] { f(); });
+
+		auto const canceler = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			stop_source.request_stop();
+		});
+		loop.run();
+
+		REQUIRE(is_resumed);
+		REQUIRE(0 == chan1.size());
+		REQUIRE(0 == chan2.size());
+	}
+}
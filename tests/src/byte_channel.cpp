@@ -0,0 +1,212 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/byte_channel.hpp>
+#include <lesomnus/channel/error.hpp>
+
+#include "testing/constants.hpp"
+
+namespace {
+
+std::vector<std::byte> make_bytes(std::size_t n, std::size_t offset = 0) {
+	std::vector<std::byte> bytes(n);
+	for(std::size_t i = 0; i < n; ++i) {
+		bytes[i] = static_cast<std::byte>((offset + i) % 251);
+	}
+
+	return bytes;
+}
+
+}  // namespace
+
+TEST_CASE("byte_channel") {
+	using namespace lesomnus::channel;
+
+	auto chan = byte_channel(8);
+	REQUIRE(8 == chan.capacity());
+
+	std::error_code ec;
+
+	SECTION("try_write writes as many bytes as fit") {
+		auto const data = make_bytes(12);
+		REQUIRE(8 == chan.try_write(data, ec));
+		REQUIRE(channel_errc::ok == ec);
+		REQUIRE(8 == chan.size());
+
+		REQUIRE(0 == chan.try_write(data, ec));
+		REQUIRE(channel_errc::exhausted == ec);
+
+		std::array<std::byte, 5> received{};
+		REQUIRE(5 == chan.try_read(received, ec));
+		REQUIRE(0 == std::memcmp(data.data(), received.data(), 5));
+
+		// Wraps around the end of the ring.
+		REQUIRE(4 == chan.try_write(std::span(data).subspan(8), ec));
+		REQUIRE(7 == chan.size());
+
+		std::array<std::byte, 16> rest{};
+		REQUIRE(7 == chan.try_read(rest, ec));
+		REQUIRE(0 == std::memcmp(data.data() + 5, rest.data(), 7));
+
+		REQUIRE(0 == chan.try_read(rest, ec));
+		REQUIRE(channel_errc::exhausted == ec);
+	}
+
+	SECTION("read_some waits for a byte") {
+		auto writer = std::jthread([&] {
+			while(chan.num_waiting_readers() != 1) {
+				std::this_thread::yield();
+			}
+			chan.write(make_bytes(3));
+		});
+
+		std::array<std::byte, 8> received{};
+		REQUIRE(3 == chan.read_some(std::stop_token{}, received, ec));
+		REQUIRE(channel_errc::ok == ec);
+	}
+
+	SECTION("transfers a stream larger than the capacity") {
+		constexpr std::size_t N = 100'000;
+
+		auto const data = make_bytes(N);
+
+		auto writer = std::jthread([&] {
+			// Writes in uneven pieces.
+			for(std::size_t i = 0; i < N; i += 13) {
+				chan.write(std::span(data).subspan(i, std::min<std::size_t>(13, N - i)));
+			}
+		});
+
+		std::vector<std::byte> received(N);
+		REQUIRE(chan.read(received));
+		REQUIRE(data == received);
+	}
+
+	SECTION("regions give the contiguous bytes of the ring") {
+		auto const data = make_bytes(6);
+		REQUIRE(6 == chan.try_write(data, ec));
+
+		std::array<std::byte, 4> skipped{};
+		REQUIRE(4 == chan.try_read(skipped, ec));
+
+		// Free bytes from the back to the end of the ring.
+		auto w = chan.write_region({}, ec);
+		REQUIRE(channel_errc::ok == ec);
+		REQUIRE(2 == w.size());
+		w[0] = std::byte{42};
+		w[1] = std::byte{43};
+		chan.commit(2);
+		REQUIRE(4 == chan.size());
+
+		auto r = chan.read_region({}, ec);
+		REQUIRE(channel_errc::ok == ec);
+		REQUIRE(4 == r.size());
+		REQUIRE(data[4] == r[0]);
+		REQUIRE(std::byte{43} == r[3]);
+		chan.consume(4);
+		REQUIRE(0 == chan.size());
+	}
+
+	SECTION("closing it releases the readers and discards the bytes") {
+		REQUIRE(3 == chan.try_write(make_bytes(3), ec));
+
+		std::size_t n = 0;
+
+		std::error_code read_ec;
+		auto            reader = std::jthread([&] {
+			std::array<std::byte, 8> received{};
+			n = chan.read(std::stop_token{}, received, read_ec);
+		});
+
+		while(chan.num_waiting_readers() != 1) {
+			std::this_thread::yield();
+		}
+		chan.close();
+		reader.join();
+
+		REQUIRE(3 == n);
+		REQUIRE(channel_errc::closed == read_ec);
+		REQUIRE(0 == chan.size());
+		REQUIRE(!chan.write(make_bytes(1)));
+	}
+
+	SECTION("waiting gives up at the deadline") {
+		std::array<std::byte, 8> received{};
+		REQUIRE(0 == chan.read_some_for(testing::ReasonableWaitingTime, received, ec));
+		REQUIRE(channel_errc::timeout == ec);
+
+		REQUIRE(8 == chan.try_write(make_bytes(8), ec));
+		REQUIRE(0 == chan.write_some_until({}, std::chrono::steady_clock::now() + testing::ReasonableWaitingTime, make_bytes(1), ec));
+		REQUIRE(channel_errc::timeout == ec);
+
+		REQUIRE(8 == chan.read_some_for(testing::ReasonableWaitingTime, received, ec));
+		REQUIRE(channel_errc::ok == ec);
+	}
+
+	SECTION("a wakeup is passed on while bytes remain") {
+		constexpr std::size_t NumReaders = 4;
+
+		std::vector<std::jthread> readers;
+		for(std::size_t i = 0; i < NumReaders; ++i) {
+			readers.emplace_back([&] {
+				std::array<std::byte, 1> received{};
+				std::error_code          ec;
+				chan.read_some(std::stop_token{}, received, ec);
+			});
+		}
+		while(chan.num_waiting_readers() != NumReaders) {
+			std::this_thread::yield();
+		}
+
+		// Only one reader is woken up by the write, and each one wakes up the next.
+		REQUIRE(NumReaders == chan.try_write(make_bytes(NumReaders), ec));
+		readers.clear();
+		REQUIRE(0 == chan.size());
+	}
+
+	SECTION("a wakeup is passed on while room remains") {
+		constexpr std::size_t NumWriters = 4;
+
+		REQUIRE(8 == chan.try_write(make_bytes(8), ec));
+
+		std::vector<std::jthread> writers;
+		for(std::size_t i = 0; i < NumWriters; ++i) {
+			writers.emplace_back([&] {
+				std::error_code ec;
+				chan.write_some(std::stop_token{}, make_bytes(1), ec);
+			});
+		}
+		while(chan.num_waiting_writers() != NumWriters) {
+			std::this_thread::yield();
+		}
+
+		std::array<std::byte, NumWriters> received{};
+		REQUIRE(NumWriters == chan.try_read(received, ec));
+		writers.clear();
+		REQUIRE(8 == chan.size());
+	}
+
+	SECTION("waiting is canceled by the token") {
+		std::stop_source stop;
+		stop.request_stop();
+
+		std::array<std::byte, 8> received{};
+		REQUIRE(0 == chan.read_some(stop.get_token(), received, ec));
+		REQUIRE(channel_errc::canceled == ec);
+	}
+}
+
+TEST_CASE("byte_channel takes only a positive capacity") {
+	REQUIRE_THROWS_AS(lesomnus::channel::byte_channel(0), std::invalid_argument);
+}
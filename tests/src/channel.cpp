@@ -1,12 +1,16 @@
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <ranges>
 #include <shared_mutex>
 #include <stop_token>
+#include <string>
+#include <system_error>
 #include <thread>
 #include <vector>
 
@@ -15,6 +19,8 @@
 
 #include <lesomnus/channel/chan.hpp>
 #include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/executor.hpp>
+#include <lesomnus/channel/timer.hpp>
 
 #include "testing/constants.hpp"
 
@@ -121,6 +127,57 @@ class ChannelTestSuite {
 			REQUIRE_FALSE(ok);
 		}
 
+		SECTION("receive fails if deadline exceeded") {
+			auto const chan = make_chan<int, 0>();
+
+			auto const t0 = std::chrono::steady_clock::now();
+
+			int             v = 0;
+			std::error_code ec;
+			chan->recv_for(testing::ReasonableWaitingTime, v, ec);
+			auto const t1 = std::chrono::steady_clock::now();
+
+			REQUIRE(testing::ReasonableWaitingTime <= (t1 - t0));
+			REQUIRE(lesomnus::channel::channel_errc::timeout == ec);
+			REQUIRE(0 == chan->size());
+		}
+
+		SECTION("receive succeeds if data available before deadline") {
+			auto const chan = make_chan<int, 0>();
+
+			auto const sender = std::jthread([&] {
+				std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+				chan->send(42);
+			});
+
+			int v = 0;
+			REQUIRE(chan->recv_until(std::chrono::system_clock::now() + 10 * testing::ReasonableWaitingTime, v));
+			REQUIRE(42 == v);
+		}
+
+		SECTION("receive waits for the value if the timeout is the max duration") {
+			auto const chan = make_chan<int, 0>();
+
+			auto const sender = std::jthread([&] {
+				std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+				chan->send(42);
+				chan->send(43);
+				chan->send(44);
+			});
+
+			int             v = 0;
+			std::error_code ec;
+			chan->recv_for(std::chrono::nanoseconds::max(), v, ec);
+			REQUIRE(lesomnus::channel::channel_errc::ok == ec);
+			REQUIRE(42 == v);
+
+			REQUIRE(chan->recv_for(std::chrono::hours::max(), v));
+			REQUIRE(43 == v);
+
+			REQUIRE(chan->recv_until(std::chrono::system_clock::time_point::max(), v));
+			REQUIRE(44 == v);
+		}
+
 		SECTION("size is negative if receive hanged") {
 			auto const chan = make_chan<int, 0>();
 
@@ -196,6 +253,20 @@ class ChannelTestSuite {
 			REQUIRE(testing::ReasonableWaitingTime <= (t1 - t0));
 		}
 
+		SECTION("send fails if deadline exceeded") {
+			auto const chan = make_chan<int, 0>();
+
+			auto const t0 = std::chrono::steady_clock::now();
+
+			std::error_code ec;
+			chan->send_for(testing::ReasonableWaitingTime, 42, ec);
+			auto const t1 = std::chrono::steady_clock::now();
+
+			REQUIRE(testing::ReasonableWaitingTime <= (t1 - t0));
+			REQUIRE(lesomnus::channel::channel_errc::timeout == ec);
+			REQUIRE(0 == chan->size());
+		}
+
 		SECTION("size greater than capacity if send hanged") {
 			auto const chan = make_chan<int, 0>();
 
@@ -304,3 +375,392 @@ TEMPLATE_TEST_CASE("multi send recv", "", V<0>, V<1>, V<2>, V<3>, V<lesomnus::ch
 
 	REQUIRE(std::all_of(marks.begin(), marks.end(), [](bool v) { return v == 1; }));
 }
+
+TEST_CASE("unbuffered channel hands the value over with a single move") {
+	struct counter {
+		int copies = 0;
+		int moves  = 0;
+
+		counter() = default;
+		counter(counter const& other)
+		    : copies(other.copies + 1)
+		    , moves(other.moves) { }
+		counter(counter&& other)
+		    : copies(other.copies)
+		    , moves(other.moves + 1) { }
+
+		counter& operator=(counter const& other) {
+			copies = other.copies + 1;
+			moves  = other.moves;
+			return *this;
+		}
+		counter& operator=(counter&& other) {
+			copies = other.copies;
+			moves  = other.moves + 1;
+			return *this;
+		}
+	};
+
+	lesomnus::channel::bounded_channel<counter, 0> chan;
+
+	SECTION("to the hanged receiver") {
+		counter v;
+		auto    receiver = std::jthread([&] { chan.recv(v); });
+		while(chan.size() != -1) {
+			std::this_thread::yield();
+		}
+
+		REQUIRE(chan.send(counter{}));
+		receiver.join();
+
+		REQUIRE(0 == v.copies);
+		REQUIRE(1 == v.moves);
+	}
+
+	SECTION("from the hanged sender") {
+		auto const sender = std::jthread([&] { chan.send(counter{}); });
+		while(chan.size() != 1) {
+			std::this_thread::yield();
+		}
+
+		counter v;
+		REQUIRE(chan.recv(v));
+		REQUIRE(0 == v.copies);
+		REQUIRE(1 == v.moves);
+	}
+}
+
+TEST_CASE("timed send takes a value convertible to the element") {
+	using namespace lesomnus::channel;
+
+	bounded_channel<std::string, 1> chan;
+	REQUIRE(chan.send_for(testing::ReasonableWaitingTime, "foo"));
+
+	std::error_code ec;
+	chan.send_until(std::chrono::system_clock::now() + testing::ReasonableWaitingTime, "bar", ec);
+	REQUIRE(channel_errc::timeout == ec);
+
+	std::string v;
+	REQUIRE(chan.try_recv(v));
+	REQUIRE("foo" == v);
+}
+
+TEST_CASE("blocked thread times out below the resolution of the timer service") {
+	using namespace lesomnus::channel;
+	using namespace std::chrono_literals;
+
+	bounded_channel<int, 0> chan;
+
+	constexpr int N = 20;
+
+	auto const t0 = std::chrono::steady_clock::now();
+	for(int i = 0; i < N; ++i) {
+		int             v = 0;
+		std::error_code ec;
+		chan.recv_for(50us, v, ec);
+		REQUIRE(channel_errc::timeout == ec);
+	}
+	auto const t1 = std::chrono::steady_clock::now();
+
+	REQUIRE((t1 - t0) / N < 500us);
+	REQUIRE(0 == timer_service::global().size());
+}
+
+TEST_CASE("timed operation times out on the thread of the timer service") {
+	using namespace lesomnus::channel;
+	using namespace std::chrono_literals;
+
+	bounded_channel<int, 0> chan;
+
+	std::atomic_bool done = false;
+	std::error_code  ec;
+
+	auto t = timer([&] {
+		int v = 0;
+		chan.recv_for(20ms, v, ec);
+		done = true;
+		done.notify_one();
+	});
+	timer_service::global().arm(t, timer_service::clock::now());
+
+	auto const t0 = std::chrono::steady_clock::now();
+	while(!done && std::chrono::steady_clock::now() - t0 < 10 * testing::ReasonableWaitingTime) {
+		std::this_thread::yield();
+	}
+
+	REQUIRE(done);
+	REQUIRE(channel_errc::timeout == ec);
+}
+
+TEST_CASE("scheduled callbacks are posted to the executor") {
+	using namespace lesomnus::channel;
+
+	run_loop loop;
+
+	bounded_channel<int, 0> chan;
+
+	SECTION("recv_sched") {
+		std::thread::id called_on;
+		int             received = 0;
+		chan.recv_sched(
+		    [&](bool, int&& v) {
+			    called_on = std::this_thread::get_id();
+			    received  = v;
+			    loop.finish();
+		    },
+		    loop);
+
+		auto const sender = std::jthread([&] { chan.send(42); });
+		loop.run();
+
+		REQUIRE(42 == received);
+		REQUIRE(std::this_thread::get_id() == called_on);
+	}
+
+	SECTION("send_sched") {
+		std::thread::id called_on;
+		bool            is_sent = false;
+		chan.send_sched(
+		    42,
+		    [&](bool ok) {
+			    called_on = std::this_thread::get_id();
+			    is_sent   = ok;
+			    loop.finish();
+		    },
+		    loop);
+
+		int        received = 0;
+		auto const receiver = std::jthread([&] { chan.recv(received); });
+		loop.run();
+
+		REQUIRE(is_sent);
+		REQUIRE(42 == received);
+		REQUIRE(std::this_thread::get_id() == called_on);
+	}
+
+	SECTION("run inline if settled immediately") {
+		bounded_channel<int, 1> buffered;
+
+		bool is_sent = false;
+		buffered.send_sched(
+		    42, [&](bool ok) { is_sent = ok; }, loop);
+
+		REQUIRE(is_sent);
+		REQUIRE(0 == loop.poll());
+	}
+}
+
+TEST_CASE("settled callbacks are invoked after the channel is unlocked") {
+	using namespace lesomnus::channel;
+
+	bounded_channel<int, 0> chan;
+
+	SECTION("by send") {
+		// It would deadlock if the callback is invoked with the channel locked.
+		int received = 0;
+		chan.recv_sched([&](bool, int&& v) {
+			received = v;
+			chan.close();
+		});
+
+		REQUIRE(chan.send(42));
+		REQUIRE(42 == received);
+		REQUIRE_FALSE(chan.send(36));
+	}
+
+	SECTION("by close") {
+		constexpr int N = 1'000;
+
+		int num_closed = 0;
+		for(int i = 0; i < N; ++i) {
+			chan.recv_sched([&](bool ok, int&&) {
+				num_closed += !ok;
+				REQUIRE(0 == chan.size());  // It would deadlock if the channel is locked.
+			});
+		}
+
+		chan.close();
+		REQUIRE(N == num_closed);
+	}
+
+	SECTION("need_abort by close") {
+		constexpr int N = 1'000;
+
+		int num_aborted = 0;
+		int num_closed  = 0;
+		for(int i = 0; i < N; ++i) {
+			chan.recv_sched(
+			    [&] {
+				    // It would deadlock if the channel is locked.
+				    std::error_code ec;
+				    chan.try_send(0, ec);
+				    REQUIRE(channel_errc::closed == ec);
+				    return ++num_aborted % 2 == 0;
+			    },
+			    [&](bool ok, int&&) { num_closed += !ok; });
+		}
+
+		chan.close();
+		REQUIRE(N == num_aborted);
+		REQUIRE(N / 2 == num_closed);
+	}
+}
+
+TEST_CASE("batch operations lock the channel once") {
+	using namespace lesomnus::channel;
+
+	// Counts how many times the batch operations lock it.
+	struct counting_channel: bounded_channel<int, 4> {
+		int num_locks = 0;
+
+		void lock() override {
+			bounded_channel<int, 4>::lock();
+			++num_locks;
+		}
+	};
+
+	counting_channel chan;
+
+	std::error_code ec;
+
+	std::array<int, 6> values{1, 2, 3, 4, 5, 6};
+	REQUIRE(4 == chan.try_send_many(values, ec));
+	REQUIRE(channel_errc::exhausted == ec);
+	REQUIRE(1 == chan.num_locks);
+
+	std::array<int, 3> received{};
+	REQUIRE(3 == chan.try_recv_many(received, ec));
+	REQUIRE(channel_errc::ok == ec);
+	REQUIRE(std::array<int, 3>{1, 2, 3} == received);
+	REQUIRE(2 == chan.num_locks);
+
+	REQUIRE(1 == chan.try_recv_many(received, ec));
+	REQUIRE(channel_errc::exhausted == ec);
+	REQUIRE(4 == received[0]);
+	REQUIRE(3 == chan.num_locks);
+
+	chan.close();
+	REQUIRE(0 == chan.try_recv_many(received, ec));
+	REQUIRE(channel_errc::closed == ec);
+}
+
+TEST_CASE("receiver is an input range") {
+	using namespace lesomnus::channel;
+
+	static_assert(std::ranges::input_range<receiver<int>&>);
+	static_assert(std::ranges::view<detail::recv_range<int>>);
+	static_assert(!std::ranges::sized_range<bounded_channel<int, 8>&>);
+
+	REQUIRE(detail::recv_iterator<int>() == std::default_sentinel);
+	REQUIRE(detail::recv_value_iterator<int>() == std::default_sentinel);
+
+	constexpr int N = 1'000;
+
+	bounded_channel<int, 8> chan;
+
+	SECTION("iterates until the channel is closed") {
+		auto sender = std::jthread([&] {
+			for(int i = 0; i < N; ++i) {
+				chan.send(i);
+			}
+
+			// Waits for the receiver to take the values since closing discards them.
+			while(chan.size() > 0) {
+				std::this_thread::yield();
+			}
+			chan.close();
+		});
+
+		std::vector<int> received;
+		for(auto&& v: chan) {
+			received.push_back(v);
+		}
+
+		REQUIRE(N == received.size());
+		for(int i = 0; i < N; ++i) {
+			REQUIRE(i == received[i]);
+		}
+	}
+
+	SECTION("works with the range adaptors") {
+		for(int i = 0; i < 8; ++i) {
+			chan.send(i);
+		}
+
+		// The batch of 1 leaves the values not visited in the channel.
+		std::vector<int> evens;
+		for(auto const v: chan.range({}, 1) | std::views::take(5) | std::views::filter([](int v) { return v % 2 == 0; })) {
+			evens.push_back(v);
+		}
+		REQUIRE(std::vector<int>{0, 2, 4} == evens);
+		REQUIRE(3 == chan.size());
+	}
+
+	SECTION("takes the count of the values even if fewer are buffered") {
+		chan.send(0);
+
+		auto sender = std::jthread([&] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			chan.send(1);
+			chan.send(2);
+		});
+
+		std::vector<int> received;
+		for(auto const v: chan | std::views::take(3)) {
+			received.push_back(v);
+		}
+		REQUIRE(std::vector<int>{0, 1, 2} == received);
+	}
+
+	SECTION("leaves the values not visited in the channel if the loop breaks") {
+		for(int i = 0; i < 8; ++i) {
+			chan.send(i);
+		}
+
+		for(auto const v: chan) {
+			if(v == 2) {
+				break;
+			}
+		}
+		REQUIRE(5 == chan.size());
+	}
+
+	SECTION("keeps the values not visited in the range") {
+		for(int i = 0; i < 8; ++i) {
+			chan.send(i);
+		}
+
+		auto r = chan.range();
+		for(auto const v: r) {
+			if(v == 2) {
+				break;
+			}
+		}
+		REQUIRE(0 == chan.size());
+
+		chan.close();
+
+		std::vector<int> rest;
+		for(auto const v: r) {
+			rest.push_back(v);
+		}
+		// The value the loop stopped at is not incremented past.
+		REQUIRE(std::vector<int>{2, 3, 4, 5, 6, 7} == rest);
+	}
+
+	SECTION("ends when the token is stop requested") {
+		std::stop_source stop;
+
+		auto canceler = std::jthread([&] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			stop.request_stop();
+		});
+
+		int n = 0;
+		for(auto&& v: chan.range(stop.get_token())) {
+			(void)v;
+			++n;
+		}
+		REQUIRE(0 == n);
+	}
+}
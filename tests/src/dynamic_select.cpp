@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/dynamic_select.hpp>
+
+#include "testing/constants.hpp"
+
+TEST_CASE("dynamic_select") {
+	using namespace lesomnus::channel;
+
+	constexpr std::size_t N = 1'000;
+
+	std::vector<std::unique_ptr<bounded_channel<int, 0>>> chans;
+	std::vector<recv_case<int>>                           cases;
+	chans.reserve(N);
+	cases.reserve(N);
+	for(std::size_t i = 0; i < N; ++i) {
+		chans.emplace_back(std::make_unique<bounded_channel<int, 0>>());
+		cases.emplace_back(*chans.back());
+	}
+
+	SECTION("returns the index of the ready case") {
+		auto buffered = bounded_channel<int, 1>();
+		buffered.send(42);
+
+		cases[N / 2] = recv_case<int>(buffered);
+
+		auto const i = dynamic_select(cases);
+		REQUIRE(N / 2 == i);
+		REQUIRE(cases[i].ok());
+		REQUIRE(42 == cases[i].value());
+	}
+
+	SECTION("waits for one of the cases") {
+		auto const sender = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			chans[N - 1]->send(42);
+		});
+
+		auto const i = dynamic_select(cases);
+		REQUIRE(N - 1 == i);
+		REQUIRE(cases[i].ok());
+		REQUIRE(42 == cases[i].value());
+
+		for(auto const& chan: chans) {
+			REQUIRE(0 == chan->size());  // It will be -1 if it is not canceled.
+		}
+	}
+
+	SECTION("can be reused") {
+		auto const sender = std::jthread([&] {
+			for(std::size_t i = 0; i < N; ++i) {
+				chans[i]->send(static_cast<int>(i));
+			}
+		});
+
+		for(std::size_t n = 0; n < N; ++n) {
+			auto const i = dynamic_select(cases);
+			REQUIRE(i < N);
+			REQUIRE(static_cast<int>(i) == cases[i].value());
+		}
+	}
+
+	SECTION("reports the closed channel") {
+		chans[7]->close();
+
+		auto const i = dynamic_select(cases);
+		REQUIRE(7 == i);
+		REQUIRE_FALSE(cases[i].ok());
+	}
+
+	SECTION("returns the size if canceled") {
+		std::stop_source stop_source;
+
+		auto const canceler = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			stop_source.request_stop();
+		});
+
+		REQUIRE(N == dynamic_select(stop_source.get_token(), cases));
+		for(auto const& chan: chans) {
+			REQUIRE(0 == chan->size());
+		}
+	}
+
+	SECTION("returns the size if no case is ready") {
+		REQUIRE(N == try_dynamic_select(cases));
+	}
+
+	SECTION("is not biased toward the case after the unready ones") {
+		constexpr int M = 1'000;
+
+		auto chan1 = bounded_channel<int, 1>();
+		auto chan2 = bounded_channel<int, 1>();
+
+		// Two ready cases after a run of unready ones.
+		std::vector<recv_case<int>> few;
+		few.emplace_back(*chans[0]);
+		few.emplace_back(*chans[1]);
+		few.emplace_back(chan1);
+		few.emplace_back(chan2);
+
+		int count = 0;
+		for(int i = 0; i < M; ++i) {
+			chan1.try_send(0);
+			chan2.try_send(0);
+			if(2 == try_dynamic_select(few)) {
+				++count;
+			}
+		}
+
+		// Expected to be M/2, while choosing the first ready one from a random rotation makes it 3M/4.
+		REQUIRE(M * 2 / 5 < count);
+		REQUIRE(count < M * 3 / 5);
+	}
+}
+
+TEST_CASE("dynamic_select with cases of different types") {
+	using namespace lesomnus::channel;
+
+	auto chan1 = bounded_channel<int, 0>();
+	auto chan2 = bounded_channel<std::string, 0>();
+
+	auto c1 = recv_case<int>(chan1);
+	auto c2 = send_case<std::string>(chan2, "foo");
+
+	std::string received;
+
+	auto const receiver = std::jthread([&] {
+		std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+		chan2.recv(received);
+	});
+
+	select_case* cases[] = {&c1, &c2};
+
+	REQUIRE(1 == dynamic_select(cases));
+	REQUIRE(c2.ok());
+	REQUIRE("foo" == received);
+	REQUIRE(0 == chan1.size());
+}
@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <thread>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/event_fd.hpp>
+
+namespace {
+
+bool is_readable(int fd) {
+	pollfd p{.fd = fd, .events = POLLIN, .revents = 0};
+	return ::poll(&p, 1, 0) == 1 && (p.revents & POLLIN) != 0;
+}
+
+}  // namespace
+
+TEST_CASE("event_fd") {
+	using namespace lesomnus::channel;
+
+	auto chan = bounded_channel<int, 4>();
+
+	SECTION("becomes readable when the channel has a value") {
+		auto ev = event_fd::watch_recv(chan);
+		REQUIRE(!is_readable(ev.fd()));
+
+		REQUIRE(chan.try_send(1));
+		REQUIRE(is_readable(ev.fd()));
+	}
+
+	SECTION("is signaled once until it is reset") {
+		auto ev = event_fd::watch_recv(chan);
+		REQUIRE(chan.try_send(1));
+		REQUIRE(chan.try_send(2));
+		REQUIRE(chan.try_send(3));
+
+		std::uint64_t count = 0;
+		REQUIRE(sizeof(count) == ::read(ev.fd(), &count, sizeof(count)));
+		REQUIRE(1 == count);
+	}
+
+	SECTION("is signaled again after it is reset and the channel is drained") {
+		auto ev = event_fd::watch_recv(chan);
+		REQUIRE(chan.try_send(1));
+
+		ev.reset();
+		REQUIRE(!is_readable(ev.fd()));
+
+		int v = 0;
+		REQUIRE(chan.try_recv(v));
+		REQUIRE(!chan.try_recv(v));
+
+		REQUIRE(chan.try_send(2));
+		REQUIRE(is_readable(ev.fd()));
+	}
+
+	SECTION("is readable on creation if the channel is ready") {
+		REQUIRE(chan.try_send(1));
+
+		auto ev = event_fd::watch_recv(chan);
+		REQUIRE(is_readable(ev.fd()));
+	}
+
+	SECTION("becomes readable when the channel is closed") {
+		auto ev = event_fd::watch_recv(chan);
+		REQUIRE(!is_readable(ev.fd()));
+
+		chan.close();
+		REQUIRE(is_readable(ev.fd()));
+	}
+
+	SECTION("becomes readable when a bounded channel has room") {
+		auto ev = event_fd::watch_send(chan);
+		REQUIRE(is_readable(ev.fd()));
+
+		for(int i = 0; i < 4; ++i) {
+			REQUIRE(chan.try_send(i));
+		}
+
+		ev.reset();
+		REQUIRE(!is_readable(ev.fd()));
+		REQUIRE(!chan.try_send(4));
+
+		int v = 0;
+		REQUIRE(chan.try_recv(v));
+		REQUIRE(is_readable(ev.fd()));
+	}
+
+	SECTION("epoll loop receives every value") {
+		constexpr int N = 10'000;
+
+		auto ev = event_fd::watch_recv(chan);
+
+		int const epfd = ::epoll_create1(EPOLL_CLOEXEC);
+		REQUIRE(epfd >= 0);
+
+		epoll_event event{.events = EPOLLIN | EPOLLET, .data = {.fd = ev.fd()}};
+		REQUIRE(0 == ::epoll_ctl(epfd, EPOLL_CTL_ADD, ev.fd(), &event));
+
+		auto sender = std::jthread([&] {
+			for(int i = 1; i <= N; ++i) {
+				chan.send(i);
+			}
+		});
+
+		std::int64_t sum   = 0;
+		int          count = 0;
+		while(count < N) {
+			epoll_event e;
+			if(::epoll_wait(epfd, &e, 1, -1) != 1) {
+				continue;
+			}
+
+			ev.reset();
+
+			int v = 0;
+			while(chan.try_recv(v)) {
+				sum += v;
+				++count;
+			}
+		}
+
+		::close(epfd);
+		REQUIRE(std::int64_t(N) * (N + 1) / 2 == sum);
+	}
+}
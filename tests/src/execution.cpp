@@ -0,0 +1,247 @@
+#include <chrono>
+#include <future>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/error.hpp>
+#include <lesomnus/channel/execution.hpp>
+#include <lesomnus/channel/executor.hpp>
+#include <lesomnus/channel/select.hpp>
+
+#include "testing/constants.hpp"
+
+namespace {
+
+using namespace lesomnus::channel;
+
+struct env {
+	std::stop_token token;
+	executor*       ex = nullptr;
+
+	std::stop_token query(execution::get_stop_token_t) const noexcept {
+		return token;
+	}
+
+	executor& query(execution::get_scheduler_t) const noexcept {
+		return ex != nullptr ? *ex : inline_executor::instance();
+	}
+};
+
+template<typename T>
+struct result {
+	std::optional<T> value;
+	std::error_code  ec;
+	bool             is_stopped = false;
+
+	[[nodiscard]] bool is_completed() const noexcept {
+		return value.has_value() || ec || is_stopped;
+	}
+};
+
+template<typename T>
+struct recorder {
+	result<T>*      r;
+	std::stop_token token;
+	executor*       ex = nullptr;
+
+	template<typename... Args>
+	void set_value(Args&&... args) && noexcept {
+		r->value.emplace(std::forward<Args>(args)...);
+	}
+
+	void set_error(std::error_code ec) && noexcept {
+		r->ec = ec;
+	}
+
+	void set_stopped() && noexcept {
+		r->is_stopped = true;
+	}
+
+	[[nodiscard]] env get_env() const noexcept {
+		return env{token, ex};
+	}
+};
+
+struct done { };
+
+/**
+ * @brief Receiver completed on another thread; it tells whether it is completed with a value.
+ */
+struct signaler {
+	std::promise<bool>* done;
+
+	void set_value() && noexcept {
+		done->set_value(true);
+	}
+
+	void set_stopped() && noexcept {
+		done->set_value(false);
+	}
+};
+
+}  // namespace
+
+TEST_CASE("execution::async_recv") {
+	auto chan = bounded_channel<std::string, 1>();
+
+	result<std::string> r;
+
+	SECTION("completes inline if the value is ready") {
+		chan.send("foo");
+
+		auto op = execution::async_recv(chan).connect(recorder<std::string>{&r, {}});
+		op.start();
+		REQUIRE(r.value == "foo");
+	}
+
+	SECTION("completes once the value is sent") {
+		auto op = execution::async_recv(chan).connect(recorder<std::string>{&r, {}});
+		op.start();
+		REQUIRE(!r.is_completed());
+
+		chan.send("foo");
+		REQUIRE(r.value == "foo");
+	}
+
+	SECTION("completes with an error if the channel is closed") {
+		auto op = execution::async_recv(chan).connect(recorder<std::string>{&r, {}});
+		op.start();
+
+		chan.close();
+		REQUIRE(channel_errc::closed == r.ec);
+	}
+
+	SECTION("completes as stopped by the stop token of the receiver") {
+		std::stop_source stop;
+
+		auto op = execution::async_recv(chan).connect(recorder<std::string>{&r, stop.get_token()});
+		op.start();
+		REQUIRE(!r.is_completed());
+
+		stop.request_stop();
+		REQUIRE(r.is_stopped);
+
+		// The waiter is removed from the channel.
+		chan.send("foo");
+		REQUIRE(1 == chan.size());
+	}
+}
+
+TEST_CASE("execution::async_send") {
+	auto chan = bounded_channel<int, 0>();
+
+	result<done> r;
+
+	SECTION("completes once the value is received") {
+		auto op = execution::async_send(chan, 42).connect(recorder<done>{&r, {}});
+		op.start();
+		REQUIRE(!r.is_completed());
+
+		int v = 0;
+		REQUIRE(chan.recv(v));
+		REQUIRE(42 == v);
+		REQUIRE(r.value.has_value());
+	}
+
+	SECTION("completes on the thread of the receiving peer") {
+		std::thread::id completed_on;
+
+		struct on_thread {
+			std::thread::id* id;
+
+			void set_value() && noexcept {
+				*id = std::this_thread::get_id();
+			}
+
+			void set_error(std::error_code) && noexcept { }
+
+			void set_stopped() && noexcept { }
+		};
+
+		auto op = execution::async_send(chan, 42).connect(on_thread{&completed_on});
+		op.start();
+
+		std::thread::id receiver_id;
+		std::jthread([&] {
+			receiver_id = std::this_thread::get_id();
+
+			int v = 0;
+			chan.recv(v);
+		}).join();
+
+		REQUIRE(receiver_id == completed_on);
+	}
+}
+
+TEST_CASE("execution::when_any") {
+	auto chan1 = bounded_channel<int, 1>();
+	auto chan2 = bounded_channel<int, 1>();
+
+	result<done> r;
+
+	SECTION("completes after the callback of the completed operation") {
+		int selected = 0;
+
+		auto op = execution::when_any(
+		              recv(chan1, [&](bool, int&&) { selected = 1; }),
+		              recv(chan2, [&](bool, int&&) { selected = 2; }))
+		              .connect(recorder<done>{&r, {}});
+		op.start();
+		REQUIRE(!r.is_completed());
+
+		chan2.send(42);
+		REQUIRE(r.value.has_value());
+		REQUIRE(2 == selected);
+		REQUIRE(0 == chan1.size());
+	}
+
+	SECTION("completes by the timeout without a scheduler") {
+		bool is_expired = false;
+
+		std::promise<bool> done;
+		auto               is_done = done.get_future();
+
+		// Completed on the thread driving the timer service.
+		auto op = execution::when_any(
+		              recv(chan1),
+		              after(std::chrono::milliseconds(10), [&] { is_expired = true; }))
+		              .connect(signaler{&done});
+		op.start();
+
+		REQUIRE(std::future_status::ready == is_done.wait_for(10 * testing::ReasonableWaitingTime));
+		REQUIRE(is_done.get());
+		REQUIRE(is_expired);
+		REQUIRE(0 == chan1.size());
+	}
+
+	SECTION("completes on the scheduler of the receiver") {
+		run_loop loop;
+
+		auto op = execution::when_any(recv(chan1), recv(chan2)).connect(recorder<done>{&r, {}, &loop});
+		op.start();
+
+		chan2.send(42);
+		REQUIRE(!r.is_completed());
+
+		REQUIRE(1 == loop.poll());
+		REQUIRE(r.value.has_value());
+	}
+
+	SECTION("completes as stopped by the stop token of the receiver") {
+		std::stop_source stop;
+
+		auto op = execution::when_any(recv(chan1), recv(chan2)).connect(recorder<done>{&r, stop.get_token()});
+		op.start();
+
+		stop.request_stop();
+		REQUIRE(r.is_stopped);
+		REQUIRE(!r.value.has_value());
+	}
+}
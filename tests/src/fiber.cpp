@@ -0,0 +1,165 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <system_error>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/byte_channel.hpp>
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/error.hpp>
+#include <lesomnus/channel/fiber.hpp>
+#include <lesomnus/channel/select.hpp>
+#include <lesomnus/channel/thread_pool.hpp>
+
+TEST_CASE("stack_pool") {
+	using lesomnus::channel::detail::stack_pool;
+
+	stack_pool pool;
+
+	auto const s = pool.allocate(10'000);
+	REQUIRE(s.usable_size() >= 10'000);
+	REQUIRE(0 == s.usable_size() % stack_pool::page_size());
+
+	pool.release(s);
+	REQUIRE(s.base == pool.allocate(10'000).base);
+
+	auto const g = pool.allocate(10'000, true);
+	REQUIRE(g.guarded);
+	REQUIRE(g.usable_size() >= 10'000);
+	REQUIRE(g.bottom() != g.base);
+
+	pool.release(g);
+	REQUIRE(g.base == pool.allocate(10'000, true).base);
+}
+
+TEST_CASE("spawn_fiber") {
+	using namespace lesomnus::channel;
+
+	thread_pool pool(2);
+
+	SECTION("blocking operations suspend the fiber instead of the thread") {
+		constexpr int NumFibers = 1'000;
+
+		// Fibers outnumber the threads since a blocking send does not block the thread.
+		auto chan = bounded_channel<int, 0>();
+		for(int i = 0; i < NumFibers; ++i) {
+			spawn_fiber(pool, [&chan, i] { chan.send(i); });
+		}
+
+		auto done = bounded_channel<int, 0>();
+		spawn_fiber(pool, [&] {
+			int sum = 0;
+			int v   = 0;
+			for(int i = 0; i < NumFibers; ++i) {
+				chan.recv(v);
+				sum += v;
+			}
+
+			done.send(sum);
+		});
+
+		int sum = 0;
+		REQUIRE(done.recv(sum));
+		REQUIRE(NumFibers * (NumFibers - 1) / 2 == sum);
+	}
+
+	SECTION("timed operation times out in the fiber") {
+		auto chan = bounded_channel<int, 0>();
+		auto done = bounded_channel<std::error_code, 1>();
+		spawn_fiber(pool, [&] {
+			int             v = 0;
+			std::error_code ec;
+			chan.recv_for(std::chrono::milliseconds(10), v, ec);
+			done.send(ec);
+		});
+
+		std::error_code ec;
+		REQUIRE(done.recv(ec));
+		REQUIRE(channel_errc::timeout == ec);
+	}
+
+	SECTION("byte_channel suspends the fiber") {
+		thread_pool single(1);
+
+		// The reader and the writer take turns on one thread since the ring is smaller than the stream.
+		auto pipe = byte_channel(4);
+		auto done = bounded_channel<std::size_t, 1>();
+		spawn_fiber(single, [&] {
+			std::array<std::byte, 64> received{};
+			done.send(pipe.read(received) ? received.size() : 0);
+		});
+		spawn_fiber(single, [&] {
+			std::array<std::byte, 64> data{};
+			pipe.write(data);
+		});
+
+		std::size_t n = 0;
+		REQUIRE(done.recv(n));
+		REQUIRE(64 == n);
+	}
+
+	SECTION("select suspends the fiber") {
+		auto chan1 = bounded_channel<int, 0>();
+		auto chan2 = bounded_channel<int, 0>();
+		auto done  = bounded_channel<int, 1>();
+		spawn_fiber(pool, [&] {
+			int selected = 0;
+			select(
+			    recv(chan1, [&](bool, int&&) { selected = 1; }),
+			    recv(chan2, [&](bool, int&&) { selected = 2; }));
+			done.send(selected);
+		});
+
+		spawn_fiber(pool, [&] { chan2.send(42); });
+
+		int selected = 0;
+		REQUIRE(done.recv(selected));
+		REQUIRE(2 == selected);
+	}
+
+	SECTION("fibers outnumber the memory mappings of a guard page per stack") {
+		// Two mappings per stack would fail at about 32k fibers under the default `vm.max_map_count` of 65530.
+		constexpr int NumFibers = 50'000;
+
+		auto chan = bounded_channel<int, 0>();
+		for(int i = 0; i < NumFibers; ++i) {
+			spawn_fiber(pool, [&chan] {
+				int v = 0;
+				chan.recv(v);
+			});
+		}
+
+		// All the stacks are allocated by now, and no fiber finishes until a value is sent.
+		for(int i = 0; i < NumFibers; ++i) {
+			chan.send(i);
+		}
+	}
+
+	SECTION("fibers spawned by a fiber run on the same executor") {
+		std::atomic<int> count = 0;
+
+		auto done = bounded_channel<int, 0>();
+		spawn_fiber(pool, [&] {
+			auto inner = bounded_channel<int, 0>();
+			for(int i = 0; i < 10; ++i) {
+				spawn_fiber([&] {
+					++count;
+					inner.send(0);
+				});
+			}
+
+			int v = 0;
+			for(int i = 0; i < 10; ++i) {
+				inner.recv(v);
+			}
+
+			done.send(0);
+		});
+
+		int v = 0;
+		REQUIRE(done.recv(v));
+		REQUIRE(10 == count);
+	}
+}
@@ -0,0 +1,253 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/error.hpp>
+#include <lesomnus/channel/ipc_channel.hpp>
+
+#include "testing/constants.hpp"
+
+namespace {
+
+struct record {
+	std::uint64_t seq;
+	double        value;
+};
+
+/**
+ * @return Whether \p pred holds before \ref testing::ReasonableWaitingTime passes.
+ */
+template<typename F>
+bool eventually(F&& pred) {
+	auto const deadline = std::chrono::steady_clock::now() + testing::ReasonableWaitingTime;
+	while(!pred()) {
+		if(std::chrono::steady_clock::now() > deadline) {
+			return false;
+		}
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+std::size_t count_open_files(std::filesystem::path const& target) {
+	std::size_t n = 0;
+	for(auto const& entry: std::filesystem::directory_iterator("/proc/self/fd")) {
+		std::error_code ec;
+		if(std::filesystem::read_symlink(entry.path(), ec) == target) {
+			++n;
+		}
+	}
+
+	return n;
+}
+
+std::size_t count_mappings(std::filesystem::path const& target) {
+	std::size_t n = 0;
+
+	std::ifstream maps("/proc/self/maps");
+	for(std::string line; std::getline(maps, line);) {
+		if(line.ends_with(target.string())) {
+			++n;
+		}
+	}
+
+	return n;
+}
+
+}  // namespace
+
+TEST_CASE("ipc_channel") {
+	using namespace lesomnus::channel;
+
+	SECTION("values are received in order from another process") {
+		constexpr std::uint64_t N = 100'000;
+
+		auto chan = ipc_channel<record, 64>::create_anonymous();
+
+		pid_t const pid = ::fork();
+		REQUIRE(pid >= 0);
+		if(pid == 0) {
+			for(std::uint64_t i = 0; i < N; ++i) {
+				if(!chan.send(record{i, i * 0.5})) {
+					::_exit(1);
+				}
+			}
+			::_exit(0);
+		}
+
+		bool ok = true;
+
+		record r{};
+		for(std::uint64_t i = 0; i < N && ok; ++i) {
+			ok = chan.recv(r) && r.seq == i && r.value == i * 0.5;
+		}
+		REQUIRE(ok);
+
+		int status = 0;
+		REQUIRE(pid == ::waitpid(pid, &status, 0));
+		REQUIRE(WIFEXITED(status));
+		REQUIRE(0 == WEXITSTATUS(status));
+	}
+
+	SECTION("named segment is opened by its name") {
+		auto const name = "/lesomnus-channel-test-" + std::to_string(::getpid());
+
+		using chan_t = ipc_channel<int, 4>;
+
+		auto a = chan_t::create(name);
+		auto b = chan_t::open(name);
+		chan_t::unlink(name);
+
+		REQUIRE(a.try_send(42));
+		REQUIRE(1 == b.size());
+
+		int v = 0;
+		REQUIRE(b.try_recv(v));
+		REQUIRE(42 == v);
+
+		// The segment of a different type is rejected.
+		auto c = ipc_channel<int, 8>::create(name);
+		REQUIRE_THROWS_AS(chan_t::open(name), std::system_error);
+		ipc_channel<int, 8>::unlink(name);
+
+		// So is the segment of a different type of the same size.
+		auto d = ipc_channel<float, 4>::create(name);
+		REQUIRE_THROWS_AS(chan_t::open(name), std::system_error);
+		ipc_channel<float, 4>::unlink(name);
+
+		REQUIRE_THROWS_AS(chan_t::open(name), std::system_error);
+	}
+
+	SECTION("open waits for the segment being created") {
+		auto const name = "/lesomnus-channel-test-" + std::to_string(::getpid());
+
+		using chan_t  = ipc_channel<int, 4>;
+		using segment = detail::ipc_segment<int, 4>;
+
+		// Steps of create that the opener may run between.
+		int const fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		REQUIRE(fd >= 0);
+
+		auto const target = std::filesystem::read_symlink("/proc/self/fd/" + std::to_string(fd));
+
+		std::atomic_bool ok = false;
+
+		auto opener = std::jthread([&] {
+			try {
+				auto chan = chan_t::open(name);
+				ok        = chan.try_send(42);
+			} catch(std::system_error const&) {
+			}
+		});
+
+		// The opener has the segment open and waits for its size.
+		REQUIRE(eventually([&] { return 2 == count_open_files(target); }));
+		REQUIRE(0 == ::ftruncate(fd, sizeof(segment)));
+		void* const p = ::mmap(nullptr, sizeof(segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		REQUIRE(MAP_FAILED != p);
+
+		// The opener has the segment mapped and waits for it to be initialized.
+		REQUIRE(eventually([&] { return 2 == count_mappings(target); }));
+		auto* const seg = ::new(p) segment();
+
+		opener.join();
+		chan_t::unlink(name);
+		REQUIRE(ok);
+		REQUIRE(1 == seg->tail.load());
+
+		::munmap(p, sizeof(segment));
+		::close(fd);
+	}
+
+	SECTION("open gives up on a segment that is never initialized") {
+		auto const name = "/lesomnus-channel-test-" + std::to_string(::getpid());
+
+		int const fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		REQUIRE(fd >= 0);
+
+		int err = 0;
+		try {
+			ipc_channel<int, 4>::open(name);
+		} catch(std::system_error const& e) {
+			err = e.code().value();
+		}
+		ipc_channel<int, 4>::unlink(name);
+		::close(fd);
+
+		REQUIRE(ETIMEDOUT == err);
+	}
+
+	SECTION("send fails without waiting if the ring is full") {
+		auto chan = ipc_channel<int, 2>::create_anonymous();
+		REQUIRE(chan.try_send(1));
+		REQUIRE(chan.try_send(2));
+
+		std::error_code ec;
+		chan.try_send(3, ec);
+		REQUIRE(channel_errc::exhausted == ec);
+
+		chan.send_for(std::chrono::milliseconds(10), 3, ec);
+		REQUIRE(channel_errc::timeout == ec);
+	}
+
+	SECTION("recv times out") {
+		auto chan = ipc_channel<int, 2>::create_anonymous();
+
+		std::error_code ec;
+
+		int v = 0;
+		chan.recv_for(std::chrono::milliseconds(10), v, ec);
+		REQUIRE(channel_errc::timeout == ec);
+	}
+
+	SECTION("closing it releases the waiting receivers") {
+		auto chan = ipc_channel<int, 2>::create_anonymous();
+
+		std::error_code ec;
+		auto            receiver = std::jthread([&] {
+			int v = 0;
+			chan.recv(std::stop_token{}, v, ec);
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		chan.close();
+		receiver.join();
+
+		REQUIRE(channel_errc::closed == ec);
+		REQUIRE(!chan.try_send(1));
+	}
+
+	SECTION("waiting is canceled by the token") {
+		auto chan = ipc_channel<int, 2>::create_anonymous();
+
+		std::stop_source stop;
+		std::error_code  ec;
+
+		auto receiver = std::jthread([&] {
+			int v = 0;
+			chan.recv(stop.get_token(), v, ec);
+		});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		stop.request_stop();
+		receiver.join();
+
+		REQUIRE(channel_errc::canceled == ec);
+	}
+}
@@ -0,0 +1,94 @@
+#include <array>
+#include <cstdint>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/error.hpp>
+#include <lesomnus/channel/merge.hpp>
+
+TEST_CASE("merge") {
+	using namespace lesomnus::channel;
+
+	SECTION("forwards all the values until the inputs are closed") {
+		constexpr int NumInputs = 64;
+		constexpr int N         = 1'000;
+
+		std::vector<bounded_channel<int, 0>> inputs(NumInputs);
+		unbounded_channel<int>               output;
+
+		std::vector<std::jthread> producers;
+		for(auto& chan: inputs) {
+			producers.emplace_back([&chan] {
+				for(int i = 1; i <= N; ++i) {
+					chan.send(i);
+				}
+
+				// Closed after the last value is taken since the channel has no buffer.
+				chan.close();
+			});
+		}
+
+		std::vector<receiver<int>*> ptrs;
+		for(auto& chan: inputs) {
+			ptrs.push_back(&chan);
+		}
+
+		REQUIRE(merge(ptrs, output));
+		REQUIRE(NumInputs * N == output.size());
+
+		std::int64_t sum = 0;
+
+		int v = 0;
+		while(output.try_recv(v)) {
+			sum += v;
+		}
+		REQUIRE(std::int64_t(NumInputs) * N * (N + 1) / 2 == sum);
+	}
+
+	SECTION("keeps the order of the values from an input") {
+		bounded_channel<int, 4> input;
+		bounded_channel<int, 2> output;
+
+		auto const producer = std::jthread([&] {
+			for(int i = 0; i < 100; ++i) {
+				input.send(i);
+			}
+
+			// Closing discards the buffered values, so it waits until the merger takes them.
+			while(input.size() > 0) {
+				std::this_thread::yield();
+			}
+			input.close();
+		});
+		auto const merger = std::jthread([&] {
+			merge(std::array<receiver<int>*, 1>{&input}, output);
+		});
+
+		int v = 0;
+		for(int i = 0; i < 100; ++i) {
+			REQUIRE(output.recv(v));
+			REQUIRE(i == v);
+		}
+	}
+
+	SECTION("fails if it is canceled") {
+		bounded_channel<int, 0> input;
+		bounded_channel<int, 0> output;
+
+		std::stop_source stop;
+		std::error_code  ec;
+
+		auto merger = std::jthread([&] {
+			merge(stop.get_token(), std::array<receiver<int>*, 1>{&input}, output, ec);
+		});
+
+		stop.request_stop();
+		merger.join();
+		REQUIRE(channel_errc::canceled == ec);
+	}
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/error.hpp>
+#include <lesomnus/channel/mirrored_ring.hpp>
+
+TEST_CASE("mirrored_ring") {
+	using namespace lesomnus::channel;
+
+	SECTION("the second view aliases the first one") {
+		auto ring = mirrored_ring(1);
+		REQUIRE(mirrored_ring::page_size() == ring.size());
+
+		ring.data()[0] = std::byte{42};
+		REQUIRE(std::byte{42} == ring.data()[ring.size()]);
+
+		ring.data()[2 * ring.size() - 1] = std::byte{43};
+		REQUIRE(std::byte{43} == ring.data()[ring.size() - 1]);
+	}
+
+	SECTION("size is a multiple of the unit") {
+		auto const ring = mirrored_ring(1, 24);
+		REQUIRE(0 == ring.size() % 24);
+		REQUIRE(0 == ring.size() % mirrored_ring::page_size());
+	}
+
+	SECTION("it can be moved") {
+		auto a = mirrored_ring(1);
+		auto b = std::move(a);
+		REQUIRE(nullptr == a.data());
+		REQUIRE(nullptr != b.data());
+	}
+}
+
+TEST_CASE("mirrored_byte_channel") {
+	using namespace lesomnus::channel;
+
+	auto chan = mirrored_byte_channel(1);
+
+	auto const n = chan.capacity();
+	REQUIRE(mirrored_ring::page_size() == n);
+
+	std::vector<std::byte> data(n);
+	for(std::size_t i = 0; i < n; ++i) {
+		data[i] = static_cast<std::byte>(i % 251);
+	}
+
+	std::error_code ec;
+
+	// Moves the front near the end of the ring.
+	REQUIRE(n - 3 == chan.try_write(std::span(data).first(n - 3), ec));
+	std::vector<std::byte> skipped(n - 3);
+	REQUIRE(n - 3 == chan.try_read(skipped, ec));
+
+	SECTION("regions do not wrap around") {
+		auto const w = chan.write_region({}, ec);
+		REQUIRE(n == w.size());
+		std::copy(data.begin(), data.begin() + 10, w.begin());
+		chan.commit(10);
+
+		auto const r = chan.read_region({}, ec);
+		REQUIRE(10 == r.size());
+		REQUIRE(std::equal(r.begin(), r.end(), data.begin()));
+		chan.consume(10);
+	}
+
+	SECTION("copies across the end of the ring at once") {
+		REQUIRE(10 == chan.try_write(std::span(data).first(10), ec));
+
+		std::vector<std::byte> received(10);
+		REQUIRE(10 == chan.try_read(received, ec));
+		REQUIRE(std::equal(received.begin(), received.end(), data.begin()));
+	}
+}
+
+TEST_CASE("mirrored_channel") {
+	using namespace lesomnus::channel;
+
+	struct point {
+		std::int32_t x;
+		std::int32_t y;
+		std::int32_t z;
+	};
+
+	constexpr int N = 10'000;
+
+	mirrored_channel<point, 100> chan;
+
+	auto sender = std::jthread([&] {
+		for(int i = 0; i < N; ++i) {
+			chan.send(point{i, -i, 2 * i});
+		}
+	});
+
+	point p{};
+	for(int i = 0; i < N; ++i) {
+		REQUIRE(chan.recv(p));
+		REQUIRE(i == p.x);
+		REQUIRE(-i == p.y);
+		REQUIRE(2 * i == p.z);
+	}
+}
+
+TEST_CASE("mirrored_channel exposes the buffered values in place") {
+	using namespace lesomnus::channel;
+
+	mirrored_channel<std::int64_t, 4> chan;
+
+	// Moves the front to the end of the ring so the values wrap around it.
+	auto const n = mirrored_ring::page_size() / sizeof(std::int64_t);
+	for(std::size_t i = 0; i < n - 1; ++i) {
+		REQUIRE(chan.try_send(0));
+		std::int64_t v = 0;
+		REQUIRE(chan.try_recv(v));
+	}
+
+	std::error_code ec;
+	REQUIRE(chan.recv_region(ec).empty());
+	REQUIRE(channel_errc::exhausted == ec);
+
+	for(std::int64_t i = 0; i < 4; ++i) {
+		REQUIRE(chan.try_send(i));
+	}
+
+	SECTION("recv_region returns all the buffered values") {
+		auto const region = chan.recv_region(ec);
+		REQUIRE(channel_errc::ok == ec);
+		REQUIRE(std::vector<std::int64_t>{0, 1, 2, 3} == std::vector<std::int64_t>(region.begin(), region.end()));
+
+		chan.consume(3);
+		REQUIRE(1 == chan.size());
+
+		auto const rest = chan.recv_region(ec);
+		REQUIRE(1 == rest.size());
+		REQUIRE(3 == rest[0]);
+	}
+
+	SECTION("consume lets the hanging senders in") {
+		auto sender = std::jthread([&] {
+			chan.send(4);
+			chan.send(5);
+		});
+		while(chan.size() < 5) {
+			std::this_thread::yield();
+		}
+
+		chan.consume(2);
+		sender.join();
+
+		auto const region = chan.recv_region(ec);
+		REQUIRE(std::vector<std::int64_t>{2, 3, 4, 5} == std::vector<std::int64_t>(region.begin(), region.end()));
+	}
+
+	SECTION("try_recv_many moves the values out") {
+		std::array<std::int64_t, 8> values{};
+		REQUIRE(4 == chan.try_recv_many(values, ec));
+		REQUIRE(channel_errc::exhausted == ec);
+		REQUIRE(std::array<std::int64_t, 8>{0, 1, 2, 3} == values);
+	}
+
+	SECTION("recv_region fails once the channel is closed") {
+		chan.close();
+		REQUIRE(chan.recv_region(ec).empty());
+		REQUIRE(channel_errc::closed == ec);
+	}
+}
+
+TEST_CASE("mirrored_queue") {
+	using namespace lesomnus::channel;
+
+	mirrored_queue<std::int64_t, 4> q;
+
+	// Holds as many values as the page does.
+	auto const n = mirrored_ring::page_size() / sizeof(std::int64_t);
+	for(std::size_t i = 0; i < n - 1; ++i) {
+		q.emplace(0);
+		q.pop();
+	}
+	for(std::int64_t i = 0; i < 3; ++i) {
+		q.emplace(i);
+	}
+
+	auto const values = q.values();
+	REQUIRE(3 == values.size());
+	REQUIRE(0 == values[0]);
+	REQUIRE(1 == values[1]);
+	REQUIRE(2 == values[2]);
+}
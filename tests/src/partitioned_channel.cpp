@@ -0,0 +1,148 @@
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/error.hpp>
+#include <lesomnus/channel/partitioned_channel.hpp>
+
+namespace {
+
+struct event {
+	int key;
+	int seq;
+};
+
+struct key_of {
+	int operator()(event const& e) const noexcept {
+		return e.key;
+	}
+};
+
+struct counted_event {
+	int  key;
+	int* conversions;
+
+	operator event() const {
+		++*conversions;
+		return event{key, 0};
+	}
+};
+
+}  // namespace
+
+TEST_CASE("partitioned_channel") {
+	using namespace lesomnus::channel;
+
+	SECTION("values with the same key are sent to the same partition") {
+		auto chan = partitioned_channel<event, key_of, 8>(4);
+		REQUIRE(4 == chan.num_partitions());
+
+		REQUIRE(chan.try_send(event{1, 0}));
+		REQUIRE(chan.try_send(event{1, 1}));
+
+		auto const i = chan.partition_of(event{1, 0});
+		REQUIRE(2 == chan.partition(i).size());
+		REQUIRE(2 == chan.size());
+
+		event e;
+		REQUIRE(chan.partition(i).try_recv(e));
+		REQUIRE(0 == e.seq);
+		REQUIRE(chan.partition(i).try_recv(e));
+		REQUIRE(1 == e.seq);
+	}
+
+	SECTION("consumers receive the values of each key in order") {
+		constexpr int NumPartitions = 4;
+		constexpr int NumProducers  = 4;
+		constexpr int NumKeys       = 64;
+		constexpr int N             = 100;
+
+		auto chan = partitioned_channel<event, key_of, 16>(NumPartitions);
+
+		// Next expected sequence of each key; each key is touched only by its consumer.
+		std::vector<int>  next(NumKeys * NumProducers, 0);
+		std::vector<int>  ok(NumPartitions, 1);
+		{
+			std::vector<std::jthread> consumers;
+			for(int i = 0; i < NumPartitions; ++i) {
+				consumers.emplace_back([&, i] {
+					auto& p = chan.partition(i);
+
+					event e;
+					for(int k = 0; k < NumKeys * NumProducers * N; ++k) {
+						if(!p.recv(e)) {
+							return;
+						}
+						if(chan.partition_of(e) != static_cast<std::size_t>(i) || next[e.key] != e.seq) {
+							ok[i] = 0;
+						}
+						next[e.key] = e.seq + 1;
+					}
+				});
+			}
+
+			std::vector<std::jthread> producers;
+			for(int i = 0; i < NumProducers; ++i) {
+				producers.emplace_back([&, i] {
+					for(int seq = 0; seq < N; ++seq) {
+						for(int k = 0; k < NumKeys; ++k) {
+							chan.send(event{i * NumKeys + k, seq});
+						}
+					}
+				});
+			}
+			for(auto& p: producers) {
+				p.join();
+			}
+
+			// Waits for the consumers to drain the partitions before they are closed.
+			for(int i = 0; i < NumPartitions; ++i) {
+				while(chan.partition(i).size() > 0) {
+					std::this_thread::yield();
+				}
+			}
+			chan.close();
+		}
+
+		for(auto const v: ok) {
+			REQUIRE(v != 0);
+		}
+		for(auto const v: next) {
+			REQUIRE(N == v);
+		}
+	}
+
+	SECTION("it needs a partition") {
+		REQUIRE_THROWS_AS((partitioned_channel<int, std::identity>(0)), std::invalid_argument);
+	}
+
+	SECTION("a value of another type is converted once") {
+		auto chan = partitioned_channel<event, key_of, 8>(4);
+
+		int conversions = 0;
+		REQUIRE(chan.try_send(counted_event{1, &conversions}));
+		REQUIRE(1 == conversions);
+		REQUIRE(chan.send(counted_event{1, &conversions}));
+		REQUIRE(2 == conversions);
+		REQUIRE(2 == chan.partition(chan.partition_of(event{1, 0})).size());
+	}
+
+	SECTION("closing it closes all the partitions") {
+		auto chan = partitioned_channel<int, std::identity>(2);
+		chan.close();
+
+		std::error_code ec;
+		chan.try_send(1, ec);
+		REQUIRE(channel_errc::closed == ec);
+
+		int v = 0;
+		REQUIRE(!chan.partition(0).recv(v));
+		REQUIRE(!chan.partition(1).recv(v));
+	}
+}
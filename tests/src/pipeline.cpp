@@ -0,0 +1,189 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <semaphore>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/error.hpp>
+#include <lesomnus/channel/pipeline.hpp>
+
+TEST_CASE("pipeline") {
+	using namespace lesomnus::channel;
+
+	constexpr int N = 1'000;
+
+	SECTION("propagates the end of the source through the stages") {
+		std::atomic<std::int64_t> sum = 0;
+
+		auto p = source([i = 0]() mutable -> std::optional<int> {
+			         if(i == N) {
+				         return std::nullopt;
+			         }
+			         return ++i;
+		         })
+		       | stage([](int v) { return std::int64_t(v) * 2; }, 4)
+		       | stage<4>([](std::int64_t v) -> std::optional<std::int64_t> {
+			         if(v % 4 != 0) {
+				         return std::nullopt;
+			         }
+			         return v;
+		         },
+		                  2)
+		       | sink([&](std::int64_t v) { sum += v; }, 2);
+		p.wait();
+
+		// Sum of the multiples of 4 in [2, 2N].
+		REQUIRE(std::int64_t(4) * (N / 2) * (N / 2 + 1) / 2 == sum);
+
+		auto const stats = p.stats();
+		REQUIRE(4 == stats.size());
+		REQUIRE(N == stats[0].num_processed);
+		REQUIRE(N == stats[1].num_processed);
+		REQUIRE(N == stats[2].num_processed);
+		REQUIRE(N / 2 == stats[3].num_processed);
+		REQUIRE(4 == stats[1].num_workers);
+		REQUIRE(0 == stats[3].queue_depth);
+	}
+
+	SECTION("stage of no workers runs on one") {
+		std::atomic<int> count = 0;
+
+		auto p = source([i = 0]() mutable -> std::optional<int> {
+			         if(i == N) {
+				         return std::nullopt;
+			         }
+			         return ++i;
+		         })
+		       | stage([](int v) { return v; }, 0)
+		       | sink([&](int) { ++count; }, 0);
+		p.wait();
+
+		REQUIRE(N == count);
+
+		auto const stats = p.stats();
+		REQUIRE(1 == stats[1].num_workers);
+		REQUIRE(1 == stats[2].num_workers);
+	}
+
+	SECTION("ends once the source channel is closed") {
+		auto chan = bounded_channel<int, 0>();
+
+		std::atomic<int> count = 0;
+
+		auto p = source(chan)
+		       | stage([](int v) { return v + 1; }, 2)
+		       | sink([&](int) { ++count; });
+
+		for(int i = 0; i < N; ++i) {
+			chan.send(i);
+		}
+
+		// Every value is taken by the first stage since the channel has no buffer.
+		chan.close();
+		p.wait();
+
+		REQUIRE(N == count);
+	}
+
+	SECTION("stops the workers when it is destroyed") {
+		auto chan = bounded_channel<int, 0>();
+
+		std::atomic<int> count = 0;
+		{
+			auto p = source(chan)
+			       | stage<1>([](int v) { return v; })
+			       | sink([&](int) {
+				         ++count;
+				         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			         });
+
+			for(int i = 0; i < 10; ++i) {
+				chan.send(i);
+			}
+		}
+
+		REQUIRE(count <= 10);
+	}
+
+	SECTION("ordered stage sends the results in the order of the values") {
+		std::vector<int> received;
+
+		auto p = source([i = 0]() mutable -> std::optional<int> {
+			         if(i == N) {
+				         return std::nullopt;
+			         }
+			         return i++;
+		         })
+		       | ordered_stage([](int v) {
+			         // Later values tend to be done earlier.
+			         if(v % 7 == 0) {
+				         std::this_thread::sleep_for(std::chrono::microseconds(100));
+			         }
+			         return v;
+		         },
+		                       4, 16)
+		       | sink([&](int v) { received.push_back(v); });
+		p.wait();
+
+		REQUIRE(N == received.size());
+		for(int i = 0; i < N; ++i) {
+			REQUIRE(i == received[i]);
+		}
+	}
+
+	SECTION("slow head-of-line holds back the ordered stage") {
+		constexpr int Window = 4;
+
+		auto chan = bounded_channel<int, 0>();
+
+		std::binary_semaphore release{0};
+		std::atomic<int>      num_taken = 0;
+		std::vector<int>      received;
+		std::binary_semaphore all_received{0};
+
+		auto p = source(chan)
+		       | ordered_stage([&](int v) {
+			         ++num_taken;
+			         if(v == 0) {
+				         release.acquire();
+			         }
+			         return v;
+		         },
+		                       4, Window)
+		       | sink([&](int v) {
+			         received.push_back(v);
+			         if(v == 2 * Window - 1) {
+				         all_received.release();
+			         }
+		         });
+
+		for(int i = 0; i < Window; ++i) {
+			chan.send(i);
+		}
+
+		// The window is full while the first value is being processed.
+		std::error_code ec;
+		chan.send_for(std::chrono::milliseconds(50), Window, ec);
+		REQUIRE(channel_errc::timeout == ec);
+		REQUIRE(Window == num_taken);
+		REQUIRE(received.empty());
+
+		release.release();
+		for(int i = Window; i < 2 * Window; ++i) {
+			chan.send(i);
+		}
+
+		all_received.acquire();
+		REQUIRE(2 * Window == received.size());
+		for(int i = 0; i < 2 * Window; ++i) {
+			REQUIRE(i == received[i]);
+		}
+	}
+}
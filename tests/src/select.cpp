@@ -1,7 +1,10 @@
+#include <atomic>
 #include <chrono>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <variant>
+#include <vector>
 
 #include <catch2/catch_test_macros.hpp>
 
@@ -18,7 +21,7 @@ TEST_CASE("select") {
 			auto chan2 = unbounded_channel<std::string>();
 
 			std::string sent;
-			select(
+			biased_select(
 			    recv(chan1),
 			    send(chan2, "foo", [&sent](bool) { sent = "foo"; }),
 			    send(chan2, "bar", [&sent](bool) { sent = "bar"; }));
@@ -127,3 +130,266 @@ TEST_CASE("select") {
 		}
 	}
 }
+
+TEST_CASE("select picks one of the ready operations at random") {
+	using namespace lesomnus::channel;
+
+	constexpr int N = 3'000;
+
+	auto chan1 = bounded_channel<int, 1>();
+	auto chan2 = bounded_channel<int, 1>();
+	auto chan3 = bounded_channel<int, 1>();
+
+	int counts[3] = {};
+
+	auto const refill = [](bounded_channel<int, 1>& chan) { chan.try_send(0); };
+
+	SECTION("select") {
+		for(int i = 0; i < N; ++i) {
+			refill(chan1);
+			refill(chan2);
+			refill(chan3);
+			select(
+			    recv(chan1, [&](bool, int&&) { ++counts[0]; }),
+			    recv(chan2, [&](bool, int&&) { ++counts[1]; }),
+			    recv(chan3, [&](bool, int&&) { ++counts[2]; }));
+		}
+
+		// Each of them is expected to be selected N/3 times.
+		for(auto const count: counts) {
+			REQUIRE(N / 4 < count);
+			REQUIRE(count < N / 2);
+		}
+	}
+
+	SECTION("select is not biased toward the operation after the unready ones") {
+		auto chan4 = bounded_channel<int, 1>();
+
+		int count = 0;
+		for(int i = 0; i < N; ++i) {
+			refill(chan3);
+			refill(chan4);
+			select(
+			    recv(chan1, [&](bool, int&&) { }),
+			    recv(chan2, [&](bool, int&&) { }),
+			    recv(chan3, [&](bool, int&&) { ++count; }),
+			    recv(chan4, [&](bool, int&&) { }));
+		}
+
+		// Expected to be N/2, while choosing the first ready one from a random rotation makes it 3N/4.
+		REQUIRE(N * 2 / 5 < count);
+		REQUIRE(count < N * 3 / 5);
+	}
+
+	SECTION("biased_select") {
+		for(int i = 0; i < N; ++i) {
+			refill(chan1);
+			refill(chan2);
+			refill(chan3);
+			biased_select(
+			    recv(chan1, [&](bool, int&&) { ++counts[0]; }),
+			    recv(chan2, [&](bool, int&&) { ++counts[1]; }),
+			    recv(chan3, [&](bool, int&&) { ++counts[2]; }));
+		}
+
+		REQUIRE(N == counts[0]);
+		REQUIRE(0 == counts[1]);
+		REQUIRE(0 == counts[2]);
+	}
+}
+
+TEST_CASE("select with timeout") {
+	using namespace lesomnus::channel;
+
+	SECTION("expires if no operation is settled in time") {
+		auto chan = bounded_channel<int, 0>();
+
+		auto const t0 = std::chrono::steady_clock::now();
+
+		int  i           = 0;
+		bool is_expired  = false;
+		auto expired_tid = std::this_thread::get_id();
+		select(
+		    recv(chan, [&i](bool, int&&) { i = 1; }),
+		    after(testing::ReasonableWaitingTime, [&] {
+			    is_expired  = true;
+			    expired_tid = std::this_thread::get_id();
+		    }));
+		auto const t1 = std::chrono::steady_clock::now();
+
+		REQUIRE(testing::ReasonableWaitingTime <= (t1 - t0));
+		REQUIRE(is_expired);
+		REQUIRE(std::this_thread::get_id() == expired_tid);  // Invoked on the selecting thread.
+		REQUIRE(0 == i);
+		REQUIRE(0 == chan.size());  // It will be -1 if it is not canceled.
+	}
+
+	SECTION("does not expire if an operation is settled in time") {
+		auto chan = bounded_channel<int, 0>();
+
+		auto const sender = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			chan.send(42);
+		});
+
+		int  received   = 0;
+		bool is_expired = false;
+		select(
+		    recv(chan, [&received](bool, int&& v) { received = v; }),
+		    after(10 * testing::ReasonableWaitingTime, [&] { is_expired = true; }));
+
+		REQUIRE(42 == received);
+		REQUIRE_FALSE(is_expired);
+	}
+
+	SECTION("expires immediately if the deadline is already exceeded") {
+		auto chan = bounded_channel<int, 0>();
+
+		bool is_expired = false;
+		select(
+		    recv(chan),
+		    after(std::chrono::steady_clock::now(), [&] { is_expired = true; }));
+
+		REQUIRE(is_expired);
+	}
+}
+
+TEST_CASE("select with ticker") {
+	using namespace lesomnus::channel;
+
+	auto chan = bounded_channel<int, 0>();
+	auto t    = ticker(testing::ReasonableWaitingTime / 2);
+
+	auto const t0 = std::chrono::steady_clock::now();
+
+	int n = 0;
+	for(int i = 0; i < 3; ++i) {
+		select(
+		    recv(chan),
+		    tick(t, [&n](ticker::clock::time_point) { ++n; }));
+	}
+	auto const t1 = std::chrono::steady_clock::now();
+
+	REQUIRE(3 == n);
+	REQUIRE((testing::ReasonableWaitingTime / 2) * 3 <= (t1 - t0));
+	REQUIRE(0 == chan.size());
+}
+
+TEST_CASE("ticker takes only a positive interval") {
+	using namespace lesomnus::channel;
+
+	REQUIRE_THROWS_AS(ticker(std::chrono::milliseconds(0)), std::invalid_argument);
+	REQUIRE_THROWS_AS(ticker(std::chrono::milliseconds(-1)), std::invalid_argument);
+
+	// Saturated instead of overflowing into the past.
+	auto t = ticker(std::chrono::hours::max());
+
+	ticker::clock::time_point tp;
+	REQUIRE(!t.chan().recv_for(testing::ReasonableWaitingTime, tp));
+
+	t.reset(std::chrono::nanoseconds::max());
+	REQUIRE(!t.chan().recv_for(testing::ReasonableWaitingTime, tp));
+	t.stop();
+}
+
+TEST_CASE("select over tickers with a timeout") {
+	using namespace lesomnus::channel;
+	using namespace std::chrono_literals;
+
+	constexpr int NumSelects = 5'000;
+
+	// Ticks are sent by the driving thread while the selects arm and cancel their timeouts.
+	auto service = timer_service(10us);
+	auto driver  = std::jthread([&](std::stop_token token) { service.run(token); });
+
+	auto t1 = ticker(20us, service);
+	auto t2 = ticker(30us, service);
+
+	int n = 0;
+	for(int i = 0; i < NumSelects; ++i) {
+		select(
+		    tick(t1, [&n](ticker::clock::time_point) { ++n; }),
+		    tick(t2, [&n](ticker::clock::time_point) { ++n; }),
+		    after(1h, [] { }, service));
+	}
+
+	t1.stop();
+	t2.stop();
+	REQUIRE(NumSelects == n);
+}
+
+TEST_CASE("select under contention") {
+	using namespace lesomnus::channel;
+
+	constexpr int NumWorkers = 4;
+	constexpr int NumValues  = 10'000;
+
+	auto chan1 = bounded_channel<int, 0>();
+	auto chan2 = bounded_channel<int, 0>();
+
+	std::atomic<long long> sum      = 0;
+	std::atomic<int>       received = 0;
+	std::atomic<int>       closed   = 0;
+	{
+		std::vector<std::jthread> workers;
+		for(int w = 0; w < NumWorkers; ++w) {
+			workers.emplace_back([&] {
+				for(int i = 0; i < NumValues; ++i) {
+					select(send(chan1, i), send(chan2, i));
+				}
+			});
+			workers.emplace_back([&] {
+				for(int i = 0; i < NumValues; ++i) {
+					auto const on_recv = [&](bool ok, int&& v) {
+						if(!ok) {
+							++closed;
+							return;
+						}
+
+						sum += v;
+						++received;
+					};
+					select(recv(chan1, on_recv), recv(chan2, on_recv));
+				}
+			});
+		}
+	}
+
+	REQUIRE(0 == closed);
+	REQUIRE(NumWorkers * NumValues == received);
+	REQUIRE(NumWorkers * (static_cast<long long>(NumValues) * (NumValues - 1) / 2) == sum);
+	REQUIRE(0 == chan1.size());
+	REQUIRE(0 == chan2.size());
+}
+
+TEST_CASE("selects sharing the channels in different order") {
+	using namespace lesomnus::channel;
+
+	constexpr int NumValues = 10'000;
+
+	auto chan1 = bounded_channel<int, 0>();
+	auto chan2 = bounded_channel<int, 0>();
+
+	// Each select is the peer of the other, so they are completed only by each other.
+	std::atomic<int> exchanged = 0;
+	{
+		auto const a = std::jthread([&] {
+			for(int i = 0; i < NumValues; ++i) {
+				select(
+				    send(chan1, i, [&](bool ok) { exchanged += ok; }),
+				    recv(chan2, [&](bool ok, int&&) { exchanged += ok; }));
+			}
+		});
+		auto const b = std::jthread([&] {
+			for(int i = 0; i < NumValues; ++i) {
+				select(
+				    send(chan2, i, [&](bool ok) { exchanged += ok; }),
+				    recv(chan1, [&](bool ok, int&&) { exchanged += ok; }));
+			}
+		});
+	}
+
+	REQUIRE(2 * NumValues == exchanged);
+	REQUIRE(0 == chan1.size());
+	REQUIRE(0 == chan2.size());
+}
@@ -0,0 +1,356 @@
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/dynamic_select.hpp>
+#include <lesomnus/channel/select.hpp>
+#include <lesomnus/channel/wait_set.hpp>
+
+namespace {
+
+thread_local std::size_t num_allocations = 0;
+
+void* allocate(std::size_t size, std::size_t align) noexcept {
+	++num_allocations;
+
+	size = size == 0 ? 1 : size;
+	if(align <= alignof(std::max_align_t)) {
+		return std::malloc(size);
+	}
+
+	// The size of `aligned_alloc` must be a multiple of the alignment.
+	return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void* allocate_or_throw(std::size_t size, std::size_t align) {
+	if(void* const p = allocate(size, align)) {
+		return p;
+	}
+
+	throw std::bad_alloc();
+}
+
+// Not inlined so the compiler does not pair `free` with the `operator new` at the call site.
+[[gnu::noinline]] void deallocate(void* p) noexcept {
+	std::free(p);
+}
+
+}  // namespace
+
+// Every form is replaced so none of them is paired with a deallocation of the other allocator.
+void* operator new(std::size_t size) {
+	return allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size) {
+	return allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+	return allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+	return allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept {
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t align, std::nothrow_t const&) noexcept {
+	return allocate(size, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, std::nothrow_t const&) noexcept {
+	return allocate(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept {
+	deallocate(p);
+}
+
+void operator delete[](void* p) noexcept {
+	deallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+	deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+	deallocate(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+	deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+	deallocate(p);
+}
+
+void operator delete(void* p, std::nothrow_t const&) noexcept {
+	deallocate(p);
+}
+
+void operator delete[](void* p, std::nothrow_t const&) noexcept {
+	deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t, std::nothrow_t const&) noexcept {
+	deallocate(p);
+}
+
+void operator delete[](void* p, std::align_val_t, std::nothrow_t const&) noexcept {
+	deallocate(p);
+}
+
+TEST_CASE("select does not allocate") {
+	namespace channel = lesomnus::channel;
+
+	channel::bounded_channel<int, 1> chan1;
+	channel::bounded_channel<int, 0> chan2;
+
+	// Let the lazily initialized states be allocated.
+	chan1.send(0);
+	channel::select(channel::recv(chan1), channel::recv(chan2));
+
+	SECTION("if an operation is ready") {
+		int received = 0;
+
+		// The buffer of the channel may allocate on send.
+		std::size_t n = 0;
+		for(int i = 1; i <= 1'000; ++i) {
+			chan1.send(i);
+
+			auto const n0 = num_allocations;
+			channel::select(
+			    channel::recv(chan1, [&](bool, int&& v) { received += v; }),
+			    channel::recv(chan2, [&](bool, int&& v) { received -= v; }));
+			n += num_allocations - n0;
+		}
+
+		REQUIRE(0 == n);
+		REQUIRE(500'500 == received);
+	}
+
+	SECTION("if the operations are hanged") {
+		auto const sender = std::jthread([&] {
+			for(int i = 1; i <= 1'000; ++i) {
+				chan2.send(i);
+			}
+		});
+
+		int received = 0;
+
+		auto const n = num_allocations;
+		for(int i = 1; i <= 1'000; ++i) {
+			channel::select(
+			    channel::recv(chan1, [&](bool, int&& v) { received -= v; }),
+			    channel::recv(chan2, [&](bool, int&& v) { received += v; }));
+		}
+
+		REQUIRE(n == num_allocations);
+		REQUIRE(500'500 == received);
+	}
+}
+
+TEST_CASE("select") {
+	namespace channel = lesomnus::channel;
+
+	channel::bounded_channel<int, 1> chan1;
+	channel::bounded_channel<int, 1> chan2;
+
+	int received = 0;
+
+	auto const on_recv = [&](bool, int&& v) { received += v; };
+
+	BENCHMARK("ready-1k") {
+		for(int i = 0; i < 1'000; ++i) {
+			chan2.send(i);
+			channel::select(channel::recv(chan1, on_recv), channel::recv(chan2, on_recv));
+		}
+		return received;
+	};
+
+	BENCHMARK("ping-pong-1k") {
+		auto const sender = std::jthread([&] {
+			for(int i = 0; i < 1'000; ++i) {
+				chan2.send(i);
+			}
+		});
+
+		for(int i = 0; i < 1'000; ++i) {
+			channel::select(channel::recv(chan1, on_recv), channel::recv(chan2, on_recv));
+		}
+		return received;
+	};
+}
+
+TEST_CASE("select over saturated channels") {
+	namespace channel = lesomnus::channel;
+
+	constexpr int N = 10'000;
+
+	// Producers keep all the channels full.
+	channel::bounded_channel<int, 16> chan1;
+	channel::bounded_channel<int, 16> chan2;
+	channel::bounded_channel<int, 16> chan3;
+
+	auto const produce = [](channel::bounded_channel<int, 16>& chan) {
+		return std::jthread([&chan](std::stop_token token) {
+			for(int i = 0; chan.send(token, i); ++i) { }
+		});
+	};
+
+	std::size_t counts[3] = {};
+
+	auto const consume = [&](auto const& select) {
+		for(int i = 0; i < N; ++i) {
+			select(
+			    channel::recv(chan1, [&](bool, int&&) { ++counts[0]; }),
+			    channel::recv(chan2, [&](bool, int&&) { ++counts[1]; }),
+			    channel::recv(chan3, [&](bool, int&&) { ++counts[2]; }));
+		}
+	};
+
+	auto const p1 = produce(chan1);
+	auto const p2 = produce(chan2);
+	auto const p3 = produce(chan3);
+
+	BENCHMARK("select-10k") {
+		consume([](auto&&... ops) { channel::select(std::move(ops)...); });
+	};
+
+	BENCHMARK("biased_select-10k") {
+		consume([](auto&&... ops) { channel::biased_select(std::move(ops)...); });
+	};
+
+	counts[0] = counts[1] = counts[2] = 0;
+	consume([](auto&&... ops) { channel::select(std::move(ops)...); });
+
+	// Every channel is served at a third of the rate.
+	for(auto const count: counts) {
+		REQUIRE(N / 4 < count);
+	}
+
+	chan1.close();
+	chan2.close();
+	chan3.close();
+}
+
+TEST_CASE("dynamic_select") {
+	namespace channel = lesomnus::channel;
+
+	auto const bench = [](std::size_t n) {
+		std::vector<std::unique_ptr<channel::bounded_channel<int, 1>>> chans;
+		std::vector<channel::recv_case<int>>                           cases;
+		chans.reserve(n);
+		cases.reserve(n);
+		for(std::size_t i = 0; i < n; ++i) {
+			chans.emplace_back(std::make_unique<channel::bounded_channel<int, 1>>());
+			cases.emplace_back(*chans.back());
+		}
+
+		auto* const last = chans.back().get();
+		return [last, chans = std::move(chans), cases = std::move(cases)]() mutable {
+			// Only one of them is ready, so the cases are polled until it is found.
+			last->send(42);
+			return channel::dynamic_select(cases);
+		};
+	};
+
+	BENCHMARK_ADVANCED("ready-1k")(Catch::Benchmark::Chronometer meter) {
+		auto f = bench(1'000);
+		meter.measure([&] { return f(); });
+	};
+
+	BENCHMARK_ADVANCED("ready-10k")(Catch::Benchmark::Chronometer meter) {
+		auto f = bench(10'000);
+		meter.measure([&] { return f(); });
+	};
+
+	BENCHMARK_ADVANCED("hanged-1k")(Catch::Benchmark::Chronometer meter) {
+		std::vector<std::unique_ptr<channel::bounded_channel<int, 0>>> chans;
+		std::vector<channel::recv_case<int>>                           cases;
+		for(std::size_t i = 0; i < 1'000; ++i) {
+			chans.emplace_back(std::make_unique<channel::bounded_channel<int, 0>>());
+			cases.emplace_back(*chans.back());
+		}
+
+		auto const sender = std::jthread([&](std::stop_token token) {
+			while(chans.back()->send(token, 42)) { }
+		});
+
+		meter.measure([&] { return channel::dynamic_select(cases); });
+	};
+}
+
+TEST_CASE("wait_set") {
+	namespace channel = lesomnus::channel;
+
+	constexpr std::size_t NumChans = 32;
+
+	std::array<channel::bounded_channel<int, 1>, NumChans> chans;
+
+	channel::wait_set set;
+	for(auto& chan: chans) {
+		set.watch_recv(chan);
+	}
+
+	std::array<channel::wait_set::key_type, NumChans> keys;
+
+	BENCHMARK("wait-1k") {
+		int received = 0;
+		for(int i = 0; i < 1'000; ++i) {
+			chans[i % NumChans].send(i);
+
+			auto const n = set.wait(keys);
+			for(std::size_t j = 0; j < n; ++j) {
+				int v = 0;
+				if(chans[keys[j]].try_recv(v)) {
+					received += v;
+				}
+			}
+		}
+		return received;
+	};
+
+	// Same loop by re-registering on every channel.
+	std::vector<channel::recv_case<int>> cases;
+	for(auto& chan: chans) {
+		cases.emplace_back(chan);
+	}
+
+	BENCHMARK("dynamic_select-1k") {
+		int received = 0;
+		for(int i = 0; i < 1'000; ++i) {
+			chans[i % NumChans].send(i);
+
+			auto const j = channel::dynamic_select(cases);
+			received += cases[j].value();
+		}
+		return received;
+	};
+}
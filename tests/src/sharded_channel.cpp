@@ -0,0 +1,171 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/error.hpp>
+#include <lesomnus/channel/select.hpp>
+#include <lesomnus/channel/sharded_channel.hpp>
+#include <lesomnus/channel/wait_set.hpp>
+
+#include "testing/constants.hpp"
+
+TEST_CASE("sharded_channel") {
+	using namespace lesomnus::channel;
+
+	auto chan = sharded_channel<int>(4);
+	REQUIRE(4 == chan.num_shards());
+
+	SECTION("it needs a shard") {
+		REQUIRE_THROWS_AS(sharded_channel<int>(0), std::invalid_argument);
+	}
+
+	SECTION("values sent by a thread are received in order by the thread") {
+		for(int i = 0; i < 10; ++i) {
+			REQUIRE(chan.try_send(i));
+		}
+		REQUIRE(10 == chan.size());
+
+		int v = 0;
+		for(int i = 0; i < 10; ++i) {
+			REQUIRE(chan.try_recv(v));
+			REQUIRE(i == v);
+		}
+		REQUIRE(!chan.try_recv(v));
+	}
+
+	SECTION("receivers steal from the other shards") {
+		std::jthread([&] {
+			chan.send(42);
+		}).join();
+
+		int v = 0;
+		REQUIRE(chan.try_recv(v));
+		REQUIRE(42 == v);
+	}
+
+	SECTION("hanging receiver is woken up by a sender") {
+		auto sender = std::jthread([&] {
+			while(chan.size() != -1) {
+				std::this_thread::yield();
+			}
+			chan.send(42);
+		});
+
+		int v = 0;
+		REQUIRE(chan.recv(v));
+		REQUIRE(42 == v);
+		REQUIRE(0 == chan.size());
+	}
+
+	SECTION("recv times out") {
+		std::error_code ec;
+
+		int v = 0;
+		chan.recv_for(testing::ReasonableWaitingTime, v, ec);
+		REQUIRE(channel_errc::timeout == ec);
+
+		// The waiter is removed, so the sender takes the fast path again.
+		REQUIRE(chan.try_send(1));
+		REQUIRE(chan.try_recv(v));
+		REQUIRE(1 == v);
+	}
+
+	SECTION("closing it releases the receivers and discards the values") {
+		bool ok       = true;
+		auto receiver = std::jthread([&] {
+			int v = 0;
+			ok    = chan.recv(v);
+		});
+
+		while(chan.size() != -1) {
+			std::this_thread::yield();
+		}
+		chan.close();
+		receiver.join();
+		REQUIRE(!ok);
+
+		REQUIRE(!chan.try_send(1));
+
+		int v = 0;
+		REQUIRE(!chan.try_recv(v));
+	}
+
+	SECTION("select receives from it") {
+		auto other = sharded_channel<int>(2);
+
+		auto sender = std::jthread([&] {
+			while(other.size() != -1) {
+				std::this_thread::yield();
+			}
+			other.send(42);
+		});
+
+		int v = 0;
+		select(
+		    recv(chan, [&](bool, int&&) { v = -1; }),
+		    recv(other, [&](bool ok, int&& x) {
+			    REQUIRE(ok);
+			    v = x;
+		    }));
+		REQUIRE(42 == v);
+	}
+
+	SECTION("wait_set is notified by the senders") {
+		wait_set ws;
+		ws.watch_recv(chan);
+
+		auto sender = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			chan.send(42);
+		});
+
+		std::array<wait_set::key_type, 1> keys;
+		REQUIRE(1 == ws.wait(keys));
+
+		int v = 0;
+		REQUIRE(chan.try_recv(v));
+		REQUIRE(42 == v);
+	}
+
+	SECTION("every value is received once by the receivers") {
+		constexpr int NumProducers = 4;
+		constexpr int NumConsumers = 4;
+		constexpr int N            = 10'000;
+
+		std::atomic<std::int64_t> sum   = 0;
+		std::atomic<int>          count = 0;
+		{
+			std::vector<std::jthread> consumers;
+			for(int i = 0; i < NumConsumers; ++i) {
+				consumers.emplace_back([&] {
+					int v = 0;
+					while(chan.recv(v)) {
+						sum += v;
+						if(++count == NumProducers * N) {
+							chan.close();
+						}
+					}
+				});
+			}
+
+			std::vector<std::jthread> producers;
+			for(int i = 0; i < NumProducers; ++i) {
+				producers.emplace_back([&] {
+					for(int v = 1; v <= N; ++v) {
+						chan.send(v);
+					}
+				});
+			}
+		}
+
+		REQUIRE(NumProducers * N == count);
+		REQUIRE(std::int64_t(NumProducers) * N * (N + 1) / 2 == sum);
+	}
+}
@@ -0,0 +1,145 @@
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/detail/work_deque.hpp>
+#include <lesomnus/channel/thread_pool.hpp>
+
+namespace {
+
+struct counting_work final: lesomnus::channel::detail::work {
+	std::atomic<int>* count = nullptr;
+
+	void run() override {
+		++*count;
+	}
+};
+
+}  // namespace
+
+TEST_CASE("work_deque") {
+	using lesomnus::channel::detail::work_deque;
+
+	std::atomic<int>           count = 0;
+	std::vector<counting_work> works(1'000);
+	for(auto& w: works) {
+		w.count = &count;
+	}
+
+	SECTION("pops in LIFO order and steals in FIFO order") {
+		work_deque deque(4);
+		for(auto& w: works) {
+			deque.push(w);
+		}
+
+		REQUIRE(works.size() == deque.size());
+		REQUIRE(&works.back() == deque.pop());
+		REQUIRE(&works.front() == deque.steal());
+		REQUIRE(works.size() - 2 == deque.size());
+	}
+
+	SECTION("each work is taken once under contention") {
+		work_deque deque(4);
+
+		std::atomic<bool> is_done = false;
+		{
+			std::vector<std::jthread> thieves;
+			for(int i = 0; i < 3; ++i) {
+				thieves.emplace_back([&] {
+					while(!is_done) {
+						if(auto* const w = deque.steal()) {
+							w->run();
+						}
+					}
+				});
+			}
+
+			for(auto& w: works) {
+				deque.push(w);
+				if(auto* const w = deque.pop()) {
+					w->run();
+				}
+				deque.push(w);
+			}
+			while(auto* const w = deque.pop()) {
+				w->run();
+			}
+			while(deque.size() > 0) {
+				std::this_thread::yield();
+			}
+
+			is_done = true;
+		}
+
+		// Each work is pushed twice.
+		REQUIRE(2 * static_cast<int>(works.size()) == count);
+	}
+}
+
+TEST_CASE("thread_pool") {
+	using namespace lesomnus::channel;
+
+	SECTION("runs the posted functions") {
+		std::atomic<int> count = 0;
+		{
+			thread_pool pool(4);
+			for(int i = 0; i < 10'000; ++i) {
+				pool.post([&] { ++count; });
+			}
+		}
+
+		REQUIRE(10'000 == count);
+	}
+
+	SECTION("runs the works posted by the works") {
+		std::atomic<int> count = 0;
+		{
+			thread_pool pool(4);
+			for(int i = 0; i < 100; ++i) {
+				go(pool, [&] {
+					for(int j = 0; j < 100; ++j) {
+						go([&] { ++count; });
+					}
+				});
+			}
+		}
+
+		REQUIRE(10'000 == count);
+	}
+}
+
+TEST_CASE("go") {
+	using namespace lesomnus::channel;
+
+	constexpr int NumRoutines = 10'000;
+
+	thread_pool pool(4);
+
+	// Routines outnumber the threads since waiting on a channel does not block the thread.
+	auto chan = bounded_channel<int, 0>();
+	auto done = bounded_channel<int, 0>();
+	for(int i = 0; i < NumRoutines; ++i) {
+		go(pool, [&chan, i]() -> routine {
+			co_await chan.async_send(i);
+		});
+	}
+
+	go(pool, [&, sum = 0]() mutable -> routine {
+		int v = 0;
+		for(int i = 0; i < NumRoutines; ++i) {
+			co_await chan.async_recv(v);
+			sum += v;
+		}
+
+		co_await done.async_send(sum);
+	});
+
+	int sum = 0;
+	REQUIRE(done.recv(sum));
+	REQUIRE(NumRoutines * (NumRoutines - 1) / 2 == sum);
+}
@@ -0,0 +1,174 @@
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/timer.hpp>
+
+#include "testing/constants.hpp"
+
+TEST_CASE("timer_service") {
+	using namespace std::chrono_literals;
+	using lesomnus::channel::timer;
+	using lesomnus::channel::timer_service;
+
+	timer_service service(1ms);
+
+	auto const t0 = timer_service::clock::now();
+
+	SECTION("fires timers in order of the deadline") {
+		std::vector<int> fired;
+
+		timer t1([&] { fired.push_back(1); });
+		timer t2([&] { fired.push_back(2); });
+		timer t3([&] { fired.push_back(3); });
+
+		service.arm(t3, t0 + 300ms);
+		service.arm(t1, t0 + 10ms);
+		service.arm(t2, t0 + 70ms);
+		REQUIRE(3 == service.size());
+
+		REQUIRE(0 == service.advance(t0 + 5ms));
+		REQUIRE(1 == service.advance(t0 + 11ms));
+		REQUIRE(1 == service.advance(t0 + 200ms));
+		REQUIRE(1 == service.advance(t0 + 301ms));
+		REQUIRE(0 == service.size());
+
+		REQUIRE(std::vector<int>{1, 2, 3} == fired);
+	}
+
+	SECTION("never fires before the deadline") {
+		int  n = 0;
+		auto t = timer([&] { ++n; });
+
+		service.arm(t, t0 + 5000ms);
+		REQUIRE(service.next_expiry() <= t0 + 5001ms);
+
+		service.advance(t0 + 4998ms);
+		REQUIRE(0 == n);
+
+		service.advance(t0 + 5001ms);
+		REQUIRE(1 == n);
+	}
+
+	SECTION("fires timers far beyond the wheel") {
+		int  n = 0;
+		auto t = timer([&] { ++n; });
+
+		service.arm(t, t0 + 24h * 365 * 3);
+		service.advance(t0 + 24h * 365 * 3 - 1s);
+		REQUIRE(0 == n);
+
+		service.advance(t0 + 24h * 365 * 3 + 1s);
+		REQUIRE(1 == n);
+	}
+
+	SECTION("canceled timer is not fired") {
+		int  n = 0;
+		auto t = timer([&] { ++n; });
+
+		service.arm(t, t0 + 10ms);
+		REQUIRE(t.cancel());
+		REQUIRE_FALSE(t.cancel());
+		REQUIRE(0 == service.size());
+
+		service.advance(t0 + 20ms);
+		REQUIRE(0 == n);
+	}
+
+	SECTION("timer is canceled when destroyed") {
+		int n = 0;
+		{
+			auto t = timer([&] { ++n; });
+			service.arm(t, t0 + 10ms);
+		}
+		REQUIRE(0 == service.size());
+
+		service.advance(t0 + 20ms);
+		REQUIRE(0 == n);
+	}
+
+	SECTION("callback may arm and cancel the timers of the service") {
+		int n = 0;
+		int m = 0;
+
+		auto other = timer([&] { ++m; });
+
+		// Periodic timer that stops itself.
+		timer<std::function<void()>> self([&] {
+			++n;
+			service.arm(other, t0 + 20ms);
+			REQUIRE(self.cancel());
+		});
+
+		service.arm(self, t0 + 10ms, 10ms);
+		REQUIRE(1 == service.advance(t0 + 11ms));
+		REQUIRE(1 == service.advance(t0 + 21ms));
+		REQUIRE(0 == service.advance(t0 + 100ms));
+
+		REQUIRE(1 == n);
+		REQUIRE(1 == m);
+	}
+
+	SECTION("periodic timer is fired repeatedly") {
+		int  n = 0;
+		auto t = timer([&] { ++n; });
+
+		service.arm(t, t0 + 10ms, 10ms);
+		for(int i = 1; i <= 10; ++i) {
+			service.advance(t0 + i * 10ms + 1ms);
+			REQUIRE(i == n);
+		}
+
+		// Missed ticks are dropped.
+		service.advance(t0 + 1000ms);
+		REQUIRE(11 == n);
+	}
+
+	SECTION("a number of timers") {
+		constexpr std::size_t N = 100'000;
+
+		std::size_t n = 0;
+
+		std::vector<std::unique_ptr<timer<std::function<void()>>>> timers;
+		timers.reserve(N);
+		for(std::size_t i = 0; i < N; ++i) {
+			timers.emplace_back(std::make_unique<timer<std::function<void()>>>([&] { ++n; }));
+			service.arm(*timers.back(), t0 + std::chrono::milliseconds(i % 10'000));
+		}
+
+		for(std::size_t i = 0; i < N; i += 2) {
+			timers[i]->cancel();
+		}
+
+		service.advance(t0 + 10s);
+		REQUIRE(N / 2 == n);
+	}
+}
+
+TEST_CASE("timer_service::global") {
+	using lesomnus::channel::timer;
+	using lesomnus::channel::timer_service;
+
+	auto& service = timer_service::global();
+
+	std::atomic_bool fired = false;
+
+	auto t = timer([&] {
+		fired = true;
+		fired.notify_one();
+	});
+
+	auto const t0 = timer_service::clock::now();
+	service.arm(t, t0 + testing::ReasonableWaitingTime);
+
+	fired.wait(false);
+	auto const t1 = timer_service::clock::now();
+
+	REQUIRE(testing::ReasonableWaitingTime <= (t1 - t0));
+}
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <stop_token>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <lesomnus/channel/channel.hpp>
+#include <lesomnus/channel/detail/watcher.hpp>
+#include <lesomnus/channel/wait_set.hpp>
+
+#include "testing/constants.hpp"
+
+TEST_CASE("wait_set") {
+	using namespace lesomnus::channel;
+
+	auto chan1 = bounded_channel<int, 1>();
+	auto chan2 = bounded_channel<int, 0>();
+	auto chan3 = bounded_channel<int, 1>();
+
+	wait_set set;
+
+	auto const k1 = set.watch_recv(chan1);
+	auto const k2 = set.watch_recv(chan2);
+	auto const k3 = set.watch_send(chan3);
+
+	std::array<wait_set::key_type, 3> keys;
+
+	SECTION("reports the channel ready on registration") {
+		auto const n = set.try_wait(keys);
+		REQUIRE(1 == n);
+		REQUIRE(k3 == keys[0]);
+	}
+
+	SECTION("returns at once if there is no room for the keys") {
+		REQUIRE(0 == set.wait(std::span<wait_set::key_type>{}));
+	}
+
+	SECTION("reports the channel that becomes ready") {
+		REQUIRE(chan3.try_send(0));
+		REQUIRE(0 == set.try_wait(keys));
+
+		// Taken before the sender starts so its whole sleep is within the measured wait.
+		auto const t0     = std::chrono::steady_clock::now();
+		auto const sender = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			chan1.send(42);
+		});
+
+		auto const n  = set.wait(keys);
+		auto const t1 = std::chrono::steady_clock::now();
+		REQUIRE(testing::ReasonableWaitingTime <= (t1 - t0));
+		REQUIRE(1 == n);
+		REQUIRE(k1 == keys[0]);
+
+		int v = 0;
+		REQUIRE(chan1.try_recv(v));
+		REQUIRE(42 == v);
+
+		// Not ready anymore.
+		REQUIRE(0 == set.try_wait(keys));
+	}
+
+	SECTION("reports the channel again while it is ready") {
+		REQUIRE(chan1.try_send(42));
+
+		REQUIRE(2 == set.try_wait(keys));
+		REQUIRE(2 == set.try_wait(keys));
+
+		REQUIRE(chan3.try_send(0));
+		REQUIRE(1 == set.try_wait(keys));
+		REQUIRE(k1 == keys[0]);
+	}
+
+	SECTION("reports the channel on which a sender hangs") {
+		REQUIRE(chan3.try_send(0));
+		REQUIRE(0 == set.try_wait(keys));
+
+		auto const sender = std::jthread([&] { chan2.send(42); });
+
+		REQUIRE(1 == set.wait(keys));
+		REQUIRE(k2 == keys[0]);
+
+		int v = 0;
+		REQUIRE(chan2.try_recv(v));
+		REQUIRE(42 == v);
+	}
+
+	SECTION("reports the closed channel") {
+		REQUIRE(chan3.try_send(0));
+		chan2.close();
+
+		REQUIRE(1 == set.try_wait(keys));
+		REQUIRE(k2 == keys[0]);
+	}
+
+	SECTION("does not report the unwatched channel") {
+		set.unwatch(k3);
+		REQUIRE(0 == set.try_wait(keys));
+
+		set.unwatch(k1);
+		REQUIRE(chan1.try_send(42));
+		REQUIRE(0 == set.try_wait(keys));
+
+		// The key is reused.
+		REQUIRE(k1 == set.watch_recv(chan1));
+		REQUIRE(1 == set.try_wait(keys));
+		REQUIRE(k1 == keys[0]);
+	}
+
+	SECTION("unwatching twice frees the key once") {
+		set.unwatch(k3);
+		set.unwatch(k3);
+
+		auto const k4 = set.watch_send(chan3);
+		auto const k5 = set.watch_recv(chan1);
+		REQUIRE(k3 == k4);
+		REQUIRE(k4 != k5);
+
+		// Both registrations are reported along with `k1`.
+		REQUIRE(chan1.try_send(42));
+		REQUIRE(3 == set.try_wait(keys));
+		std::sort(keys.begin(), keys.end());
+		REQUIRE(std::ranges::includes(keys, std::array{std::min(k4, k5), std::max(k4, k5)}));
+	}
+
+	SECTION("wait is canceled") {
+		REQUIRE(chan3.try_send(0));
+
+		std::stop_source stop_source;
+
+		auto const canceler = std::jthread([&] {
+			std::this_thread::sleep_for(testing::ReasonableWaitingTime);
+			stop_source.request_stop();
+		});
+
+		REQUIRE(0 == set.wait(stop_source.get_token(), keys));
+	}
+
+	SECTION("wait is timed out") {
+		REQUIRE(chan3.try_send(0));
+		REQUIRE(0 == set.wait_for(testing::ReasonableWaitingTime, keys));
+	}
+}
+
+TEST_CASE("wait_set in a consumer loop") {
+	using namespace lesomnus::channel;
+
+	constexpr std::size_t NumChans  = 16;
+	constexpr int         NumValues = 1'000;
+
+	std::array<bounded_channel<int, 4>, NumChans> chans;
+
+	wait_set set;
+	for(auto& chan: chans) {
+		set.watch_recv(chan);
+	}
+
+	auto const producer = std::jthread([&] {
+		for(int i = 0; i < NumValues; ++i) {
+			chans[i % NumChans].send(i);
+		}
+	});
+
+	long long sum = 0;
+	int       n   = 0;
+
+	std::array<wait_set::key_type, NumChans> keys;
+	while(n < NumValues) {
+		auto const m = set.wait(keys);
+		for(std::size_t i = 0; i < m; ++i) {
+			int v = 0;
+			while(chans[keys[i]].try_recv(v)) {
+				sum += v;
+				++n;
+			}
+		}
+	}
+
+	REQUIRE(NumValues == n);
+	REQUIRE(static_cast<long long>(NumValues) * (NumValues - 1) / 2 == sum);
+}
+
+TEST_CASE("watcher_list") {
+	using namespace lesomnus::channel;
+
+	struct counter: detail::watcher {
+		int n = 0;
+
+		void notify() override {
+			++n;
+		}
+	};
+
+	counter w;
+
+	detail::watcher_list l1;
+	detail::watcher_list l2;
+
+	l1.push_back(w);
+	REQUIRE(l1.contains(w));
+	REQUIRE(!l2.contains(w));
+
+	// Belongs to the list it is registered in.
+	l2.notify_all();
+	REQUIRE(0 == w.n);
+	l1.notify_all();
+	REQUIRE(1 == w.n);
+
+	l1.erase(w);
+	REQUIRE(!l1.contains(w));
+	REQUIRE(l1.empty());
+
+	l2.push_back(w);
+	REQUIRE(l2.contains(w));
+	REQUIRE(!l1.contains(w));
+	l2.erase(w);
+	REQUIRE(l2.empty());
+}